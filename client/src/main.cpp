@@ -1,40 +1,347 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <iostream>
+#include <iterator>
 #include <string>
 #include <thread>
 #include <vector>
 #include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <numeric>
-#include <future>
 #include <sstream>
+#include <stdexcept>
 
 #include <boost/asio.hpp>
-#include <boost/archive/text_iarchive.hpp>
-#include <boost/archive/text_oarchive.hpp>
 
+#include "../../common/ChebyshevSurrogate.h"
+#include "../../common/CpuTopology.h"
 #include "../../common/DataStructures.h"
+#include "../../common/FairShareScheduler.h"
+#include "../../common/IntegrationKernels.h"
 #include "../../common/Logger.h"
+#include "../../common/ResultCache.h"
+#include "../../common/ThreadPool.h"
 #include "../../common/Utils.h"
 
+/// Префикс адреса сервера на этом узле, сообщения с которым идут через общую память: "shm:<путь сокета>"
+constexpr const char kSharedMemoryAddressPrefix[] = "shm:";
+
+/**
+ * @brief Сервер, которому клиент отдает часть вычислений.
+ */
+struct ServerEndpoint {
+    std::string host = "127.0.0.1";
+    unsigned short port = 12345;
+    std::string unix_path; ///< Путь сокета AF_UNIX сервера на этом узле (пусто - TCP)
+    /// Сообщения идут через общую память, а сокет AF_UNIX только контролирует связь
+    bool shared_memory = false;
+    double weight = 1.0;   ///< Вес доли сервера в общем пуле относительно других серверов
+
+    /**
+     * @brief Адрес сервера для журнала: "<адрес>:<порт>", "unix:<путь>" или "shm:<путь>".
+     */
+    std::string address() const {
+        if (unix_path.empty()) {
+            return host + ":" + std::to_string(port);
+        }
+        return (shared_memory ? kSharedMemoryAddressPrefix : kUnixAddressPrefix) + unix_path;
+    }
+};
+
+/**
+ * @brief Параметры запуска клиента.
+ */
+struct ClientOptions {
+    PinningMode pinning = PinningMode::None; ///< Закрепление потоков вычислений (--pin)
+    double capacity = 0.0;                   ///< Явная емкость в ядрах (--capacity, 0 - определить)
+    std::vector<ServerEndpoint> servers;     ///< Серверы (--server); пусто - 127.0.0.1:12345
+    size_t cache_entries = 4096;             ///< Предел кэша результатов (--cache, 0 - без кэша)
+    std::string cache_file;                  ///< Файл кэша результатов (--cache-file, пусто - только память)
+};
+
 /**
- * @brief Вычисляет значение функции 1/ln(x) для интегрирования.
+ * @brief Ход выполнения задачи; части задачи обновляют его, поток отправки читает.
+ */
+struct TaskProgress {
+    std::atomic<uint64_t> done{0};        ///< Выполненная работа (вычисления функции или части)
+    std::atomic<uint64_t> total{0};       ///< Вся работа задачи в тех же единицах
+    std::atomic<uint64_t> evaluations{0}; ///< Выполненные вычисления функции (методы с шагом)
+    std::atomic<double> partial_sum{0.0}; ///< Сумма готовых частей
+    std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+
+    void add(uint64_t work, uint64_t evals, double value) {
+        done += work;
+        evaluations += evals;
+        double current = partial_sum.load();
+        while (!partial_sum.compare_exchange_weak(current, current + value)) {
+        }
+    }
+};
+
+
+/**
+ * @brief Вычислительные ресурсы клиента, общие для всех серверов.
  * 
- * @param x Точка, в которой вычисляется функция.
- * @return Значение функции или 0.0 для особых случаев.
+ * Пул потоков создается один раз по емкости процессора и выполняет задачи
+ * всех серверов, поэтому клиент, обслуживающий несколько серверов, не
+ * занимает одни и те же ядра несколькими пулами. Одновременно выполняется
+ * не больше kTasksInFlight задач; места для них делятся между серверами по
+ * весам (см. FairShareScheduler).
  */
-double integrate_function(double x) {
-    if (x <= 1.0 || std::abs(std::log(x)) < 1e-10) {
-        // Обработка особых случаев для 1/ln(x) при x <= 1 или ln(x) близко к 0
-        // Возвращаем 0 для точек, где функция не определена
-        return 0.0; 
+class ComputeNode {
+public:
+    /**
+     * @brief Создает пул потоков и измеряет его производительность.
+     * 
+     * @param options Параметры запуска (закрепление потоков, емкость).
+     */
+    explicit ComputeNode(const ClientOptions& options) : scheduler_(kTasksInFlight) {
+        // Емкость учитывает маску процессоров и квоту cgroup: в контейнере это не число ядер хоста
+        const CpuCapacity capacity = detect_cpu_capacity(options.capacity);
+        LOG_INFO << "Емкость процессора: " << capacity.effective << " ядер (" << capacity.source
+                 << "; процессоров в маске " << capacity.affinity_cpus << ", квота cgroup "
+                 << (capacity.quota > 0.0 ? std::to_string(capacity.quota) : std::string("нет")) << ")";
+        const size_t workers = static_cast<size_t>(std::ceil(capacity.effective));
+
+        // При закреплении поток создается на каждый выбранный процессор, но не больше емкости
+        PinningMode pinning = options.pinning;
+        const std::vector<LogicalCpu> topology = detect_cpu_topology();
+        std::vector<int> cpus = plan_placement(topology, pinning);
+        if (pinning != PinningMode::None && cpus.empty()) {
+            LOG_WARNING << "Топология процессоров недоступна, потоки не закрепляются";
+            pinning = PinningMode::None;
+        }
+        if (cpus.size() > workers) {
+            cpus.resize(workers);
+        }
+        num_cores_ = cpus.empty() ? workers : cpus.size();
+        if (num_cores_ == 0) {
+            num_cores_ = 1; // Минимум одно ядро
+            LOG_WARNING << "Не удалось определить количество ядер, используем 1";
+        }
+        pool_ = std::make_unique<ThreadPool>(num_cores_, cpus);
+
+        if (options.cache_entries > 0) {
+            cache_ = std::make_unique<ResultCache>(options.cache_entries);
+            if (!options.cache_file.empty() && !cache_->open_file(options.cache_file)) {
+                LOG_WARNING << "Не удалось отобразить файл кэша " << options.cache_file
+                            << ", кэш результатов хранится только в памяти";
+            }
+            const ResultCacheStats stats = cache_->stats();
+            LOG_INFO << "Кэш результатов: до " << stats.capacity << " задач"
+                     << (stats.persistent ? ", файл " + options.cache_file : std::string()) << ", загружено "
+                     << stats.entries;
+        }
+
+        // Описание для серверов: количество ядер CPU, емкость, вариант ядра и размещение потоков
+        hello_ = ClientHello{num_cores_, kernels::kernel_isa_name()};
+        hello_.capacity = std::min(capacity.effective, static_cast<double>(num_cores_));
+        hello_.evals_per_sec = calibrate();
+        hello_.pinning = pinning_mode_name(pinning);
+        hello_.pinned_workers = pool_->pinned();
+        std::vector<LogicalCpu> used;
+        for (const LogicalCpu& entry : topology) {
+            if (cpus.empty() || std::find(cpus.begin(), cpus.end(), entry.cpu) != cpus.end()) {
+                used.push_back(entry);
+            }
+        }
+        hello_.numa_nodes = std::max<size_t>(count_numa_nodes(used), 1);
+
+        LOG_INFO << "Пул вычислений: " << num_cores_ << " потоков (емкость " << hello_.capacity
+                 << "), калибровка: " << hello_.evals_per_sec << " вычислений/с";
+        LOG_INFO << "Закрепление потоков: " << hello_.pinning << ", закреплено " << hello_.pinned_workers
+                 << " из " << num_cores_ << ", узлов NUMA: " << hello_.numa_nodes;
+    }
+
+    ComputeNode(const ComputeNode&) = delete;
+    ComputeNode& operator=(const ComputeNode&) = delete;
+
+    /**
+     * @brief Возвращает общий пул потоков.
+     */
+    ThreadPool& pool() {
+        return *pool_;
+    }
+
+    /**
+     * @brief Возвращает планировщик мест для задач в пуле.
+     */
+    FairShareScheduler& scheduler() {
+        return scheduler_;
+    }
+
+    /**
+     * @brief Возвращает кэш результатов задач (nullptr - кэш выключен).
+     */
+    ResultCache* cache() {
+        return cache_.get();
     }
-    return 1.0 / std::log(x);
-}
+
+    /**
+     * @brief Возвращает описание всего пула для сервера (емкость и калибровка - целиком).
+     */
+    const ClientHello& hello() const {
+        return hello_;
+    }
+
+    /**
+     * @brief Выполняет интегрирование задачи с использованием всех ядер CPU.
+     * 
+     * Разделяет задачу на kChunksPerCore частей на каждое ядро и выполняет их
+     * в пуле потоков: освободившиеся потоки забирают части у занятых, поэтому
+     * медленное ядро не задерживает всю задачу. Для методов с шагом части
+     * получают панели сетки задания с границами, кратными
+     * kernels::kReductionBlock, а их суммы складываются точно, поэтому
+     * результат не зависит ни от числа ядер, ни от того, какой поток выполнил
+     * какую часть. Для адаптивного метода допустимая абсолютная погрешность
+     * делится между частями пропорционально их длине. Для метода Чебышёва
+     * потоки используют общий кэш коэффициентов. При вычитании особенности
+     * вычисляется только интеграл гладкого остатка.
+     * 
+     * Признак отмены проверяется перед каждой частью, а в методах с шагом -
+     * еще и после каждых kCancelCheckEvaluations вычислений функции внутри
+     * части, поэтому отмененная задача освобождает потоки за миллисекунды.
+     * Результат отмененной задачи неполон.
+     * 
+     * @param task Задача интегрирования.
+     * @param token Признак отмены задачи.
+     * @param progress Ход выполнения: обновляется после каждого блока панелей или части.
+     * @return Результат интегрирования с точной суммой и оценкой погрешности.
+     */
+    IntegrationResult perform_integration(const IntegrationTask& task, const CancellationToken& token,
+                                          TaskProgress& progress) {
+        IntegrationResult total_result = {0.0, task.task_id, 0.0, ExactSum()};
+
+        double range_size = task.upper_bound - task.lower_bound;
+        if (range_size <= 0 || (method_uses_step(task.method) && task.step <= 0)) {
+            return total_result;
+        }
+
+        const size_t chunk_count = num_cores_ * kChunksPerCore;
+        std::vector<IntegrationResult> partials;
+        if (method_uses_step(task.method)) {
+            // Делим панели сетки задания на части; короткое задание даст меньше частей
+            uint64_t last_panel = task.last_panel > 0
+                                      ? task.last_panel
+                                      : kernels::grid_panels(task.lower_bound, task.upper_bound, task.step);
+            std::vector<uint64_t> bounds = kernels::split_panels(task.first_panel, last_panel, chunk_count);
+            partials.assign(bounds.size() - 1, IntegrationResult{0.0, task.task_id, 0.0, ExactSum()});
+
+            // Панелей между проверками отмены: кратно блоку свертки, чтобы сумма не зависела от проверок
+            const uint64_t task_panels = last_panel > task.first_panel ? last_panel - task.first_panel : 1;
+            const uint64_t nodes_per_panel = std::max<uint64_t>(kernels::task_evaluations(task) / task_panels, 1);
+            const uint64_t check_panels =
+                std::max<uint64_t>(kCancelCheckEvaluations / nodes_per_panel / kernels::kReductionBlock, 1) *
+                kernels::kReductionBlock;
+            progress.total = task_panels * nodes_per_panel;
+
+            pool_->parallel_for(partials.size(), [&](size_t i) {
+                // Накопитель на стеке потока: при закреплении он лежит на узле NUMA потока
+                ExactSum sum;
+                for (uint64_t first = bounds[i]; first < bounds[i + 1] && !token.cancelled();) {
+                    const uint64_t last = std::min(bounds[i + 1], (first / check_panels + 1) * check_panels);
+                    ExactSum piece;
+                    kernels::accumulate_task(task, first, last, piece);
+                    sum.add(piece);
+                    progress.add((last - first) * nodes_per_panel, (last - first) * nodes_per_panel, piece.round());
+                    first = last;
+                }
+                partials[i].sum = sum;
+            }, &token);
+        } else {
+            // Делим диапазон на равные поддиапазоны
+            double sub_range_length = range_size / chunk_count;
+            partials.assign(chunk_count, IntegrationResult{0.0, task.task_id, 0.0, ExactSum()});
+            progress.total = chunk_count;
+            pool_->parallel_for(chunk_count, [&](size_t i) {
+                double sub_lower_bound = task.lower_bound + i * sub_range_length;
+                double sub_upper_bound = (i == chunk_count - 1) ? task.upper_bound : sub_lower_bound + sub_range_length;
+                // Функция и ядро метода выбираются один раз на часть
+                kernels::Estimate estimate = kernels::integrate_task(task, sub_lower_bound, sub_upper_bound,
+                                                                     task.abs_tol / chunk_count);
+                partials[i] = IntegrationResult{estimate.value, task.task_id, estimate.error, ExactSum(estimate.value)};
+                progress.add(1, 0, estimate.value);
+            }, &token);
+        }
+
+        // Собираем результаты всех частей: суммы складываются без округления
+        for (const auto& partial : partials) {
+            total_result.sum.add(partial.sum);
+            total_result.error_estimate += partial.error_estimate;
+        }
+        total_result.result = total_result.sum.round();
+
+        return total_result;
+    }
+
+    /// Задач, одновременно выполняемых в пуле (всех серверов вместе)
+    static constexpr size_t kTasksInFlight = 2;
+
+private:
+    /**
+     * @brief Измеряет производительность клиента на рабочем ядре интегрирования.
+     * 
+     * Интегрирует 1/ln(x) методом прямоугольников в пуле потоков, пока не
+     * пройдет kCalibrationTime; первый проход не учитывается (прогрев кэшей
+     * и частоты). Так сервер видит не число ядер, а их реальную скорость:
+     * ядро 4 ГГц с AVX-512 весит больше ядра 2 ГГц с SSE2.
+     * 
+     * @return Вычислений функции в секунду на всех потоках.
+     */
+    double calibrate() {
+        IntegrationTask task;
+        task.lower_bound = 2.0;
+        task.step = 1e-3;
+        task.task_id = 0;
+        const uint64_t panels = num_cores_ * kChunksPerCore * kernels::kReductionBlock * 4;
+        task.upper_bound = task.lower_bound + static_cast<double>(panels) * task.step;
+        const std::vector<uint64_t> bounds = kernels::split_panels(0, panels, num_cores_ * kChunksPerCore);
+        auto run = [&]() {
+            pool_->parallel_for(bounds.size() - 1, [&](size_t i) {
+                ExactSum sum;
+                kernels::accumulate_task(task, bounds[i], bounds[i + 1], sum);
+            });
+        };
+
+        run();
+        uint64_t evaluations = 0;
+        const auto start = std::chrono::steady_clock::now();
+        std::chrono::duration<double> elapsed(0.0);
+        do {
+            run();
+            evaluations += kernels::task_evaluations(task);
+            elapsed = std::chrono::steady_clock::now() - start;
+        } while (elapsed < kCalibrationTime);
+        return static_cast<double>(evaluations) / elapsed.count();
+    }
+
+    /// Частей задачи на одно ядро: запас для перераспределения работы между потоками
+    static constexpr size_t kChunksPerCore = 8;
+    /// Вычислений функции между проверками отмены (около миллисекунды на ядро)
+    static constexpr uint64_t kCancelCheckEvaluations = 1u << 20;
+    /// Продолжительность калибровки при запуске
+    static constexpr std::chrono::milliseconds kCalibrationTime{50};
+
+    size_t num_cores_ = 0;
+    std::unique_ptr<ThreadPool> pool_; ///< Потоки вычислений, по одному на ядро
+    FairShareScheduler scheduler_;
+    std::unique_ptr<ResultCache> cache_; ///< Результаты повторяющихся задач всех серверов
+    ClientHello hello_;
+};
 
 /**
  * @brief Класс клиента для распределенного интегрирования.
  * 
- * Подключается к серверу, получает задачи и выполняет интегрирование
- * с использованием всех доступных ядер CPU.
+ * Подключается к серверу, получает задачи и выполняет интегрирование в
+ * общем пуле ComputeNode. Чтение задач, вычисления и отправка результатов
+ * идут в отдельных потоках: пока одна задача досчитывается, следующая уже
+ * принята и занимает освободившиеся ядра. Клиент, обслуживающий несколько
+ * серверов, создает по объекту Client на каждый сервер.
  */
 class Client {
 public:
@@ -42,133 +349,656 @@ public:
      * @brief Конструктор клиента.
      * 
      * @param io_context Контекст ввода-вывода Boost.Asio.
-     * @param host Адрес сервера.
-     * @param port Порт сервера.
-     */
-    Client(boost::asio::io_context& io_context, const std::string& host, short port)
-        : socket_(io_context) {
-        LOG_INFO << "Клиент пытается подключиться к " << host << ":" << port;
-        boost::asio::ip::tcp::resolver resolver(io_context);
-        boost::asio::connect(socket_, resolver.resolve(host, std::to_string(port)));
+     * @param server Адрес сервера и вес его доли.
+     * @param node Общий пул потоков; должен пережить клиента.
+     * @param share Доля сервера в весах всех серверов, (0, 1]: в ней сообщаются емкость и калибровка.
+     */
+    Client(boost::asio::io_context& io_context, const ServerEndpoint& server, ComputeNode& node, double share)
+        : socket_(io_context), channel_(socket_), work_guard_(boost::asio::make_work_guard(io_context)), node_(node),
+          share_(node.scheduler().add_share(server.weight)) {
+        LOG_INFO << "Клиент пытается подключиться к " << server.address();
+        if (server.unix_path.empty()) {
+            boost::asio::ip::tcp::socket socket(io_context);
+            boost::asio::ip::tcp::resolver resolver(io_context);
+            boost::asio::connect(socket, resolver.resolve(server.host, std::to_string(server.port)));
+            socket_ = std::move(socket);
+        } else {
+#if defined(BOOST_ASIO_HAS_LOCAL_SOCKETS)
+            boost::asio::local::stream_protocol::socket socket(io_context);
+            socket.connect(boost::asio::local::stream_protocol::endpoint(server.unix_path));
+            socket_ = std::move(socket);
+#else
+            throw std::runtime_error("сокеты AF_UNIX не поддерживаются на этой платформе");
+#endif
+        }
+        configure_socket(socket_);
         LOG_INFO << "Клиент подключен к серверу.";
 
         try {
             // Получаем ID клиента от сервера
-            receive_data(socket_, client_id_);
-            
-            // Отправляем серверу количество ядер CPU
-            num_cores_ = std::thread::hardware_concurrency();
-            if (num_cores_ == 0) {
-                num_cores_ = 1; // Минимум одно ядро
-                LOG_WARNING << "Не удалось определить количество ядер, используем 1";
+            const wire::Envelope welcome = channel_.receive(wire::MessageType::Welcome, client_id_);
+
+            // Сервер видит только свою долю емкости и производительности общего пула
+            ClientHello hello = node_.hello();
+            hello.capacity *= share;
+            hello.evals_per_sec *= share;
+            hello.heartbeat_ms = static_cast<unsigned>(kReportInterval.count());
+            std::unique_ptr<SharedMemoryTransport> transport;
+            if (server.shared_memory) {
+                transport = offer_shared_memory(welcome);
+                if (transport) {
+                    hello.shared_memory = transport->name();
+                }
+            }
+            channel_.send(wire::make_envelope(wire::MessageType::Hello), hello);
+            if (transport) {
+                size_t accepted = 0;
+                channel_.receive(wire::MessageType::SharedMemory, accepted);
+                if (accepted != 0) {
+                    LOG_INFO << "Сообщения с сервером идут через общую память " << transport->name();
+                    channel_.use_shared_memory(std::move(transport));
+                } else {
+                    LOG_WARNING << "Сервер не подключил общую память, сообщения идут через сокет";
+                }
             }
-            send_data(socket_, num_cores_);
             
-            LOG_INFO << "Клиент " << client_id_ << " получил ID сессии. Количество ядер CPU: " << num_cores_;
+            LOG_INFO << "Клиент " << client_id_ << " получил ID сессии сервера " << server.address()
+                     << ". Количество ядер CPU: " << hello.num_cores << " (емкость " << hello.capacity
+                     << ", вес " << server.weight << "), вычислительное ядро: " << hello.isa
+                     << ", калибровка: " << hello.evals_per_sec << " вычислений/с";
         } catch (const std::exception& e) {
             LOG_ERROR << "Ошибка при подключении к серверу: " << e.what();
             throw;
         }
 
-        // Начинаем асинхронное чтение задач
+        // Начинаем асинхронную отправку результатов, вычисления и чтение задач
+        do_write_result();
+        for (size_t i = 0; i < ComputeNode::kTasksInFlight; ++i) {
+            do_execute_task();
+        }
         do_read_task();
     }
 
+    /**
+     * @brief Дожидается завершения потоков чтения, вычислений и отправки.
+     */
+    ~Client() {
+        for (auto& thread : threads_) {
+            if (thread.joinable()) {
+                thread.join();
+            }
+        }
+    }
+
 private:
     /**
-     * @brief Асинхронно читает задачи от сервера.
+     * @brief Выполняющаяся задача, ее признак отмены и ход выполнения.
+     */
+    struct ActiveTask {
+        size_t job_id;
+        std::shared_ptr<CancellationToken> token;
+        std::shared_ptr<TaskProgress> progress;
+    };
+
+    /**
+     * @brief Готовый результат и запрос сервера, к которому он относится.
+     */
+    struct ReadyResult {
+        size_t job_id;
+        IntegrationResult result;
+        bool failed = false; ///< Задача не выполнена: серверу уходит TaskFailed с номером задачи
+    };
+
+    /**
+     * @brief Создает сегмент общей памяти, который клиент предложит серверу.
+     * 
+     * @param welcome Конверт приветствия сервера: по нему видна версия протокола.
+     * @return Сегмент или nullptr, если сервер старый или сегмент не создан (тогда обмен идет через сокет).
+     */
+    static std::unique_ptr<SharedMemoryTransport> offer_shared_memory(const wire::Envelope& welcome) {
+        if (welcome.protocol < wire::kSharedMemoryProtocolVersion) {
+            LOG_WARNING << "Сервер не поддерживает общую память (протокол " << welcome.protocol
+                        << "), сообщения идут через сокет";
+            return nullptr;
+        }
+        try {
+            return SharedMemoryTransport::create(kSharedMemoryRingSize);
+        } catch (const std::exception& e) {
+            LOG_WARNING << "Не удалось создать сегмент общей памяти: " << e.what();
+            return nullptr;
+        }
+    }
+
+    /**
+     * @brief Асинхронно читает задачи и отмены от сервера.
+     * 
+     * Задачи принимаются в локальную очередь сразу, не дожидаясь окончания
+     * вычислений, поэтому следующая задача не ждет пересылки по сети.
      */
     void do_read_task() {
         // Используем отдельный поток для синхронного чтения
-        std::thread([this]() {
+        threads_.emplace_back([this]() {
+            // Отмена обрабатывается сразу при чтении, а задачи встают в очередь
+            wire::Dispatcher dispatcher;
+            dispatcher.on<CancelRequest>(wire::MessageType::Cancel,
+                [this](const wire::Envelope&, CancelRequest& cancel) { handle_cancel(cancel); });
+            dispatcher.on<IntegrationTask>(wire::MessageType::Task,
+                [this](const wire::Envelope&, IntegrationTask& task) {
+                    single_task_.resize(1);
+                    single_task_.front() = std::move(task);
+                    accept_tasks(single_task_);
+                });
+            dispatcher.on<std::vector<IntegrationTask>>(wire::MessageType::TaskBatch,
+                [this](const wire::Envelope& envelope, std::vector<IntegrationTask>& tasks) {
+                    LOG_INFO << "Клиент " << client_id_ << " получил пачку задач запроса " << envelope.correlation_id
+                             << ": " << tasks.size();
+                    accept_tasks(tasks);
+                });
+
             try {
+                wire::Envelope envelope;
                 while (true) {
-                    IntegrationTask task;
-                    receive_data(socket_, task);
+                    if (!channel_.receive(dispatcher, envelope)) {
+                        LOG_DEBUG << "Сообщение типа " << static_cast<unsigned>(envelope.type)
+                                  << " от сервера пропущено";
+                    }
+                }
+            } catch (const std::exception& e) {
+                LOG_INFO << "Сервер клиента " << client_id_ << " отключился: " << e.what();
+            }
+            // Принятые задачи досчитываются, после чего потоки вычислений завершаются
+            std::lock_guard<std::mutex> lock(tasks_mutex_);
+            reading_done_ = true;
+            tasks_cv_.notify_all();
+        });
+    }
+
+    /**
+     * @brief Ставит принятые задачи в очередь одной блокировкой.
+     * 
+     * Повторные поддиапазоны отвечаются сразу из кэша, без очереди и пула.
+     * Вызывается только потоком чтения.
+     * 
+     * @param tasks Задачи; содержимое перемещается.
+     */
+    void accept_tasks(std::vector<IntegrationTask>& tasks) {
+        std::vector<IntegrationTask>& queued = queued_tasks_;
+        std::vector<ReadyResult>& cached = cached_results_;
+        queued.clear();
+        cached.clear();
+        for (IntegrationTask& task : tasks) {
+            LOG_INFO << "Клиент " << client_id_ << " получил задачу " << task.task_id
+                     << ": [" << task.lower_bound << ", " << task.upper_bound << "] с шагом " << task.step
+                     << ", метод " << static_cast<unsigned>(task.method)
+                     << ", функция " << kernels::integrand_info(task.integrand).name
+                     << (task.principal_value ? " (вычитание особенности)" : "");
+            if (task.last_panel > 0) {
+                LOG_INFO << "Панели сетки задания: [" << task.first_panel << ", " << task.last_panel << ")";
+            }
 
-                    LOG_INFO << "Клиент " << client_id_ << " получил задачу " << task.task_id
-                             << ": [" << task.lower_bound << ", " << task.upper_bound << "] с шагом " << task.step;
+            IntegrationResult result;
+            if (node_.cache() != nullptr && node_.cache()->lookup(task, result)) {
+                LOG_INFO << "Результат задачи " << task.task_id << " взят из кэша";
+                cached.push_back(ReadyResult{task.job_id, std::move(result)});
+            } else {
+                queued.push_back(std::move(task));
+            }
+        }
 
-                    // Выполняем интегрирование в нескольких потоках
-                    double partial_result = perform_integration(task);
+        if (!cached.empty()) {
+            std::lock_guard<std::mutex> lock(results_mutex_);
+            std::move(cached.begin(), cached.end(), std::back_inserter(results_));
+            results_cv_.notify_one();
+        }
+        if (!queued.empty()) {
+            std::lock_guard<std::mutex> lock(tasks_mutex_);
+            std::move(queued.begin(), queued.end(), std::back_inserter(tasks_));
+            tasks_cv_.notify_all();
+        }
+    }
 
-                    // Отправляем результат обратно на сервер
-                    IntegrationResult result = {partial_result, task.task_id};
-                    send_data(socket_, result);
+    /**
+     * @brief Запускает поток, выполняющий задачи из очереди.
+     * 
+     * Таких потоков ComputeNode::kTasksInFlight: их задачи одновременно
+     * выполняются в общем пуле, и хвост одной задачи перекрывается началом
+     * следующей. Перед выполнением поток ждет места в общем пуле: места
+     * делятся между серверами по весам. Результаты ставятся в очередь
+     * отправки в порядке готовности, а не в порядке приема.
+     */
+    void do_execute_task() {
+        threads_.emplace_back([this]() {
+            while (true) {
+                {
+                    std::unique_lock<std::mutex> lock(tasks_mutex_);
+                    tasks_cv_.wait(lock, [this] { return !tasks_.empty() || reading_done_; });
+                    if (tasks_.empty()) {
+                        break;
+                    }
+                }
 
-                    LOG_INFO << "Клиент " << client_id_ << " отправил результат " << result.task_id 
-                             << ": " << result.result;
+                // Задача берется из очереди только после получения места, поэтому до
+                // начала выполнения ее по-прежнему можно отменить
+                node_.scheduler().acquire(share_);
+                IntegrationTask task;
+                auto token = std::make_shared<CancellationToken>();
+                auto progress = std::make_shared<TaskProgress>();
+                {
+                    std::lock_guard<std::mutex> lock(tasks_mutex_);
+                    if (!tasks_.empty()) {
+                        task = std::move(tasks_.front());
+                        tasks_.pop_front();
+                        active_[task.task_id] = ActiveTask{task.job_id, token, progress};
+                    } else {
+                        token.reset();
+                    }
                 }
-            } catch (const std::exception& e) {
-                LOG_INFO << "Сервер отключился: " << e.what();
+                if (!token) {
+                    // Задачу забрал другой поток или ее отменили, пока поток ждал места
+                    node_.scheduler().release(share_, 0.0);
+                    continue;
+                }
+
+                // Выполняем интегрирование в нескольких потоках
+                IntegrationResult result;
+                bool failed = false;
+                try {
+                    result = node_.perform_integration(task, *token, *progress);
+                } catch (const std::exception& e) {
+                    LOG_ERROR << "Ошибка при выполнении задачи " << task.task_id << ": " << e.what();
+                    failed = true;
+                }
+                bool idle = false;
+                {
+                    std::lock_guard<std::mutex> lock(tasks_mutex_);
+                    active_.erase(task.task_id);
+                    idle = tasks_.empty() && active_.empty();
+                }
+                // Доля сервера расходуется временем выполнения его задач
+                node_.scheduler().release(share_, std::chrono::duration<double>(
+                                                      std::chrono::steady_clock::now() - progress->started).count());
+                if (failed && !token->cancelled()) {
+                    // Сервер передаст задачу другому клиенту; без ответа он ждал бы ее вечно,
+                    // ведь heartbeat показывает, что клиент на связи
+                    std::lock_guard<std::mutex> lock(results_mutex_);
+                    IntegrationResult failure{0.0, task.task_id, 0.0, ExactSum()};
+                    results_.push_back(ReadyResult{task.job_id, std::move(failure), true});
+                    flush_now_ = true;
+                    results_cv_.notify_one();
+                    continue;
+                }
+                if (token->cancelled()) {
+                    // Результат отмененной задачи серверу не нужен
+                    LOG_INFO << "Задача " << task.task_id << " отменена, результат не отправляется";
+                    continue;
+                }
+                LOG_DEBUG << "Заданий украдено потоками пула с запуска: " << node_.pool().steals();
+                if (node_.cache() != nullptr) {
+                    node_.cache()->store(task, result);
+                    const ResultCacheStats stats = node_.cache()->stats();
+                    LOG_INFO << "Кэш результатов: попаданий " << stats.hits << ", промахов " << stats.misses
+                             << ", задач " << stats.entries << "/" << stats.capacity;
+                }
+                if (task.method == IntegrationMethod::Chebyshev) {
+                    chebyshev::CacheStats stats = chebyshev::SurrogateCache::shared(
+                        task.integrand, kernels::resolve_params(task.integrand, task.params))->stats();
+                    LOG_INFO << "Кэш коэффициентов Чебышёва: попаданий " << stats.hits
+                             << ", промахов " << stats.misses << ", ячеек " << stats.cells;
+                }
+
+                std::lock_guard<std::mutex> lock(results_mutex_);
+                results_.push_back(ReadyResult{task.job_id, std::move(result)});
+                // Больше результатов не ожидается: пачка отправляется, не дожидаясь порога
+                flush_now_ = flush_now_ || idle;
+                results_cv_.notify_one();
+            }
+
+            // Последний поток вычислений закрывает очередь отправки
+            std::lock_guard<std::mutex> lock(results_mutex_);
+            if (++executors_done_ == ComputeNode::kTasksInFlight) {
+                results_cv_.notify_all();
             }
-        }).detach();
+        });
     }
 
     /**
-     * @brief Выполняет интегрирование задачи с использованием всех ядер CPU.
+     * @brief Отменяет задачу или все задачи запроса.
      * 
-     * Разделяет задачу на подзадачи по количеству ядер и выполняет их параллельно.
+     * Задачи из очереди удаляются, у выполняющихся задач взводится признак
+     * отмены: их части проверяют его между блоками панелей и завершаются за
+     * миллисекунды, освобождая потоки пула.
      * 
-     * @param task Задача интегрирования.
-     * @return Результат интегрирования.
+     * @param cancel Запрос отмены от сервера.
      */
-    double perform_integration(const IntegrationTask& task) {
-        double total_result = 0.0;
-        std::vector<std::future<double>> futures;
-
-        double range_size = task.upper_bound - task.lower_bound;
-        if (range_size <= 0 || task.step <= 0) {
-            return 0.0;
+    void handle_cancel(const CancelRequest& cancel) {
+        auto matches = [&cancel](size_t task_id, size_t job_id) {
+            return cancel.whole_job ? job_id == cancel.job_id : task_id == cancel.task_id;
+        };
+        size_t dropped = 0;
+        size_t interrupted = 0;
+        {
+            std::lock_guard<std::mutex> lock(tasks_mutex_);
+            for (auto it = tasks_.begin(); it != tasks_.end();) {
+                if (matches(it->task_id, it->job_id)) {
+                    it = tasks_.erase(it);
+                    ++dropped;
+                } else {
+                    ++it;
+                }
+            }
+            for (auto& pair : active_) {
+                if (matches(pair.first, pair.second.job_id)) {
+                    pair.second.token->cancel();
+                    ++interrupted;
+                }
+            }
         }
+        LOG_INFO << "Отмена " << (cancel.whole_job ? "запроса " : "задачи ")
+                 << (cancel.whole_job ? cancel.job_id : cancel.task_id) << ": удалено из очереди " << dropped
+                 << ", прервано " << interrupted;
+    }
 
-        // Делим диапазон на поддиапазоны по количеству ядер
-        double sub_range_length = range_size / num_cores_;
-
-        // Создаем задачи для каждого ядра
-        for (size_t i = 0; i < num_cores_; ++i) {
-            double sub_lower_bound = task.lower_bound + i * sub_range_length;
-            double sub_upper_bound = (i == num_cores_ - 1) ? task.upper_bound : sub_lower_bound + sub_range_length;
+    /**
+     * @brief Асинхронно отправляет серверу готовые результаты и отчеты о ходе задач.
+     * 
+     * В сокет пишет только этот поток; чтение задач идет параллельно в потоке
+     * do_read_task(). Каждые kReportInterval отправляются отчеты о
+     * выполняющихся задачах, а если задач нет - heartbeat: по ним сервер
+     * оценивает время до завершения, находит отстающие задачи и замечает
+     * пропавших клиентов. Результаты отправляются пачками: по набору
+     * kResultBatchSize, через kResultFlushInterval после первого результата
+     * пачки или сразу, когда выполнять больше нечего.
+     */
+    void do_write_result() {
+        threads_.emplace_back([this]() {
+            auto next_report = std::chrono::steady_clock::now() + kReportInterval;
+            while (true) {
+                // Отчет и готовые результаты уходят одной записью в сокет: отчет
+                // первым, затем пачка результатов каждого запроса. Очередь
+                // обменивается с буфером потока, поэтому оба вектора сохраняют емкость
+                bool finished = false;
+                {
+                    std::unique_lock<std::mutex> lock(results_mutex_);
+                    auto done = [this] { return executors_done_ == ComputeNode::kTasksInFlight; };
+                    results_cv_.wait_until(lock, next_report, [this, &done] { return !results_.empty() || done(); });
+                    // Пачка копится до kResultBatchSize результатов, но не дольше kResultFlushInterval
+                    const auto flush_at = std::min(next_report, std::chrono::steady_clock::now() + kResultFlushInterval);
+                    results_cv_.wait_until(lock, flush_at, [this, &done] {
+                        return results_.size() >= kResultBatchSize || flush_now_ || done();
+                    });
+                    flush_now_ = false;
+                    sending_.clear();
+                    sending_.swap(results_);
+                    finished = done();
+                }
+                bool queued = false;
+                if (std::chrono::steady_clock::now() >= next_report) {
+                    queue_report();
+                    next_report = std::chrono::steady_clock::now() + kReportInterval;
+                    queued = true;
+                }
+                // Порядок результатов внутри запроса не важен, а std::sort, в отличие от
+                // std::stable_sort, не выделяет временный буфер
+                std::sort(sending_.begin(), sending_.end(),
+                          [](const ReadyResult& a, const ReadyResult& b) { return a.job_id < b.job_id; });
+                for (size_t first = 0; first < sending_.size();) {
+                    const size_t job_id = sending_[first].job_id;
+                    batch_.clear();
+                    for (; first < sending_.size() && sending_[first].job_id == job_id; ++first) {
+                        if (sending_[first].failed) {
+                            channel_.queue(wire::make_envelope(wire::MessageType::TaskFailed, job_id),
+                                           sending_[first].result.task_id);
+                        } else {
+                            batch_.push_back(sending_[first].result);
+                        }
+                    }
+                    if (!batch_.empty()) {
+                        channel_.queue(wire::make_envelope(wire::MessageType::ResultBatch, job_id), batch_);
+                    }
+                    queued = true;
+                }
 
-            // Запускаем вычисление в отдельном потоке
-            futures.push_back(std::async(std::launch::async, [sub_lower_bound, sub_upper_bound, task]() {
-                double sub_integral = 0.0;
-                double x = sub_lower_bound;
-                
-                // Используем метод прямоугольников для интегрирования
-                while (x < sub_upper_bound) {
-                    double next_x = std::min(x + task.step, sub_upper_bound);
-                    double mid_x = (x + next_x) / 2.0;
-                    sub_integral += integrate_function(mid_x) * (next_x - x);
-                    x = next_x;
+                // Отправляем результаты обратно на сервер
+                if (queued && flush()) {
+                    for (const ReadyResult& ready : sending_) {
+                        if (ready.failed) {
+                            LOG_WARNING << "Клиент " << client_id_ << " сообщил серверу, что задача "
+                                        << ready.result.task_id << " не выполнена";
+                            continue;
+                        }
+                        LOG_INFO << "Клиент " << client_id_ << " отправил результат " << ready.result.task_id << ": "
+                                 << ready.result.result << " (погрешность " << ready.result.error_estimate << ")";
+                    }
+                }
+                if (finished) {
+                    break;
                 }
-                
-                return sub_integral;
-            }));
+            }
+            // Отпускаем io_context, чтобы main() завершился после отключения
+            work_guard_.reset();
+        });
+    }
+
+    /**
+     * @brief Отправляет серверу накопленные сообщения из потока отправки.
+     * 
+     * @return false, если отправка не удалась (соединение при этом закрывается).
+     */
+    bool flush() {
+        try {
+            channel_.flush();
+            return true;
+        } catch (const std::exception& e) {
+            // Закрываем соединение, чтобы поток чтения тоже завершился
+            LOG_ERROR << "Ошибка при отправке сообщения серверу: " << e.what();
+            channel_.shutdown();
+            return false;
         }
+    }
 
-        // Собираем результаты от всех потоков
-        for (auto& future : futures) {
-            total_result += future.get();
+    /**
+     * @brief Ставит в очередь отправки отчет о выполняющихся задачах или heartbeat, если их нет.
+     */
+    void queue_report() {
+        reports_.clear();
+        {
+            std::lock_guard<std::mutex> lock(tasks_mutex_);
+            collect_progress(reports_);
         }
+        if (reports_.empty()) {
+            channel_.queue(wire::make_envelope(wire::MessageType::Heartbeat), wire::Empty{});
+        } else {
+            channel_.queue(wire::make_envelope(wire::MessageType::Progress), reports_);
+        }
+    }
 
-        return total_result;
+    /**
+     * @brief Составляет отчеты о выполняющихся задачах (под tasks_mutex_).
+     */
+    void collect_progress(std::vector<ProgressReport>& reports) const {
+        const auto now = std::chrono::steady_clock::now();
+        for (const auto& pair : active_) {
+            const TaskProgress& progress = *pair.second.progress;
+            ProgressReport report;
+            report.task_id = pair.first;
+            report.job_id = pair.second.job_id;
+            const uint64_t total = progress.total.load();
+            report.fraction = total > 0 ? std::min(1.0, static_cast<double>(progress.done.load()) / total) : 0.0;
+            report.partial_sum = progress.partial_sum.load();
+            report.elapsed_seconds = std::chrono::duration<double>(now - progress.started).count();
+            report.evals_per_sec =
+                report.elapsed_seconds > 0.0 ? progress.evaluations.load() / report.elapsed_seconds : 0.0;
+            reports.push_back(report);
+        }
     }
 
-    boost::asio::ip::tcp::socket socket_;
+    /// Период отчетов о ходе задач и heartbeat
+    static constexpr std::chrono::milliseconds kReportInterval{500};
+    /// Результатов в пачке, после которых она отправляется сразу
+    static constexpr size_t kResultBatchSize = 64;
+    /// Наибольшая задержка результата ради пачки
+    static constexpr std::chrono::milliseconds kResultFlushInterval{5};
+    /// Размер кольца общей памяти каждого направления
+    static constexpr size_t kSharedMemoryRingSize = SharedMemoryTransport::kDefaultRingSize;
+
+    MessageSocket socket_;
+    /// Буферы сообщений соединения: пишет поток отправки, читает поток чтения
+    MessageChannel channel_;
+    /// Удерживает io_context.run() до отключения сервера
+    boost::asio::executor_work_guard<boost::asio::io_context::executor_type> work_guard_;
     size_t client_id_;
-    size_t num_cores_;
+    ComputeNode& node_; ///< Общий пул потоков всех серверов
+    size_t share_;      ///< Номер доли сервера в планировщике общего пула
+
+    // Принятые и еще не начатые задачи, выполняющиеся задачи (под tasks_mutex_)
+    std::deque<IntegrationTask> tasks_;
+    std::map<size_t, ActiveTask> active_;
+    std::mutex tasks_mutex_;
+    std::condition_variable tasks_cv_;
+    bool reading_done_ = false;
+
+    // Буферы потока чтения, переиспользуемые между сообщениями
+    std::vector<IntegrationTask> single_task_;
+    std::vector<IntegrationTask> queued_tasks_;
+    std::vector<ReadyResult> cached_results_;
+
+    // Буферы потока отправки, переиспользуемые между сообщениями
+    std::vector<ReadyResult> sending_;
+    std::vector<IntegrationResult> batch_;
+    std::vector<ProgressReport> reports_;
+
+    // Готовые и еще не отправленные результаты
+    std::vector<ReadyResult> results_;
+    std::mutex results_mutex_;
+    std::condition_variable results_cv_;
+    size_t executors_done_ = 0;
+    bool flush_now_ = false; ///< Очередь задач опустела: пачку не нужно копить
+
+    std::vector<std::thread> threads_; ///< Потоки чтения, вычислений и отправки
 };
 
-int main() {
+/**
+ * @brief Разбирает адрес сервера вида "<адрес>:<порт>[,<вес>]", "unix:<путь>[,<вес>]" или "shm:<путь>[,<вес>]".
+ * 
+ * "shm:" подключается к сокету AF_UNIX сервера и переводит сообщения в общую память.
+ * 
+ * @param text Адрес сервера.
+ * @param server Результат разбора; вес по умолчанию 1.
+ * @return false, если адрес, порт или вес некорректны.
+ */
+bool parse_server_endpoint(const std::string& text, ServerEndpoint& server) {
+    const std::size_t comma = text.find(',');
+    const std::string address = text.substr(0, comma);
+    const std::string unix_prefix = kUnixAddressPrefix;
+    const std::string shm_prefix = kSharedMemoryAddressPrefix;
+    const bool shared_memory = address.compare(0, shm_prefix.size(), shm_prefix) == 0;
+    const std::string& prefix = shared_memory ? shm_prefix : unix_prefix;
+    const bool local = shared_memory || address.compare(0, unix_prefix.size(), unix_prefix) == 0;
+    const std::size_t colon = address.rfind(':');
+    if (local ? address.size() == prefix.size() : colon == std::string::npos || colon == 0) {
+        return false;
+    }
+    try {
+        const int port = local ? 0 : std::stoi(address.substr(colon + 1));
+        const double weight = comma == std::string::npos ? 1.0 : std::stod(text.substr(comma + 1));
+        if ((!local && (port <= 0 || port > 65535)) || !(weight > 0.0)) {
+            return false;
+        }
+        if (local) {
+            server.unix_path = address.substr(prefix.size());
+            server.shared_memory = shared_memory;
+        } else {
+            server.host = address.substr(0, colon);
+            server.port = static_cast<unsigned short>(port);
+        }
+        server.weight = weight;
+        return true;
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+int main(int argc, char* argv[]) {
     init_logging();
     LOG_INFO << "Приложение клиента запущено.";
+    LOG_INFO << "Вариант вычислительного ядра: " << kernels::kernel_isa_name();
+
+    // Параметры запуска: --pin=none|threads|cores, --capacity=<ядер>, --server=<адрес>:<порт>[,<вес>]
+    // или --server=unix|shm:<путь>[,<вес>], --cache=<задач>, --cache-file=<путь>
+    ClientOptions options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const std::string pin_prefix = "--pin=";
+        const std::string capacity_prefix = "--capacity=";
+        const std::string server_prefix = "--server=";
+        const std::string cache_prefix = "--cache=";
+        const std::string cache_file_prefix = "--cache-file=";
+        if (arg.compare(0, cache_file_prefix.size(), cache_file_prefix) == 0 &&
+            arg.size() > cache_file_prefix.size()) {
+            options.cache_file = arg.substr(cache_file_prefix.size());
+            continue;
+        }
+        if (arg.compare(0, cache_prefix.size(), cache_prefix) == 0) {
+            try {
+                const long long entries = std::stoll(arg.substr(cache_prefix.size()));
+                if (entries >= 0) {
+                    options.cache_entries = static_cast<size_t>(entries);
+                    continue;
+                }
+            } catch (const std::exception&) {
+            }
+        }
+        if (arg.compare(0, pin_prefix.size(), pin_prefix) == 0 &&
+            parse_pinning_mode(arg.substr(pin_prefix.size()), options.pinning)) {
+            continue;
+        }
+        if (arg.compare(0, server_prefix.size(), server_prefix) == 0) {
+            ServerEndpoint server;
+            if (parse_server_endpoint(arg.substr(server_prefix.size()), server)) {
+                options.servers.push_back(server);
+                continue;
+            }
+        }
+        if (arg.compare(0, capacity_prefix.size(), capacity_prefix) == 0) {
+            try {
+                options.capacity = std::stod(arg.substr(capacity_prefix.size()));
+                if (options.capacity > 0.0) {
+                    continue;
+                }
+            } catch (const std::exception&) {
+            }
+            options.capacity = 0.0;
+        }
+        LOG_WARNING << "Неизвестный параметр запуска: " << arg
+                    << " (допустимо --pin=none|threads|cores, --capacity=<ядер> > 0, "
+                    << "--server=<адрес>:<порт>[,<вес> > 0] или unix|shm:<путь>[,<вес> > 0], --cache=<задач> >= 0, "
+                    << "--cache-file=<путь>)";
+    }
+    if (options.servers.empty()) {
+        options.servers.push_back(ServerEndpoint());
+    }
+    double total_weight = 0.0;
+    for (const ServerEndpoint& server : options.servers) {
+        total_weight += server.weight;
+    }
 
     try {
         boost::asio::io_context io_context;
-        Client client(io_context, "127.0.0.1", 12345);
+        // Пул создается до подключений и переживает их: объекты Client разрушаются раньше
+        ComputeNode node(options);
+        std::vector<std::unique_ptr<Client>> clients;
+        for (const ServerEndpoint& server : options.servers) {
+            try {
+                clients.push_back(std::make_unique<Client>(io_context, server, node, server.weight / total_weight));
+            } catch (const std::exception& e) {
+                LOG_ERROR << "Сервер " << server.address() << " недоступен: " << e.what();
+            }
+        }
+        if (clients.empty()) {
+            throw std::runtime_error("не удалось подключиться ни к одному серверу");
+        }
         
-        // Запускаем io_context (будет работать до закрытия соединения)
+        // Запускаем io_context (будет работать до закрытия всех соединений)
         io_context.run();
     } catch (std::exception& e) {
         LOG_FATAL << "Исключение в приложении клиента: " << e.what();
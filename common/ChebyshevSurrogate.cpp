@@ -0,0 +1,247 @@
+#include "ChebyshevSurrogate.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+
+namespace chebyshev {
+
+namespace {
+
+/// Предел глубины деления ячейки относительно начального уровня.
+constexpr int kMaxDepth = 64;
+
+/// Ячейка уже этой доли своего правого края больше не делится.
+constexpr double kMinRelativeWidth = 0x1p-44;
+
+/// Индексы ячеек должны точно представляться в double.
+constexpr double kMaxIndex = 0x1p53;
+
+constexpr double kPi = 3.14159265358979323846;
+
+/**
+ * @brief Таблица cos(π m / N), m = 0..2N-1, для дискретного косинус-преобразования.
+ */
+const std::array<double, 2 * kDegree>& cos_table() {
+    static const std::array<double, 2 * kDegree> table = [] {
+        std::array<double, 2 * kDegree> values{};
+        for (std::size_t m = 0; m < values.size(); ++m) {
+            values[m] = std::cos(kPi * static_cast<double>(m) / static_cast<double>(kDegree));
+        }
+        return values;
+    }();
+    return table;
+}
+
+/**
+ * @brief Вычисляет Σ c_m T_m(t) по схеме Кленшоу.
+ */
+template<std::size_t N>
+double clenshaw(const std::array<double, N>& c, double t) {
+    double b1 = 0.0;
+    double b2 = 0.0;
+    for (std::size_t m = N - 1; m >= 1; --m) {
+        double b0 = 2.0 * t * b1 - b2 + c[m];
+        b2 = b1;
+        b1 = b0;
+    }
+    return c[0] + t * b1 - b2;
+}
+
+} // namespace
+
+SurrogateCache::SurrogateCache(IntegrandId integrand, const IntegrandParams& params, std::size_t max_cells)
+    : integrand_(integrand),
+      params_(params),
+      domain_start_(kernels::integrand_info(integrand).domain_start),
+      max_cells_(max_cells) {}
+
+std::shared_ptr<SurrogateCache> SurrogateCache::shared(IntegrandId integrand, const IntegrandParams& params) {
+    struct Entry {
+        std::shared_ptr<SurrogateCache> cache;
+        uint64_t last_used = 0;
+    };
+    static std::mutex mutex;
+    static std::map<std::pair<IntegrandId, IntegrandParams>, Entry> caches;
+    static uint64_t clock = 0;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = caches.find({integrand, params});
+    if (it == caches.end()) {
+        if (caches.size() >= kMaxSharedCaches) {
+            auto oldest = std::min_element(caches.begin(), caches.end(), [](const auto& a, const auto& b) {
+                return a.second.last_used < b.second.last_used;
+            });
+            caches.erase(oldest);
+        }
+        it = caches.emplace(std::make_pair(integrand, params),
+                            Entry{std::make_shared<SurrogateCache>(integrand, params), 0}).first;
+    }
+    it->second.last_used = ++clock;
+    return it->second.cache;
+}
+
+CacheStats SurrogateCache::stats() const {
+    CacheStats result;
+    result.hits = hits_.load(std::memory_order_relaxed);
+    result.misses = misses_.load(std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(mutex_);
+    result.cells = cells_.size();
+    return result;
+}
+
+void SurrogateCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    cells_.clear();
+}
+
+SurrogateCache::Cell SurrogateCache::fit(int level, int64_t index) const {
+    Cell cell;
+    const double width = std::ldexp(1.0, level);
+    // Левее области определения функция считается нулевой, поэтому ячейку,
+    // содержащую ее границу, аппроксимируем только на правой части
+    cell.lower = std::max(static_cast<double>(index) * width, domain_start_);
+    cell.upper = static_cast<double>(index + 1) * width;
+
+    const double center = 0.5 * (cell.lower + cell.upper);
+    const double half = 0.5 * (cell.upper - cell.lower);
+    const auto& cosines = cos_table();
+
+    std::array<double, kDegree + 1> x;
+    std::array<double, kDegree + 1> f;
+    for (std::size_t k = 0; k <= kDegree; ++k) {
+        x[k] = center + half * cosines[k];
+    }
+    x[kDegree] = cell.lower;
+    x[0] = cell.upper;
+    kernels::integrand_values(integrand_, params_, x.data(), f.data(), x.size());
+
+    // a_n = (2/N) Σ'' f_k cos(π n k / N); крайние слагаемые и крайние коэффициенты делятся пополам
+    for (std::size_t n = 0; n <= kDegree; ++n) {
+        double sum = 0.5 * (f[0] + ((n % 2 == 0) ? f[kDegree] : -f[kDegree]));
+        for (std::size_t k = 1; k < kDegree; ++k) {
+            sum += f[k] * cosines[(n * k) % (2 * kDegree)];
+        }
+        double coefficient = sum * 2.0 / static_cast<double>(kDegree);
+        if (n == 0 || n == kDegree) {
+            coefficient *= 0.5;
+        }
+        cell.coefficients[n] = coefficient;
+        cell.scale = std::max(cell.scale, std::abs(coefficient));
+    }
+    cell.tail = std::max(std::abs(cell.coefficients[kDegree - 1]), std::abs(cell.coefficients[kDegree]));
+
+    // ∫[-1, 1] T_n dt = 2 / (1 - n^2) для четных n и 0 для нечетных
+    double integral = 0.0;
+    for (std::size_t n = 0; n <= kDegree; n += 2) {
+        integral += cell.coefficients[n] * 2.0 / (1.0 - static_cast<double>(n * n));
+    }
+    cell.integral = integral * half;
+    return cell;
+}
+
+double SurrogateCache::integrate_part(const Cell& cell, double lower_bound, double upper_bound) {
+    if (lower_bound <= cell.lower && upper_bound >= cell.upper) {
+        return cell.integral;
+    }
+    // Первообразная ряда: A_1 = a_0 - a_2 / 2, A_m = (a_{m-1} - a_{m+1}) / (2m)
+    const auto& a = cell.coefficients;
+    std::array<double, kDegree + 2> primitive{};
+    primitive[1] = a[0] - 0.5 * a[2];
+    for (std::size_t m = 2; m <= kDegree + 1; ++m) {
+        double next = (m + 1 <= kDegree) ? a[m + 1] : 0.0;
+        primitive[m] = (a[m - 1] - next) / (2.0 * static_cast<double>(m));
+    }
+
+    const double center = 0.5 * (cell.lower + cell.upper);
+    const double half = 0.5 * (cell.upper - cell.lower);
+    const double t0 = (std::max(lower_bound, cell.lower) - center) / half;
+    const double t1 = (std::min(upper_bound, cell.upper) - center) / half;
+    return (clenshaw(primitive, t1) - clenshaw(primitive, t0)) * half;
+}
+
+SurrogateCache::Cell SurrogateCache::lookup(int level, int64_t index) {
+    const Key key{level, index};
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = cells_.find(key);
+        if (it != cells_.end()) {
+            hits_.fetch_add(1, std::memory_order_relaxed);
+            return it->second;
+        }
+    }
+
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    Cell cell = fit(level, index);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (cells_.size() >= max_cells_) {
+        cells_.clear();
+    }
+    cells_.emplace(key, cell);
+    return cell;
+}
+
+void SurrogateCache::integrate_cell(int level, int64_t index, int depth, double lower_bound, double upper_bound,
+                                    double rel_tol, kernels::Estimate& total) {
+    const double width = std::ldexp(1.0, level);
+    const double cell_lower = static_cast<double>(index) * width;
+    const double cell_upper = static_cast<double>(index + 1) * width;
+    if (cell_upper <= domain_start_ || cell_upper <= lower_bound || cell_lower >= upper_bound) {
+        return;
+    }
+
+    const Cell cell = lookup(level, index);
+    const bool converged = cell.tail <= rel_tol * cell.scale;
+    const bool splittable = depth < kMaxDepth && width > kMinRelativeWidth * cell_upper;
+    if (!converged && splittable) {
+        integrate_cell(level - 1, 2 * index, depth + 1, lower_bound, upper_bound, rel_tol, total);
+        integrate_cell(level - 1, 2 * index + 1, depth + 1, lower_bound, upper_bound, rel_tol, total);
+        return;
+    }
+
+    const double part = integrate_part(cell, lower_bound, upper_bound);
+    const double length = std::min(upper_bound, cell.upper) - std::max(lower_bound, cell.lower);
+    total.value += part;
+    // Хвост ряда убывает геометрически, отброшенная часть порядка последних коэффициентов;
+    // плюс округление при суммировании kDegree слагаемых
+    total.error += length * (2.0 * cell.tail +
+                             static_cast<double>(kDegree) * std::numeric_limits<double>::epsilon() * cell.scale);
+}
+
+kernels::Estimate SurrogateCache::integrate(double lower_bound, double upper_bound, double rel_tol) {
+    if (!(rel_tol > 0)) {
+        rel_tol = kDefaultRelTol;
+    }
+    lower_bound = std::max(lower_bound, domain_start_);
+    if (!(upper_bound > lower_bound)) {
+        return kernels::Estimate{};
+    }
+
+    // Начальный уровень: ячейка не уже диапазона, поэтому его покрывают одна-две ячейки
+    const int level = std::ilogb(upper_bound - lower_bound) + 1;
+    const double width = std::ldexp(1.0, level);
+    if (std::max(std::abs(lower_bound), std::abs(upper_bound)) / width >= kMaxIndex) {
+        // Диапазон слишком узок относительно своего положения для двоичной сетки
+        IntegrationTask task;
+        task.lower_bound = lower_bound;
+        task.upper_bound = upper_bound;
+        task.step = 0.0;
+        task.task_id = 0;
+        task.method = IntegrationMethod::AdaptiveGaussKronrod;
+        task.rel_tol = rel_tol;
+        task.integrand = integrand_;
+        task.params.assign(params_.begin(), params_.end());
+        return kernels::integrate_task(task, lower_bound, upper_bound, 0.0);
+    }
+
+    kernels::Estimate total;
+    const auto first = static_cast<int64_t>(std::floor(lower_bound / width));
+    const auto last = static_cast<int64_t>(std::ceil(upper_bound / width));
+    for (int64_t index = first; index < last; ++index) {
+        integrate_cell(level, index, 0, lower_bound, upper_bound, rel_tol, total);
+    }
+    return total;
+}
+
+} // namespace chebyshev
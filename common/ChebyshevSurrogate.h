@@ -0,0 +1,129 @@
+#pragma once
+
+#include "IntegrationKernels.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+/**
+ * @brief Кусочно-полиномиальная аппроксимация подынтегральной функции рядами Чебышёва.
+ *
+ * Ось x делится на двоичные ячейки [j * 2^k, (j + 1) * 2^k]. На каждой ячейке
+ * функция интерполируется в точках Чебышёва-Лобатто полиномом степени kDegree,
+ * после чего интеграл по любой части ячейки берется аналитически по
+ * первообразной ряда. Ячейка, где хвост ряда не убывает до допуска, делится
+ * пополам. Границы ячеек не зависят от границ задачи, поэтому коэффициенты,
+ * однажды вычисленные, переиспользуются повторными и перекрывающимися задачами.
+ */
+namespace chebyshev {
+
+/// Степень полинома на ячейке (число узлов интерполяции kDegree + 1).
+constexpr std::size_t kDegree = 32;
+
+/// Относительный допуск хвоста ряда по умолчанию.
+constexpr double kDefaultRelTol = 1e-14;
+
+/// Предел числа ячеек в кэше; при переполнении кэш очищается целиком.
+constexpr std::size_t kDefaultMaxCells = 1 << 16;
+
+/// Предел числа общих кэшей (наборов параметров функций): давно не использованный кэш удаляется.
+constexpr std::size_t kMaxSharedCaches = 16;
+
+/**
+ * @brief Счетчики кэша коэффициентов.
+ */
+struct CacheStats {
+    std::size_t hits = 0;   ///< Ячейки, взятые из кэша
+    std::size_t misses = 0; ///< Ячейки, аппроксимированные заново
+    std::size_t cells = 0;  ///< Ячеек в кэше сейчас
+};
+
+/**
+ * @brief Кэш коэффициентов Чебышёва, общий для всех потоков процесса.
+ *
+ * Аппроксимация ячейки выполняется без блокировки, под мьютексом только
+ * поиск и вставка в словарь.
+ */
+class SurrogateCache {
+public:
+    /**
+     * @brief Конструктор.
+     *
+     * @param integrand Аппроксимируемая функция.
+     * @param params Параметры функции.
+     * @param max_cells Предел числа ячеек в кэше.
+     */
+    explicit SurrogateCache(IntegrandId integrand = IntegrandId::InvLog, const IntegrandParams& params = {},
+                            std::size_t max_cells = kDefaultMaxCells);
+
+    /**
+     * @brief Интегрирует функцию по [lower_bound, upper_bound] через аппроксимацию.
+     *
+     * Точки левее области определения функции дают нулевой вклад, как и в остальных методах.
+     *
+     * @param lower_bound Нижний предел интегрирования.
+     * @param upper_bound Верхний предел интегрирования.
+     * @param rel_tol Допуск хвоста ряда относительно максимума коэффициентов (0 - kDefaultRelTol).
+     * @return Значение интеграла и оценка погрешности.
+     */
+    kernels::Estimate integrate(double lower_bound, double upper_bound, double rel_tol = kDefaultRelTol);
+
+    /**
+     * @brief Возвращает счетчики попаданий и промахов.
+     */
+    CacheStats stats() const;
+
+    /**
+     * @brief Удаляет все ячейки (счетчики сохраняются).
+     */
+    void clear();
+
+    /**
+     * @brief Кэш функции с заданными параметрами, общий для процесса
+     * (используется методом IntegrationMethod::Chebyshev).
+     *
+     * Параметры приходят от сервера, поэтому общих кэшей не больше
+     * kMaxSharedCaches: при переполнении удаляется давно не использованный.
+     * Удаленный кэш живет, пока его держат выполняющиеся задачи.
+     */
+    static std::shared_ptr<SurrogateCache> shared(IntegrandId integrand = IntegrandId::InvLog,
+                                                  const IntegrandParams& params = {});
+
+private:
+    /**
+     * @brief Коэффициенты одной ячейки: f(x) ≈ Σ a_n T_n(t), t ∈ [-1, 1].
+     */
+    struct Cell {
+        double lower = 0.0;    ///< Левый край области аппроксимации
+        double upper = 0.0;    ///< Правый край области аппроксимации
+        std::array<double, kDegree + 1> coefficients{}; ///< Коэффициенты a_n
+        double integral = 0.0; ///< Интеграл по всей области
+        double tail = 0.0;     ///< max(|a_{N-1}|, |a_N|)
+        double scale = 0.0;    ///< max |a_n|
+    };
+
+    using Key = std::pair<int, int64_t>; ///< (k, j): ячейка [j * 2^k, (j + 1) * 2^k]
+
+    Cell lookup(int level, int64_t index);
+    Cell fit(int level, int64_t index) const;
+    static double integrate_part(const Cell& cell, double lower_bound, double upper_bound);
+    void integrate_cell(int level, int64_t index, int depth, double lower_bound, double upper_bound,
+                        double rel_tol, kernels::Estimate& total);
+
+    const IntegrandId integrand_;
+    const IntegrandParams params_;
+    const double domain_start_;
+    const std::size_t max_cells_;
+    mutable std::mutex mutex_;
+    std::map<Key, Cell> cells_;
+    std::atomic<std::size_t> hits_{0};
+    std::atomic<std::size_t> misses_{0};
+};
+
+} // namespace chebyshev
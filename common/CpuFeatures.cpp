@@ -0,0 +1,98 @@
+#include "CpuFeatures.h"
+
+#include <cstdint>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#include <immintrin.h>
+#define CPU_FEATURES_X86 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#define CPU_FEATURES_X86 1
+#endif
+
+namespace {
+
+#if defined(CPU_FEATURES_X86)
+/**
+ * @brief Выполняет cpuid для заданного листа и подлиста.
+ */
+void cpuid(uint32_t leaf, uint32_t subleaf, uint32_t regs[4]) {
+#if defined(_MSC_VER)
+    int out[4];
+    __cpuidex(out, static_cast<int>(leaf), static_cast<int>(subleaf));
+    for (int i = 0; i < 4; ++i) {
+        regs[i] = static_cast<uint32_t>(out[i]);
+    }
+#else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+/**
+ * @brief Читает регистр XCR0: какие векторные регистры сохраняет ОС.
+ */
+uint64_t read_xcr0() {
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    uint32_t lo = 0;
+    uint32_t hi = 0;
+    __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return (static_cast<uint64_t>(hi) << 32) | lo;
+#endif
+}
+#endif
+
+} // namespace
+
+CpuFeatures detect_cpu_features() {
+    CpuFeatures features;
+#if defined(CPU_FEATURES_X86)
+    uint32_t regs[4] = {0, 0, 0, 0};
+    cpuid(0, 0, regs);
+    const uint32_t max_leaf = regs[0];
+
+    cpuid(1, 0, regs);
+    features.sse2 = (regs[3] & (1u << 26)) != 0;
+    const bool osxsave = (regs[2] & (1u << 27)) != 0;
+    const bool avx = (regs[2] & (1u << 28)) != 0;
+    const bool fma = (regs[2] & (1u << 12)) != 0;
+
+    // Без OSXSAVE ОС не сохраняет YMM/ZMM при переключении контекста
+    const uint64_t xcr0 = osxsave ? read_xcr0() : 0;
+    const bool ymm_enabled = (xcr0 & 0x6) == 0x6;
+    const bool zmm_enabled = (xcr0 & 0xE6) == 0xE6;
+
+    if (max_leaf >= 7) {
+        cpuid(7, 0, regs);
+        features.avx2 = avx && ymm_enabled && (regs[1] & (1u << 5)) != 0;
+        features.avx512f = zmm_enabled && (regs[1] & (1u << 16)) != 0;
+    }
+    features.fma = fma && ymm_enabled;
+#endif
+    return features;
+}
+
+IsaLevel best_isa_level(const CpuFeatures& features) {
+    if (features.avx512f && features.avx2 && features.fma) {
+        return IsaLevel::Avx512;
+    }
+    if (features.avx2 && features.fma) {
+        return IsaLevel::Avx2;
+    }
+    if (features.sse2) {
+        return IsaLevel::Sse2;
+    }
+    return IsaLevel::Scalar;
+}
+
+const char* isa_level_name(IsaLevel level) {
+    switch (level) {
+        case IsaLevel::Avx512: return "avx512";
+        case IsaLevel::Avx2:   return "avx2";
+        case IsaLevel::Sse2:   return "sse2";
+        case IsaLevel::Scalar: break;
+    }
+    return "scalar";
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+/**
+ * @brief Уровень набора векторных инструкций, которым собран вариант ядра.
+ *
+ * Значения упорядочены по возрастанию ширины вектора.
+ */
+enum class IsaLevel {
+    Scalar = 0, ///< Без SIMD
+    Sse2 = 1,   ///< 2 x double
+    Avx2 = 2,   ///< 4 x double, AVX2 + FMA
+    Avx512 = 3  ///< 8 x double, AVX-512F
+};
+
+/**
+ * @brief Возможности процессора, важные для выбора варианта ядра.
+ */
+struct CpuFeatures {
+    bool sse2 = false;    ///< Поддержка SSE2
+    bool avx2 = false;    ///< Поддержка AVX2 (и сохранение YMM операционной системой)
+    bool fma = false;     ///< Поддержка FMA3
+    bool avx512f = false; ///< Поддержка AVX-512F (и сохранение ZMM операционной системой)
+};
+
+/**
+ * @brief Определяет возможности текущего процессора через cpuid/xgetbv.
+ *
+ * @return Набор поддерживаемых расширений.
+ */
+CpuFeatures detect_cpu_features();
+
+/**
+ * @brief Выбирает наиболее широкий уровень инструкций, поддерживаемый процессором.
+ *
+ * @param features Возможности процессора.
+ * @return Лучший доступный уровень.
+ */
+IsaLevel best_isa_level(const CpuFeatures& features);
+
+/**
+ * @brief Возвращает текстовое имя уровня инструкций ("scalar", "sse2", "avx2", "avx512").
+ */
+const char* isa_level_name(IsaLevel level);
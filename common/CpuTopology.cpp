@@ -0,0 +1,342 @@
+#include "CpuTopology.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include <thread>
+
+namespace {
+
+#if defined(__linux__)
+/**
+ * @brief Читает целое число из файла sysfs.
+ *
+ * @return false, если файла нет или он не содержит числа.
+ */
+bool read_int(const std::string& path, int& value) {
+    std::ifstream file(path);
+    return static_cast<bool>(file >> value);
+}
+
+/**
+ * @brief Разбирает список процессоров вида "0-3,8,10-11".
+ */
+std::vector<int> parse_cpu_list(const std::string& list) {
+    std::vector<int> cpus;
+    std::stringstream stream(list);
+    std::string range;
+    while (std::getline(stream, range, ',')) {
+        const std::size_t dash = range.find('-');
+        try {
+            const int first = std::stoi(range.substr(0, dash));
+            const int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+            for (int cpu = first; cpu <= last; ++cpu) {
+                cpus.push_back(cpu);
+            }
+        } catch (const std::exception&) {
+            // Пустой или поврежденный фрагмент списка пропускается
+        }
+    }
+    return cpus;
+}
+
+/**
+ * @brief Точка монтирования иерархии cgroup.
+ */
+struct CgroupMount {
+    std::string root;       ///< Каталог иерархии, смонтированный в mount_point
+    std::string mount_point;
+};
+
+/**
+ * @brief Разбивает строку по разделителю.
+ */
+std::vector<std::string> split(const std::string& text, char delimiter) {
+    std::vector<std::string> parts;
+    std::stringstream stream(text);
+    std::string part;
+    while (std::getline(stream, part, delimiter)) {
+        parts.push_back(part);
+    }
+    return parts;
+}
+
+/**
+ * @brief Находит в mountinfo точки монтирования cgroup v2 и контроллера cpu cgroup v1.
+ */
+void find_cgroup_mounts(const std::string& root, CgroupMount& v2, CgroupMount& v1) {
+    std::ifstream file(root + "/proc/self/mountinfo");
+    std::string line;
+    while (std::getline(file, line)) {
+        // id parent major:minor root mount_point options [поля...] - fstype source super_options
+        const std::vector<std::string> fields = split(line, ' ');
+        const auto separator = std::find(fields.begin(), fields.end(), "-");
+        if (fields.size() < 5 || separator == fields.end() || fields.end() - separator < 4) {
+            continue;
+        }
+        const std::string& fstype = *(separator + 1);
+        if (fstype == "cgroup2" && v2.mount_point.empty()) {
+            v2 = CgroupMount{fields[3], root + fields[4]};
+        } else if (fstype == "cgroup" && v1.mount_point.empty()) {
+            const std::vector<std::string> options = split(*(separator + 3), ',');
+            if (std::find(options.begin(), options.end(), "cpu") != options.end()) {
+                v1 = CgroupMount{fields[3], root + fields[4]};
+            }
+        }
+    }
+}
+
+/**
+ * @brief Переводит путь группы из /proc/self/cgroup в каталог внутри точки монтирования.
+ */
+std::string cgroup_directory(const CgroupMount& mount, std::string path) {
+    if (mount.root != "/" && path.compare(0, mount.root.size(), mount.root) == 0) {
+        path = path.substr(mount.root.size());
+    }
+    while (!path.empty() && path.back() == '/') {
+        path.pop_back();
+    }
+    return mount.mount_point + path;
+}
+
+/**
+ * @brief Наименьшая квота CPU (в ядрах) группы и ее предков до точки монтирования.
+ *
+ * @param read_quota Читает квоту одного каталога; 0 - не ограничена.
+ * @return 0, если ни одна группа не ограничена.
+ */
+template<class ReadQuota>
+double min_quota(const CgroupMount& mount, const std::string& directory, ReadQuota read_quota) {
+    double quota = 0.0;
+    std::string current = directory;
+    while (true) {
+        const double level = read_quota(current);
+        if (level > 0.0 && (quota == 0.0 || level < quota)) {
+            quota = level;
+        }
+        if (current.size() <= mount.mount_point.size()) {
+            break;
+        }
+        current = current.substr(0, current.rfind('/'));
+    }
+    return quota;
+}
+
+/**
+ * @brief Квота cgroup v2 из cpu.max ("max 100000" или "150000 100000").
+ */
+double read_cpu_max(const std::string& directory) {
+    std::ifstream file(directory + "/cpu.max");
+    std::string limit;
+    double period = 0.0;
+    if (!(file >> limit >> period) || limit == "max" || period <= 0.0) {
+        return 0.0;
+    }
+    try {
+        return std::stod(limit) / period;
+    } catch (const std::exception&) {
+        return 0.0;
+    }
+}
+
+/**
+ * @brief Квота cgroup v1 из cpu.cfs_quota_us и cpu.cfs_period_us (-1 - не ограничена).
+ */
+double read_cfs_quota(const std::string& directory) {
+    std::ifstream quota_file(directory + "/cpu.cfs_quota_us");
+    std::ifstream period_file(directory + "/cpu.cfs_period_us");
+    double quota = 0.0;
+    double period = 0.0;
+    if (!(quota_file >> quota) || !(period_file >> period) || quota <= 0.0 || period <= 0.0) {
+        return 0.0;
+    }
+    return quota / period;
+}
+
+/**
+ * @brief Квота CPU процесса по всем иерархиям cgroup, в ядрах (0 - не ограничена).
+ */
+double detect_cgroup_quota(const std::string& root) {
+    CgroupMount v2;
+    CgroupMount v1;
+    find_cgroup_mounts(root, v2, v1);
+
+    double quota = 0.0;
+    auto tighten = [&quota](double level) {
+        if (level > 0.0 && (quota == 0.0 || level < quota)) {
+            quota = level;
+        }
+    };
+
+    // Строки /proc/self/cgroup: "0::/путь" для v2, "N:cpu,cpuacct:/путь" для v1
+    std::ifstream file(root + "/proc/self/cgroup");
+    std::string line;
+    while (std::getline(file, line)) {
+        const std::size_t first = line.find(':');
+        const std::size_t second = line.find(':', first + 1);
+        if (first == std::string::npos || second == std::string::npos) {
+            continue;
+        }
+        const std::vector<std::string> controllers = split(line.substr(first + 1, second - first - 1), ',');
+        const std::string path = line.substr(second + 1);
+        if (controllers.empty() && !v2.mount_point.empty()) {
+            tighten(min_quota(v2, cgroup_directory(v2, path), read_cpu_max));
+        } else if (std::find(controllers.begin(), controllers.end(), "cpu") != controllers.end() &&
+                   !v1.mount_point.empty()) {
+            tighten(min_quota(v1, cgroup_directory(v1, path), read_cfs_quota));
+        }
+    }
+    return quota;
+}
+#endif
+
+} // namespace
+
+std::vector<LogicalCpu> detect_cpu_topology() {
+    std::vector<LogicalCpu> topology;
+#if defined(__linux__)
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+        return topology;
+    }
+
+    // Узел NUMA каждого процессора; без sysfs узлов все процессоры считаются узлом 0
+    std::vector<std::pair<int, int>> cpu_nodes;
+    for (int node = 0;; ++node) {
+        std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        if (!file) {
+            break;
+        }
+        std::string list;
+        std::getline(file, list);
+        for (int cpu : parse_cpu_list(list)) {
+            cpu_nodes.emplace_back(cpu, node);
+        }
+    }
+
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (!CPU_ISSET(cpu, &allowed)) {
+            continue;
+        }
+        const std::string base = "/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/";
+        LogicalCpu entry;
+        entry.cpu = cpu;
+        if (!read_int(base + "core_id", entry.core)) {
+            entry.core = cpu; // Без сведений о топологии каждый CPU - отдельное ядро
+        }
+        if (!read_int(base + "physical_package_id", entry.package)) {
+            entry.package = 0;
+        }
+        for (const auto& cpu_node : cpu_nodes) {
+            if (cpu_node.first == cpu) {
+                entry.node = cpu_node.second;
+            }
+        }
+        topology.push_back(entry);
+    }
+
+    std::sort(topology.begin(), topology.end(), [](const LogicalCpu& a, const LogicalCpu& b) {
+        return std::tie(a.node, a.package, a.core, a.cpu) < std::tie(b.node, b.package, b.core, b.cpu);
+    });
+#endif
+    return topology;
+}
+
+CpuCapacity detect_cpu_capacity(double override_capacity, const std::string& root) {
+    CpuCapacity capacity;
+#if defined(__linux__)
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0) {
+        capacity.affinity_cpus = static_cast<size_t>(CPU_COUNT(&allowed));
+    }
+    capacity.quota = detect_cgroup_quota(root);
+#else
+    (void)root;
+#endif
+
+    if (override_capacity > 0.0) {
+        capacity.effective = override_capacity;
+        capacity.source = "override";
+    } else if (capacity.quota > 0.0 && (capacity.affinity_cpus == 0 || capacity.quota < capacity.affinity_cpus)) {
+        capacity.effective = capacity.quota;
+        capacity.source = "cgroup";
+    } else if (capacity.affinity_cpus > 0) {
+        capacity.effective = static_cast<double>(capacity.affinity_cpus);
+        capacity.source = "affinity";
+    } else {
+        capacity.effective = std::max(1u, std::thread::hardware_concurrency());
+        capacity.source = "hardware";
+    }
+    return capacity;
+}
+
+std::vector<int> plan_placement(const std::vector<LogicalCpu>& topology, PinningMode mode) {
+    std::vector<int> cpus;
+    if (mode == PinningMode::None) {
+        return cpus;
+    }
+    std::set<std::pair<int, int>> seen_cores;
+    for (const LogicalCpu& entry : topology) {
+        // Процессоры упорядочены по ядру, поэтому первым встречается младший по номеру из SMT-соседей
+        if (mode == PinningMode::Cores && !seen_cores.insert({entry.package, entry.core}).second) {
+            continue;
+        }
+        cpus.push_back(entry.cpu);
+    }
+    return cpus;
+}
+
+size_t count_numa_nodes(const std::vector<LogicalCpu>& topology) {
+    std::set<int> nodes;
+    for (const LogicalCpu& entry : topology) {
+        nodes.insert(entry.node);
+    }
+    return nodes.size();
+}
+
+bool pin_current_thread(int cpu) {
+#if defined(__linux__)
+    if (cpu < 0 || cpu >= CPU_SETSIZE) {
+        return false;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+const char* pinning_mode_name(PinningMode mode) {
+    switch (mode) {
+        case PinningMode::Threads: return "threads";
+        case PinningMode::Cores: return "cores";
+        case PinningMode::None: break;
+    }
+    return "none";
+}
+
+bool parse_pinning_mode(const std::string& name, PinningMode& mode) {
+    for (PinningMode candidate : {PinningMode::None, PinningMode::Threads, PinningMode::Cores}) {
+        if (name == pinning_mode_name(candidate)) {
+            mode = candidate;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Режим закрепления потоков вычислений за процессорами.
+ */
+enum class PinningMode {
+    None = 0,    ///< Потоки не закрепляются, планировщик переносит их свободно
+    Threads = 1, ///< Поток на каждый логический CPU, включая SMT-соседей
+    Cores = 2    ///< Поток на каждое физическое ядро, SMT-соседи пропускаются
+};
+
+/**
+ * @brief Логический процессор и его место в топологии машины.
+ */
+struct LogicalCpu {
+    int cpu = 0;     ///< Номер логического CPU в системе
+    int core = 0;    ///< Номер физического ядра внутри пакета
+    int package = 0; ///< Номер процессорного пакета (сокета)
+    int node = 0;    ///< Узел NUMA
+};
+
+/**
+ * @brief Вычислительная емкость, доступная процессу.
+ */
+struct CpuCapacity {
+    double effective = 1.0;   ///< Эффективная емкость в ядрах (может быть дробной)
+    size_t affinity_cpus = 0; ///< Процессоров в маске sched_getaffinity (0 - неизвестно)
+    double quota = 0.0;       ///< Квота CPU из cgroup в ядрах (0 - не ограничена)
+    std::string source;       ///< Чем определена емкость: "override", "cgroup", "affinity", "hardware"
+};
+
+/**
+ * @brief Определяет логические процессоры, доступные процессу.
+ *
+ * В Linux топология читается из /sys/devices/system/cpu и
+ * /sys/devices/system/node, учитываются только процессоры из маски
+ * sched_getaffinity. На других системах возвращается пустой список.
+ *
+ * @return Процессоры, упорядоченные по узлу NUMA, пакету и ядру.
+ */
+std::vector<LogicalCpu> detect_cpu_topology();
+
+/**
+ * @brief Определяет эффективную емкость процессора с учетом ограничений контейнера.
+ *
+ * Емкость - меньшее из числа процессоров в маске sched_getaffinity и квоты
+ * cgroup: cpu.max (cgroup v2) или cpu.cfs_quota_us / cpu.cfs_period_us
+ * (cgroup v1) группы процесса и всех ее предков. Точки монтирования берутся
+ * из /proc/self/mountinfo, группа процесса - из /proc/self/cgroup. Квота
+ * 150000/100000 дает емкость 1.5: поток на каждое ядро хоста в таком
+ * контейнере лишь простаивает в ожидании квоты.
+ *
+ * @param override_capacity Явно заданная емкость; при > 0 заменяет найденную.
+ * @param root Префикс путей /proc и /sys (для тестов); пустой - корень системы.
+ * @return Емкость и ее составляющие.
+ */
+CpuCapacity detect_cpu_capacity(double override_capacity = 0.0, const std::string& root = "");
+
+/**
+ * @brief Выбирает процессоры для потоков вычислений.
+ *
+ * Соседние потоки получают соседние ядра одного узла NUMA, поэтому кража
+ * работы у соседа (см. ThreadPool) остается внутри узла.
+ *
+ * @param topology Доступные процессоры (результат detect_cpu_topology()).
+ * @param mode Режим закрепления.
+ * @return Номера логических CPU по одному на поток; пусто для PinningMode::None.
+ */
+std::vector<int> plan_placement(const std::vector<LogicalCpu>& topology, PinningMode mode);
+
+/**
+ * @brief Возвращает число различных узлов NUMA среди процессоров.
+ */
+size_t count_numa_nodes(const std::vector<LogicalCpu>& topology);
+
+/**
+ * @brief Закрепляет вызывающий поток за логическим CPU.
+ *
+ * @param cpu Номер логического CPU.
+ * @return false, если закрепление не поддерживается или не удалось.
+ */
+bool pin_current_thread(int cpu);
+
+/**
+ * @brief Возвращает текстовое имя режима ("none", "threads", "cores").
+ */
+const char* pinning_mode_name(PinningMode mode);
+
+/**
+ * @brief Разбирает имя режима закрепления.
+ *
+ * @param name Имя режима ("none", "threads", "cores").
+ * @param mode Результат разбора.
+ * @return false, если имя не распознано.
+ */
+bool parse_pinning_mode(const std::string& name, PinningMode& mode);
@@ -1,48 +1,147 @@
 #pragma once
 
-#include <boost/serialization/access.hpp>
-#include <boost/serialization/split_member.hpp>
-#include <boost/serialization/string.hpp>
-#include <boost/serialization/vector.hpp>
+#include "ExactSum.h"
 
+#include <array>
 #include <vector>
 #include <string>
 #include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Метод численного интегрирования.
+ * 
+ * Методы 0-3 составные: диапазон делится на панели шириной step,
+ * на каждой панели применяется формула метода. Адаптивный метод и
+ * аппроксимация Чебышёва сами выбирают разбиение по заданным допускам.
+ */
+enum class IntegrationMethod : unsigned {
+    Midpoint = 0,      ///< Средние прямоугольники
+    Simpson = 1,       ///< Формула Симпсона
+    GaussLegendre = 2, ///< Гаусс-Лежандр, order - число узлов (2..16)
+    TanhSinh = 3,      ///< tanh-sinh, order - уровень (шаг по t равен 2^-order, 1..6)
+    AdaptiveGaussKronrod = 4, ///< Адаптивный Гаусс-Кронрод по допускам, order - 15 или 21 узел; step не используется
+    ClosedForm = 5,    ///< Точная формула li(b) - li(a): сервер отвечает сам, без клиентов
+    Chebyshev = 6      ///< Аппроксимация рядами Чебышёва с кэшем коэффициентов, rel_tol - допуск хвоста ряда; step не используется
+};
+
+/**
+ * @brief Подынтегральная функция задачи (см. Integrands.h).
+ *
+ * Значения - индексы в реестре подынтегральных функций; параметры функции
+ * передаются в IntegrationTask::params.
+ */
+enum class IntegrandId : unsigned {
+    InvLog = 0,          ///< 1/ln(x); интеграл li(b) - li(a)
+    InvLogRemainder = 1, ///< 1/ln(x) - 1/(x - 1): гладкий остаток после вычитания особенности
+    ExpOverX = 2,        ///< exp(-x)/x; интеграл E1(a) - E1(b)
+    PowerOverLog = 3,    ///< x^(p-1)/ln(x), params[0] = p; интеграл li(b^p) - li(a^p)
+    Gaussian = 4         ///< exp(-p x^2), params[0] = p; интеграл выражается через erf
+};
+
+/// Число подынтегральных функций в реестре.
+constexpr unsigned kIntegrandCount = 5;
+
+/// Наибольшее число параметров подынтегральной функции.
+constexpr std::size_t kMaxIntegrandParams = 2;
+
+/// Параметры функции, дополненные значениями по умолчанию.
+using IntegrandParams = std::array<double, kMaxIntegrandParams>;
+
+/**
+ * @brief Проверяет, задает ли метод разбиение шагом step.
+ *
+ * @param method Метод интегрирования.
+ * @return false для методов, которые выбирают разбиение сами.
+ */
+inline bool method_uses_step(IntegrationMethod method) {
+    return method != IntegrationMethod::AdaptiveGaussKronrod && method != IntegrationMethod::ClosedForm &&
+           method != IntegrationMethod::Chebyshev;
+}
 
 /**
  * @brief Структура, представляющая задачу интегрирования.
  * 
- * Содержит нижний предел, верхний предел и шаг интегрирования.
+ * Содержит нижний предел, верхний предел, шаг, метод интегрирования и
+ * подынтегральную функцию с параметрами.
  */
 struct IntegrationTask {
     double lower_bound; ///< Нижний предел интегрирования
     double upper_bound; ///< Верхний предел интегрирования
-    double step;        ///< Шаг интегрирования
+    double step;        ///< Шаг интегрирования (ширина панели)
     size_t task_id;     ///< Идентификатор задачи
+    IntegrationMethod method = IntegrationMethod::Midpoint; ///< Метод интегрирования
+    unsigned order = 0; ///< Параметр метода (число узлов или уровень)
+    double abs_tol = 0.0; ///< Допустимая абсолютная погрешность (адаптивный метод)
+    double rel_tol = 0.0; ///< Допустимая относительная погрешность (адаптивный метод, Чебышёв)
+    /// Вычитание особенности в x = 1: клиент интегрирует только гладкий остаток
+    /// 1/ln(x) - 1/(x - 1), сервер добавляет ln|b - 1| - ln|a - 1| для всего диапазона
+    bool principal_value = false;
+    IntegrandId integrand = IntegrandId::InvLog; ///< Подынтегральная функция
+    std::vector<double> params; ///< Параметры функции (недостающие берутся по умолчанию)
+    /// Методы с шагом: задача - панели [first_panel, last_panel) сетки всего задания
+    /// (lower_bound + i * step, последняя панель укорачивается до upper_bound);
+    /// при last_panel == 0 задача - вся сетка
+    uint64_t first_panel = 0;
+    uint64_t last_panel = 0;
+    size_t job_id = 0; ///< Запрос сервера, частью которого является задача (для отмены)
+};
 
-    template<class Archive>
-    void serialize(Archive &ar, const unsigned int version) {
-        (void)version; // Suppress unused parameter warning
-        ar & lower_bound;
-        ar & upper_bound;
-        ar & step;
-        ar & task_id;
-    }
+/**
+ * @brief Запрос отмены задачи или всех задач запроса сервера.
+ */
+struct CancelRequest {
+    size_t task_id = 0;     ///< Отменяемая задача (если whole_job == false)
+    size_t job_id = 0;      ///< Отменяемый запрос (если whole_job == true)
+    bool whole_job = false; ///< Отменить все задачи запроса job_id
 };
 
 /**
  * @brief Структура, представляющая результат интегрирования.
  * 
- * Содержит вычисленное значение интеграла и идентификатор задачи.
+ * Содержит вычисленное значение интеграла, оценку погрешности и идентификатор задачи.
  */
 struct IntegrationResult {
     double result;      ///< Вычисленное значение интеграла
     size_t task_id;     ///< Идентификатор задачи
+    double error_estimate = 0.0; ///< Оценка абсолютной погрешности (0 - метод ее не дает)
+    ExactSum sum;       ///< Точное значение до округления; сервер складывает именно его
+};
 
-    template<class Archive>
-    void serialize(Archive &ar, const unsigned int version) {
-        (void)version; // Suppress unused parameter warning
-        ar & result;
-        ar & task_id;
-    }
+/**
+ * @brief Промежуточный отчет клиента о выполнении задачи.
+ */
+struct ProgressReport {
+    size_t task_id = 0;           ///< Задача
+    size_t job_id = 0;            ///< Запрос сервера, частью которого является задача
+    double fraction = 0.0;        ///< Выполненная доля задачи, [0, 1]
+    double partial_sum = 0.0;     ///< Сумма уже вычисленных частей (округленная)
+    double elapsed_seconds = 0.0; ///< Время с начала выполнения задачи на клиенте
+    double evals_per_sec = 0.0;   ///< Текущая скорость вычислений функции на задаче (0 - неизвестна)
+};
+
+/**
+ * @brief Структура, которую клиент отправляет серверу при подключении.
+ * 
+ * Содержит количество потоков вычислений, эффективную емкость процессора,
+ * измеренную производительность, имя выбранного варианта вычислительного
+ * ядра и размещение потоков.
+ */
+struct ClientHello {
+    size_t num_cores;   ///< Количество ядер CPU клиента
+    std::string isa;    ///< Набор инструкций активного ядра ("sse2", "avx2", "avx512")
+    std::string pinning = "none"; ///< Закрепление потоков ("none", "threads", "cores")
+    size_t pinned_workers = 0;    ///< Потоков, закрепленных за процессорами
+    size_t numa_nodes = 1;        ///< Узлов NUMA, на которых работают потоки
+    /// Эффективная емкость в ядрах с учетом маски процессоров и квоты cgroup
+    /// (может быть дробной; 0 - не сообщена, емкость равна num_cores)
+    double capacity = 0.0;
+    /// Производительность по калибровке: вычислений функции в секунду на всех
+    /// потоках (0 - не измерена)
+    double evals_per_sec = 0.0;
+    /// Период отчетов о ходе задач и heartbeat (0 - клиент их не отправляет)
+    unsigned heartbeat_ms = 0;
+    /// Имя сегмента общей памяти, через который клиент предлагает обмениваться
+    /// сообщениями (пусто - только сокет)
+    std::string shared_memory{};
 };
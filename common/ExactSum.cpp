@@ -0,0 +1,188 @@
+#include "ExactSum.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+constexpr uint64_t kChunkMask = 0xFFFFFFFFull;
+
+/**
+ * @brief Число ведущих нулевых битов ненулевого 64-битного числа.
+ */
+int leading_zeros(uint64_t value) {
+    int count = 0;
+    for (uint64_t bit = 1ull << 63; (value & bit) == 0; bit >>= 1) {
+        ++count;
+    }
+    return count;
+}
+
+} // namespace
+
+ExactSum::ExactSum(double value) {
+    add(value);
+}
+
+void ExactSum::add(double value) {
+    if (!std::isfinite(value)) {
+        special_ += value;
+        return;
+    }
+    if (value == 0.0) {
+        return;
+    }
+
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    const bool negative = (bits >> 63) != 0;
+    int exponent = static_cast<int>((bits >> 52) & 0x7FF);
+    uint64_t mantissa = bits & 0x000FFFFFFFFFFFFFull;
+    if (exponent == 0) {
+        exponent = 1; // Денормализованное число: mantissa * 2^-1074
+    } else {
+        mantissa |= 1ull << 52;
+    }
+
+    // value = mantissa * 2^(position - 1074); сдвинутая мантисса занимает до трех ячеек
+    const int position = exponent - 1;
+    const int chunk = position / kChunkBits;
+    const int shift = position % kChunkBits;
+    const uint64_t low = (mantissa << shift) & kChunkMask;
+    const uint64_t middle = (shift == 0 ? mantissa >> kChunkBits : mantissa >> (kChunkBits - shift)) & kChunkMask;
+    const uint64_t high = shift == 0 ? 0 : mantissa >> (2 * kChunkBits - shift);
+
+    if (negative) {
+        chunks_[chunk] -= static_cast<int64_t>(low);
+        chunks_[chunk + 1] -= static_cast<int64_t>(middle);
+        chunks_[chunk + 2] -= static_cast<int64_t>(high);
+    } else {
+        chunks_[chunk] += static_cast<int64_t>(low);
+        chunks_[chunk + 1] += static_cast<int64_t>(middle);
+        chunks_[chunk + 2] += static_cast<int64_t>(high);
+    }
+    if (++pending_ >= kMaxPending) {
+        normalize();
+    }
+}
+
+void ExactSum::add(const ExactSum& other) {
+    ExactSum addend = other;
+    addend.normalize();
+    normalize();
+    for (int c = 0; c < kChunks; ++c) {
+        chunks_[c] += addend.chunks_[c];
+    }
+    special_ += other.special_;
+    normalize();
+}
+
+bool ExactSum::operator==(const ExactSum& other) const {
+    ExactSum lhs = *this;
+    ExactSum rhs = other;
+    lhs.normalize();
+    rhs.normalize();
+    const bool same_special = lhs.special_ == rhs.special_ || (std::isnan(lhs.special_) && std::isnan(rhs.special_));
+    return same_special && lhs.chunks_ == rhs.chunks_;
+}
+
+void ExactSum::normalize() {
+    // После переноса все ячейки, кроме старшей, лежат в [0, 2^32); знак суммы - знак старшей
+    int64_t carry = 0;
+    for (int c = 0; c + 1 < kChunks; ++c) {
+        int64_t value = chunks_[c] + carry;
+        chunks_[c] = value & static_cast<int64_t>(kChunkMask);
+        carry = value >> kChunkBits;
+    }
+    chunks_[kChunks - 1] += carry;
+    pending_ = 0;
+}
+
+double ExactSum::round() const {
+    if (special_ != 0.0 || std::isnan(special_)) {
+        return special_;
+    }
+
+    ExactSum magnitude = *this;
+    magnitude.normalize();
+    const bool negative = magnitude.chunks_[kChunks - 1] < 0;
+    if (negative) {
+        for (auto& chunk : magnitude.chunks_) {
+            chunk = -chunk;
+        }
+        magnitude.normalize();
+    }
+
+    int highest = kChunks - 1;
+    while (highest >= 0 && magnitude.chunks_[highest] == 0) {
+        --highest;
+    }
+    if (highest < 0) {
+        return 0.0;
+    }
+    if (magnitude.chunks_[highest] > static_cast<int64_t>(kChunkMask)) {
+        return negative ? -HUGE_VAL : HUGE_VAL;
+    }
+
+    auto chunk_at = [&magnitude](int c) -> uint64_t {
+        return c >= 0 ? static_cast<uint64_t>(magnitude.chunks_[c]) : 0;
+    };
+
+    // Окно из трех старших ячеек: W = c[h] 2^64 + c[h-1] 2^32 + c[h-2], младшие ячейки - только признак ненулевого остатка
+    const uint64_t window = (chunk_at(highest) << kChunkBits) | chunk_at(highest - 1);
+    const uint64_t below = chunk_at(highest - 2);
+    bool sticky = false;
+    for (int c = highest - 3; c >= 0; --c) {
+        sticky = sticky || magnitude.chunks_[c] != 0;
+    }
+
+    const int zeros = leading_zeros(window);
+    const uint64_t top = (window << zeros) | (zeros == 0 ? 0 : below >> (kChunkBits - zeros));
+    sticky = sticky || (zeros == 0 ? below : below & ((1ull << (kChunkBits - zeros)) - 1)) != 0;
+
+    // top * 2^base - сумма без отброшенных битов; округляем до 53 бит или до 2^-1074
+    const int base = kChunkBits * (highest - 1) - 1074 - zeros;
+    const int lowest_bit = std::max(base + 63 - 52, -1074);
+    const int drop = lowest_bit - base;
+
+    uint64_t mantissa = top >> drop;
+    const bool guard = ((top >> (drop - 1)) & 1) != 0;
+    const bool rest = sticky || (top & ((1ull << (drop - 1)) - 1)) != 0;
+    if (guard && (rest || (mantissa & 1) != 0)) {
+        ++mantissa;
+    }
+    const double result = std::ldexp(static_cast<double>(mantissa), lowest_bit);
+    return negative ? -result : result;
+}
+
+ExactSum::Raw ExactSum::raw() const {
+    ExactSum normalized = *this;
+    normalized.normalize();
+    Raw raw;
+    raw.chunks = normalized.chunks_;
+    raw.special = normalized.special_;
+    return raw;
+}
+
+bool ExactSum::valid(const Raw& raw) {
+    for (int c = 0; c + 1 < kChunks; ++c) {
+        if (raw.chunks[c] < 0 || raw.chunks[c] > static_cast<int64_t>(kChunkMask)) {
+            return false;
+        }
+    }
+    const int64_t top = raw.chunks[kChunks - 1];
+    const int64_t limit = static_cast<int64_t>(1) << kChunkBits;
+    return top >= -limit && top <= limit && (raw.special == 0.0 || !std::isfinite(raw.special));
+}
+
+ExactSum ExactSum::from_raw(const Raw& raw) {
+    if (!valid(raw)) {
+        throw std::invalid_argument("ненормализованное представление точной суммы");
+    }
+    ExactSum sum;
+    sum.chunks_ = raw.chunks;
+    sum.special_ = raw.special;
+    return sum;
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+/**
+ * @brief Точный накопитель суммы чисел double (супераккумулятор).
+ *
+ * Сумма хранится как число с фиксированной точкой на всем диапазоне double:
+ * kChunks знаковых 64-битных ячеек по 32 значащих бита, ячейка c имеет вес
+ * 2^(32c - 1074). Сложение выполняется без округления, поэтому результат не
+ * зависит ни от порядка слагаемых, ни от того, как они были разбиты на части
+ * между потоками, клиентами и сервером; округление до double выполняется
+ * один раз в round() (к ближайшему, при равенстве - к четному).
+ */
+class ExactSum {
+public:
+    static constexpr int kChunkBits = 32;
+    static constexpr int kChunks = 68;
+
+    /**
+     * @brief Нормализованное представление фиксированного размера.
+     *
+     * Тривиально копируемо: годится для хранения в отображаемых в память
+     * файлах и двоичных форматах.
+     */
+    struct Raw {
+        std::array<int64_t, kChunks> chunks{}; ///< Ячейки по 32 бита, старшая знаковая
+        double special = 0.0;                  ///< Сумма бесконечностей и NaN
+    };
+
+    ExactSum() = default;
+
+    /**
+     * @brief Создает накопитель, содержащий одно слагаемое.
+     */
+    explicit ExactSum(double value);
+
+    /**
+     * @brief Добавляет слагаемое без округления.
+     *
+     * Бесконечности и NaN накапливаются отдельно по правилам IEEE.
+     */
+    void add(double value);
+
+    /**
+     * @brief Добавляет точную сумму другого накопителя.
+     */
+    void add(const ExactSum& other);
+
+    /**
+     * @brief Возвращает сумму, округленную до ближайшего double.
+     */
+    double round() const;
+
+    /**
+     * @brief Сравнивает точные значения (а не округленные).
+     */
+    bool operator==(const ExactSum& other) const;
+    bool operator!=(const ExactSum& other) const { return !(*this == other); }
+
+    /**
+     * @brief Возвращает нормализованное представление фиксированного размера.
+     */
+    Raw raw() const;
+
+    /**
+     * @brief Проверяет, что представление могло быть получено из raw().
+     *
+     * Ячейки, кроме старшей, лежат в [0, 2^32), старшая - в [-2^32, 2^32],
+     * special - 0, бесконечность или NaN. Иначе последующие сложения могут
+     * переполнить ячейки.
+     */
+    static bool valid(const Raw& raw);
+
+    /**
+     * @brief Восстанавливает накопитель из представления raw().
+     *
+     * @throws std::invalid_argument Если представление некорректно (см. valid()).
+     */
+    static ExactSum from_raw(const Raw& raw);
+
+private:
+    /// Ячейка не переполнится, пока в нее добавлено меньше 2^30 слагаемых по 2^32.
+    static constexpr uint32_t kMaxPending = 1u << 30;
+
+    void normalize();
+
+    std::array<int64_t, kChunks> chunks_{}; ///< Ячейки по 32 бита, старшая знаковая
+    double special_ = 0.0;                  ///< Сумма бесконечностей и NaN
+    uint32_t pending_ = 0;                  ///< Слагаемых после последней нормализации
+};
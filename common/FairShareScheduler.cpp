@@ -0,0 +1,74 @@
+#include "FairShareScheduler.h"
+
+#include <algorithm>
+
+FairShareScheduler::FairShareScheduler(std::size_t slots)
+    : slots_(std::max<std::size_t>(slots, 1)) {
+}
+
+std::size_t FairShareScheduler::add_share(double weight) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Share share;
+    share.weight = weight > 0.0 ? weight : 1.0;
+    share.virtual_time = virtual_now_;
+    shares_.push_back(share);
+    return shares_.size() - 1;
+}
+
+void FairShareScheduler::acquire(std::size_t share) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    Share& current = shares_.at(share);
+    if (current.waiting == 0 && current.running == 0) {
+        // Простой не дает права на чужое время
+        current.virtual_time = std::max(current.virtual_time, virtual_now_);
+    }
+    ++current.waiting;
+    cv_.wait(lock, [this, share]() { return used_ < slots_ && next_in_line(share); });
+    // Пока поток ждал, список источников мог вырасти: ссылка на элемент недействительна
+    Share& granted = shares_[share];
+    --granted.waiting;
+    ++granted.running;
+    ++used_;
+    virtual_now_ = granted.virtual_time;
+}
+
+void FairShareScheduler::release(std::size_t share, double cost) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Share& current = shares_.at(share);
+        --current.running;
+        --used_;
+        current.usage += cost;
+        current.virtual_time += cost / current.weight;
+    }
+    cv_.notify_all();
+}
+
+double FairShareScheduler::usage(std::size_t share) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return shares_.at(share).usage;
+}
+
+std::size_t FairShareScheduler::waiting() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::size_t total = 0;
+    for (const Share& share : shares_) {
+        total += share.waiting;
+    }
+    return total;
+}
+
+bool FairShareScheduler::next_in_line(std::size_t share) const {
+    // Из ожидающих источников первым идет источник с наименьшим виртуальным временем,
+    // при равенстве - зарегистрированный раньше
+    const double own = shares_[share].virtual_time;
+    for (std::size_t i = 0; i < shares_.size(); ++i) {
+        if (i == share || shares_[i].waiting == 0) {
+            continue;
+        }
+        if (shares_[i].virtual_time < own || (shares_[i].virtual_time == own && i < share)) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+/**
+ * @brief Делит места для задач в общем пуле потоков между источниками задач по весам.
+ *
+ * Клиент, обслуживающий несколько серверов, выполняет их задачи в одном
+ * пуле, а число одновременно выполняемых задач ограничено. Освободившееся
+ * место получает ожидающий источник с наименьшим виртуальным временем -
+ * временем выполнения его задач, деленным на вес (справедливая очередь с
+ * начальными метками). Место не простаивает, пока кто-то ждет: источник
+ * получает больше своей доли, если остальным нечего выполнять. Вернувшийся
+ * после простоя источник не копит кредит: его виртуальное время
+ * подтягивается к виртуальному времени последней выданной задачи.
+ */
+class FairShareScheduler {
+public:
+    /**
+     * @brief Создает планировщик.
+     *
+     * @param slots Число задач, выполняемых одновременно (0 заменяется на 1).
+     */
+    explicit FairShareScheduler(std::size_t slots);
+
+    FairShareScheduler(const FairShareScheduler&) = delete;
+    FairShareScheduler& operator=(const FairShareScheduler&) = delete;
+
+    /**
+     * @brief Регистрирует источник задач.
+     *
+     * @param weight Вес источника (не больше 0 заменяется на 1).
+     * @return Номер источника для acquire() и release().
+     */
+    std::size_t add_share(double weight);
+
+    /**
+     * @brief Ждет места для задачи источника.
+     *
+     * @param share Номер источника.
+     */
+    void acquire(std::size_t share);
+
+    /**
+     * @brief Освобождает место и учитывает затраты задачи.
+     *
+     * @param share Номер источника.
+     * @param cost Затраты задачи (например, время выполнения в секундах; 0 - задача не выполнялась).
+     */
+    void release(std::size_t share, double cost);
+
+    /**
+     * @brief Возвращает суммарные затраты задач источника.
+     */
+    double usage(std::size_t share) const;
+
+    /**
+     * @brief Возвращает число вызовов acquire(), ожидающих места.
+     */
+    std::size_t waiting() const;
+
+private:
+    /**
+     * @brief Источник задач.
+     */
+    struct Share {
+        double weight = 1.0;
+        double virtual_time = 0.0; ///< Затраты, деленные на вес, с учетом простоев
+        double usage = 0.0;        ///< Суммарные затраты
+        std::size_t waiting = 0;   ///< Ожидающих места задач
+        std::size_t running = 0;   ///< Выполняющихся задач
+    };
+
+    bool next_in_line(std::size_t share) const;
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::vector<Share> shares_;
+    std::size_t slots_;
+    std::size_t used_ = 0;
+    double virtual_now_ = 0.0; ///< Виртуальное время последней выданной задачи
+};
@@ -0,0 +1,188 @@
+#pragma once
+
+/**
+ * @brief Реестр подынтегральных функций.
+ *
+ * Каждая функция - шаблон от типа вектора (см. SimdMath.h) с одинаковым
+ * интерфейсом:
+ *   - id, name, param_count, defaults, domain_start - описание функции;
+ *   - конструктор от массива параметров (kMaxIntegrandParams значений);
+ *   - eval(x) - значение в каждой дорожке вектора; F<simd::Scalar>::eval
+ *     служит скалярной версией.
+ * Точки не правее domain_start дают нулевой вклад; проверка выполняется
+ * вызывающим кодом один раз на диапазон. Ядра инстанцируются для каждой
+ * функции реестра, поэтому функция выбирается один раз на задачу, а
+ * внутренний цикл не содержит косвенных вызовов.
+ *
+ * Чтобы добавить функцию: новое значение IntegrandId (DataStructures.h),
+ * шаблон здесь и его имя в Registry на позиции, равной значению id.
+ */
+
+#include "DataStructures.h"
+#include "SimdMath.h"
+
+#include <array>
+#include <limits>
+
+namespace integrands {
+
+/// Параметры функции, дополненные значениями по умолчанию.
+using Params = IntegrandParams;
+
+/**
+ * @brief Список шаблонов подынтегральных функций.
+ */
+template<template<class> class... F>
+struct IntegrandList {};
+
+inline namespace SIMD_VARIANT_NAMESPACE {
+
+/**
+ * @brief 1/ln(x); определена правее особой точки x = 1.
+ */
+template<class V>
+struct InvLog {
+    static constexpr IntegrandId id = IntegrandId::InvLog;
+    static constexpr const char* name = "1/ln(x)";
+    static constexpr unsigned param_count = 0;
+    static constexpr Params defaults{};
+    /// Совпадает с kernels::kSingularThreshold: у x = 1 |ln x| < 1e-10
+    static constexpr double domain_start = 1.0 + 1e-10;
+
+    explicit InvLog(const Params& /*params*/) {}
+
+    typename V::vec eval(typename V::vec x) const {
+        return V::div(V::set1(1.0), simd::log<V>(x));
+    }
+};
+
+/**
+ * @brief Гладкий остаток g(x) = 1/ln(x) - 1/(x - 1) после вычитания полюса в x = 1.
+ *
+ * Вблизи x = 1 разность двух больших слагаемых теряет точность, поэтому при
+ * |x - 1| < 0.1 используется ряд Грегори g(1 + u) = 1/2 - u/12 + u^2/24 - ...
+ * (остаток ряда меньше 1e-18). Обе ветви вычисляются во всех дорожках и
+ * смешиваются по маске; NaN из ветви x = 1 в результат не попадает.
+ */
+template<class V>
+struct InvLogRemainder {
+    static constexpr IntegrandId id = IntegrandId::InvLogRemainder;
+    static constexpr const char* name = "1/ln(x) - 1/(x - 1)";
+    static constexpr unsigned param_count = 0;
+    static constexpr Params defaults{};
+    static constexpr double domain_start = 0.0;
+
+    explicit InvLogRemainder(const Params& /*params*/) {}
+
+    typename V::vec eval(typename V::vec x) const {
+        using vec = typename V::vec;
+        const vec one = V::set1(1.0);
+        const vec u = V::sub(x, one);
+
+        vec series = V::set1(-0.003497349845349917654109393);
+        series = V::fmadd(series, u, V::set1(0.003826899553211884423304176));
+        series = V::fmadd(series, u, V::set1(-0.004214952239005472856883792));
+        series = V::fmadd(series, u, V::set1(0.004677498407042264515809489));
+        series = V::fmadd(series, u, V::set1(-0.005236693257950285066687183));
+        series = V::fmadd(series, u, V::set1(0.005924056412337662337662338));
+        series = V::fmadd(series, u, V::set1(-0.006785849984634706856929079));
+        series = V::fmadd(series, u, V::set1(0.007892554012345679012345679));
+        series = V::fmadd(series, u, V::set1(-0.009356536596119929453262787));
+        series = V::fmadd(series, u, V::set1(0.01136739417989417989417989));
+        series = V::fmadd(series, u, V::set1(-0.01426917989417989417989418));
+        series = V::fmadd(series, u, V::set1(0.01875));
+        series = V::fmadd(series, u, V::set1(-0.02638888888888888888888889));
+        series = V::fmadd(series, u, V::set1(1.0 / 24.0));
+        series = V::fmadd(series, u, V::set1(-1.0 / 12.0));
+        series = V::fmadd(series, u, V::set1(0.5));
+
+        const vec direct = V::sub(V::div(one, simd::log<V>(x)), V::div(one, u));
+        return V::select_lt(V::mul(u, u), V::set1(0.01), series, direct);
+    }
+};
+
+/**
+ * @brief exp(-x)/x; определена при x > 0.
+ */
+template<class V>
+struct ExpOverX {
+    static constexpr IntegrandId id = IntegrandId::ExpOverX;
+    static constexpr const char* name = "exp(-x)/x";
+    static constexpr unsigned param_count = 0;
+    static constexpr Params defaults{};
+    static constexpr double domain_start = 0.0;
+
+    explicit ExpOverX(const Params& /*params*/) {}
+
+    typename V::vec eval(typename V::vec x) const {
+        return V::div(simd::exp<V>(V::sub(V::zero(), x)), x);
+    }
+};
+
+/**
+ * @brief x^(p-1)/ln(x), params[0] = p > 0; определена правее x = 1.
+ *
+ * Замена t = x^p сводит интеграл к li(b^p) - li(a^p).
+ */
+template<class V>
+struct PowerOverLog {
+    static constexpr IntegrandId id = IntegrandId::PowerOverLog;
+    static constexpr const char* name = "x^(p-1)/ln(x)";
+    static constexpr unsigned param_count = 1;
+    static constexpr Params defaults{2.0, 0.0};
+    static constexpr double domain_start = 1.0 + 1e-10;
+
+    explicit PowerOverLog(const Params& params) : exponent_(V::set1(params[0] - 1.0)) {}
+
+    typename V::vec eval(typename V::vec x) const {
+        const typename V::vec log_x = simd::log<V>(x);
+        return V::div(simd::exp<V>(V::mul(exponent_, log_x)), log_x);
+    }
+
+private:
+    typename V::vec exponent_;
+};
+
+/**
+ * @brief exp(-p x^2), params[0] = p > 0; определена на всей оси.
+ */
+template<class V>
+struct Gaussian {
+    static constexpr IntegrandId id = IntegrandId::Gaussian;
+    static constexpr const char* name = "exp(-p x^2)";
+    static constexpr unsigned param_count = 1;
+    static constexpr Params defaults{1.0, 0.0};
+    static constexpr double domain_start = -std::numeric_limits<double>::infinity();
+
+    explicit Gaussian(const Params& params) : minus_p_(V::set1(-params[0])) {}
+
+    typename V::vec eval(typename V::vec x) const {
+        return simd::exp<V>(V::mul(minus_p_, V::mul(x, x)));
+    }
+
+private:
+    typename V::vec minus_p_;
+};
+
+/// Реестр: позиция шаблона совпадает со значением его IntegrandId.
+using Registry = IntegrandList<InvLog, InvLogRemainder, ExpOverX, PowerOverLog, Gaussian>;
+
+} // inline namespace SIMD_VARIANT_NAMESPACE
+
+/**
+ * @brief Проверяет, что позиции в реестре совпадают с IntegrandId.
+ */
+template<template<class> class... F>
+constexpr bool registry_is_ordered(IntegrandList<F...>) {
+    constexpr IntegrandId ids[] = {F<simd::Scalar>::id...};
+    for (unsigned i = 0; i < sizeof...(F); ++i) {
+        if (static_cast<unsigned>(ids[i]) != i) {
+            return false;
+        }
+    }
+    return sizeof...(F) == kIntegrandCount;
+}
+
+static_assert(registry_is_ordered(Registry{}), "Порядок реестра должен совпадать с IntegrandId");
+
+} // namespace integrands
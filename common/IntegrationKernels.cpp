@@ -0,0 +1,752 @@
+#include "IntegrationKernels.h"
+#include "ChebyshevSurrogate.h"
+#include "IntegrationKernelsImpl.h"
+#include "IntegrationKernelsVariants.h"
+#include "LogIntegral.h"
+#include "QuadratureRules.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <queue>
+#include <stdexcept>
+#include <vector>
+
+namespace kernels {
+
+namespace baseline {
+
+#if defined(__SSE2__) || defined(_M_X64)
+using BaselineVec = simd::Sse2;
+#else
+using BaselineVec = simd::Scalar;
+#endif
+
+const VariantEntries& entries() {
+    static const VariantEntries table = detail::make_entries<BaselineVec>(integrands::Registry{});
+    return table;
+}
+
+} // namespace baseline
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+
+/// Параметры методов по умолчанию (order = 0 в задаче).
+constexpr unsigned kDefaultGaussLegendreOrder = 8;
+constexpr unsigned kDefaultTanhSinhLevel = 3;
+
+static_assert(integrands::InvLog<simd::Scalar>::domain_start == kSingularThreshold,
+              "Область 1/ln(x) должна совпадать с kSingularThreshold");
+
+/**
+ * @brief Таблица точек входа одного варианта ядер.
+ */
+struct KernelTable {
+    IsaLevel isa;
+    const VariantEntries& (*entries)();
+};
+
+const KernelTable kBaselineTable = {
+#if defined(__SSE2__) || defined(_M_X64)
+    IsaLevel::Sse2,
+#else
+    IsaLevel::Scalar,
+#endif
+    &baseline::entries,
+};
+
+#if defined(KERNELS_X86_VARIANTS)
+const KernelTable kAvx2Table = {IsaLevel::Avx2, &avx2::entries};
+const KernelTable kAvx512Table = {IsaLevel::Avx512, &avx512::entries};
+#endif
+
+/**
+ * @brief Возвращает таблицу для заданного уровня или nullptr, если вариант не собран.
+ */
+const KernelTable* table_for(IsaLevel level) {
+    switch (level) {
+#if defined(KERNELS_X86_VARIANTS)
+        case IsaLevel::Avx512: return &kAvx512Table;
+        case IsaLevel::Avx2:   return &kAvx2Table;
+#else
+        case IsaLevel::Avx512:
+        case IsaLevel::Avx2:   return nullptr;
+#endif
+        case IsaLevel::Sse2:
+        case IsaLevel::Scalar:
+            return kBaselineTable.isa == level ? &kBaselineTable : nullptr;
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Выбирает лучший вариант, который и собран, и поддерживается процессором.
+ */
+const KernelTable* detect_best_table() {
+    for (int level = static_cast<int>(best_isa_level(detect_cpu_features())); level >= 0; --level) {
+        if (const KernelTable* table = table_for(static_cast<IsaLevel>(level))) {
+            return table;
+        }
+    }
+    return &kBaselineTable;
+}
+
+/**
+ * @brief Активная таблица: выбирается один раз при первом обращении.
+ */
+std::atomic<const KernelTable*>& active_table() {
+    static std::atomic<const KernelTable*> table{detect_best_table()};
+    return table;
+}
+
+/**
+ * @brief Описания функций реестра, собранные из их шаблонов.
+ */
+template<template<class> class... F>
+std::array<IntegrandInfo, kIntegrandCount> make_info(integrands::IntegrandList<F...>) {
+    return {{IntegrandInfo{F<simd::Scalar>::id, F<simd::Scalar>::name, F<simd::Scalar>::param_count,
+                           F<simd::Scalar>::defaults, F<simd::Scalar>::domain_start}...}};
+}
+
+/**
+ * @brief Подынтегральная функция, выбранная для задачи: точки входа ядер активного
+ * варианта, параметры и область определения.
+ *
+ * Выбор выполняется один раз на задачу; внутренние циклы ядер специализированы
+ * под функцию и косвенных вызовов не содержат.
+ */
+struct Integrand {
+    GridSumFn sum;
+    ValuesFn values;
+    IntegrandParams params;
+    double threshold; ///< Узлы не правее порога дают нулевой вклад
+};
+
+/**
+ * @brief Выбирает ядра функции id в активном варианте.
+ */
+Integrand make_integrand(IntegrandId id, const IntegrandParams& params) {
+    const auto index = static_cast<unsigned>(id) < kIntegrandCount ? static_cast<unsigned>(id) : 0u;
+    const VariantEntries& entries = active_table().load(std::memory_order_relaxed)->entries();
+    return {entries.sum[index], entries.values[index], params,
+            integrand_info(static_cast<IntegrandId>(index)).domain_start};
+}
+
+/**
+ * @brief Число полных панелей шириной step в [lower_bound, upper_bound].
+ *
+ * @throws std::invalid_argument Если число панелей бесконечно, не определено или не помещается в uint64_t.
+ */
+uint64_t full_panels(double lower_bound, double upper_bound, double step) {
+    const double quotient = std::floor((upper_bound - lower_bound) / step);
+    // 2^64 точно представимо; сравнение отвергает и NaN
+    if (!(quotient >= 0.0 && quotient < 18446744073709551616.0)) {
+        throw std::invalid_argument("число панелей сетки не помещается в uint64_t");
+    }
+    uint64_t panels = static_cast<uint64_t>(quotient);
+    while (panels > 0 && lower_bound + static_cast<double>(panels) * step > upper_bound) {
+        --panels;
+    }
+    return panels;
+}
+
+/**
+ * @brief Номер первой панели, узел которой лежит правее порога threshold.
+ *
+ * Узлы возрастают с номером панели, поэтому проверка области определения
+ * сводится к поиску одной границы на весь диапазон.
+ */
+uint64_t first_regular_panel(double threshold, double origin, double step, double offset, uint64_t panels) {
+    if (origin + offset * step > threshold) {
+        return 0;
+    }
+    double skip = std::ceil((threshold - origin) / step - offset);
+    uint64_t first = skip > static_cast<double>(panels) ? panels : static_cast<uint64_t>(skip);
+    while (first < panels && origin + (static_cast<double>(first) + offset) * step <= threshold) {
+        ++first;
+    }
+    while (first > 0 && origin + (static_cast<double>(first - 1) + offset) * step > threshold) {
+        --first;
+    }
+    return first;
+}
+
+/**
+ * @brief Сетка задания: полные панели [origin + i step, origin + (i + 1) step]
+ * для i < full и, если есть, укороченная панель [origin + full step, end] с номером full.
+ */
+struct Grid {
+    double origin;
+    double end;
+    double step;
+    uint64_t full;
+
+    bool has_tail() const {
+        return origin + static_cast<double>(full) * step < end;
+    }
+
+    uint64_t panels() const {
+        return full + (has_tail() ? 1 : 0);
+    }
+};
+
+Grid make_grid(double lower_bound, double upper_bound, double step) {
+    return Grid{lower_bound, upper_bound, step, full_panels(lower_bound, upper_bound, step)};
+}
+
+/**
+ * @brief Добавляет weight * Σ f(origin + (i + offset) * step) по i в [first, last); точки вне области дают 0.
+ *
+ * Граница области ищется по глобальной сетке, поэтому не зависит от того,
+ * какая часть сетки обрабатывается.
+ */
+void accumulate_nodes(const Integrand& f, double origin, double step, double offset,
+                      uint64_t first, uint64_t last, double weight, ExactSum& sum) {
+    first = std::max(first, first_regular_panel(f.threshold, origin, step, offset, last));
+    if (first < last) {
+        f.sum(f.params, origin, step, offset, first, last, weight, sum);
+    }
+}
+
+/**
+ * @brief Применяет формулу с узлами на панели к панелям [first, last) шириной step.
+ *
+ * Для каждого узла формулы сумма по панелям считается одним проходом
+ * векторного ядра с весом узла, умноженным на ширину панели.
+ */
+template<class Rule>
+void accumulate_rule(const Integrand& f, const Rule& rule, double origin, double step,
+                     uint64_t first, uint64_t last, ExactSum& sum) {
+    for (std::size_t k = 0; k < rule.offsets.size(); ++k) {
+        accumulate_nodes(f, origin, step, rule.offsets[k], first, last, rule.weights[k] * step, sum);
+    }
+}
+
+/**
+ * @brief Составная формула на панелях [first, last) сетки; укороченную панель считает ее владелец.
+ */
+template<class Rule>
+void composite(const Integrand& f, const Rule& rule, const Grid& grid, uint64_t first, uint64_t last, ExactSum& sum) {
+    accumulate_rule(f, rule, grid.origin, grid.step, first, std::min(last, grid.full), sum);
+    if (first <= grid.full && grid.full < last && grid.has_tail()) {
+        double tail_lower = grid.origin + static_cast<double>(grid.full) * grid.step;
+        accumulate_rule(f, rule, tail_lower, grid.end - tail_lower, 0, 1, sum);
+    }
+}
+
+/**
+ * @brief Формула tanh-sinh заданного уровня (уровень 0 - по умолчанию, вне диапазона - ближайший).
+ *
+ * Узлы требуют exp/sinh, поэтому таблица всех уровней строится один раз при
+ * первом использовании: ее разделяют ядро метода и оценка числа вычислений.
+ */
+const quadrature::TanhSinhRule& tanh_sinh_rule(unsigned level) {
+    static const std::vector<quadrature::TanhSinhRule> rules = [] {
+        std::vector<quadrature::TanhSinhRule> built;
+        for (unsigned built_level = 0; built_level <= quadrature::kTanhSinhMaxLevel; ++built_level) {
+            built.push_back(quadrature::make_tanh_sinh(built_level));
+        }
+        return built;
+    }();
+    if (level == 0) {
+        level = kDefaultTanhSinhLevel;
+    }
+    return rules[std::min(std::max(level, quadrature::kTanhSinhMinLevel), quadrature::kTanhSinhMaxLevel)];
+}
+
+/**
+ * @brief Ядро интегрирования, специализированное для каждого метода.
+ */
+template<IntegrationMethod M>
+struct MethodKernel;
+
+template<>
+struct MethodKernel<IntegrationMethod::Midpoint> {
+    static void accumulate(const Integrand& f, const Grid& grid, uint64_t first, uint64_t last, unsigned /*order*/,
+                           ExactSum& sum) {
+        static constexpr quadrature::PanelRule<1> rule{{0.5}, {1.0}};
+        composite(f, rule, grid, first, last, sum);
+    }
+};
+
+template<>
+struct MethodKernel<IntegrationMethod::Simpson> {
+    /**
+     * Узлы на границах панелей общие для соседних панелей, поэтому они
+     * суммируются один раз: h/6 * (f_0 + 2 Σ f_j + f_n + 4 Σ f_{j+1/2}).
+     * Панель владеет своим левым краем; крайние узлы всей сетки получают
+     * поправку от частей, в которые они попали.
+     */
+    static void accumulate(const Integrand& f, const Grid& grid, uint64_t first, uint64_t last, unsigned /*order*/,
+                           ExactSum& sum) {
+        const double h = grid.step;
+        const uint64_t last_full = std::min(last, grid.full);
+        if (first < last_full) {
+            accumulate_nodes(f, grid.origin, h, 0.0, first, last_full, h / 3.0, sum);
+            accumulate_nodes(f, grid.origin, h, 0.5, first, last_full, 2.0 * h / 3.0, sum);
+            if (first == 0) {
+                accumulate_nodes(f, grid.origin, h, 0.0, 0, 1, -h / 6.0, sum);
+            }
+            if (last_full == grid.full) {
+                accumulate_nodes(f, grid.origin, h, 0.0, grid.full, grid.full + 1, h / 6.0, sum);
+            }
+        }
+
+        static constexpr quadrature::PanelRule<3> rule{{0.0, 0.5, 1.0}, {1.0 / 6.0, 4.0 / 6.0, 1.0 / 6.0}};
+        composite(f, rule, grid, std::max(first, grid.full), last, sum);
+    }
+};
+
+template<>
+struct MethodKernel<IntegrationMethod::GaussLegendre> {
+    template<std::size_t N>
+    static void accumulate_order(const Integrand& f, const Grid& grid, uint64_t first, uint64_t last, ExactSum& sum) {
+        composite(f, quadrature::kGaussLegendre<N>, grid, first, last, sum);
+    }
+
+    static void accumulate(const Integrand& f, const Grid& grid, uint64_t first, uint64_t last, unsigned order,
+                           ExactSum& sum) {
+        if (order == 0) {
+            order = kDefaultGaussLegendreOrder;
+        }
+        order = std::min(std::max(order, quadrature::kGaussLegendreMinOrder), quadrature::kGaussLegendreMaxOrder);
+        switch (order) {
+            case 2:  return accumulate_order<2>(f, grid, first, last, sum);
+            case 3:  return accumulate_order<3>(f, grid, first, last, sum);
+            case 4:  return accumulate_order<4>(f, grid, first, last, sum);
+            case 5:  return accumulate_order<5>(f, grid, first, last, sum);
+            case 6:  return accumulate_order<6>(f, grid, first, last, sum);
+            case 7:  return accumulate_order<7>(f, grid, first, last, sum);
+            case 8:  return accumulate_order<8>(f, grid, first, last, sum);
+            case 9:  return accumulate_order<9>(f, grid, first, last, sum);
+            case 10: return accumulate_order<10>(f, grid, first, last, sum);
+            case 11: return accumulate_order<11>(f, grid, first, last, sum);
+            case 12: return accumulate_order<12>(f, grid, first, last, sum);
+            case 13: return accumulate_order<13>(f, grid, first, last, sum);
+            case 14: return accumulate_order<14>(f, grid, first, last, sum);
+            case 15: return accumulate_order<15>(f, grid, first, last, sum);
+            default: return accumulate_order<16>(f, grid, first, last, sum);
+        }
+    }
+};
+
+template<>
+struct MethodKernel<IntegrationMethod::TanhSinh> {
+    static void accumulate(const Integrand& f, const Grid& grid, uint64_t first, uint64_t last, unsigned order,
+                           ExactSum& sum) {
+        composite(f, tanh_sinh_rule(order), grid, first, last, sum);
+    }
+};
+
+/**
+ * @brief Применяет формулу Гаусса-Кронрода к отрезку [a, b].
+ *
+ * Все узлы вычисляются одной пачкой векторного ядра; узлы левее особой
+ * точки дают нулевой вклад. Оценка погрешности - как в QUADPACK (qk15/qk21).
+ */
+template<std::size_t NK, std::size_t NG>
+Estimate apply_kronrod(const Integrand& f_integrand, const quadrature::KronrodRule<NK, NG>& rule, double a, double b) {
+    constexpr std::size_t points = 2 * NK - 1;
+    const double center = 0.5 * (a + b);
+    const double half_length = 0.5 * (b - a);
+
+    double x[points];
+    double f[points];
+    for (std::size_t k = 0; k + 1 < NK; ++k) {
+        x[2 * k] = center - half_length * rule.nodes[k];
+        x[2 * k + 1] = center + half_length * rule.nodes[k];
+    }
+    x[points - 1] = center;
+
+    f_integrand.values(f_integrand.params, x, f, points);
+    if (a <= f_integrand.threshold) {
+        for (std::size_t k = 0; k < points; ++k) {
+            if (x[k] <= f_integrand.threshold) {
+                f[k] = 0.0;
+            }
+        }
+    }
+
+    const double f_center = f[points - 1];
+    double kronrod = rule.kronrod_weights[NK - 1] * f_center;
+    double gauss = rule.gauss_weights[NG - 1] * f_center;
+    double abs_sum = rule.kronrod_weights[NK - 1] * std::abs(f_center);
+    for (std::size_t k = 0; k + 1 < NK; ++k) {
+        double pair = f[2 * k] + f[2 * k + 1];
+        kronrod += rule.kronrod_weights[k] * pair;
+        abs_sum += rule.kronrod_weights[k] * (std::abs(f[2 * k]) + std::abs(f[2 * k + 1]));
+        // Узлы Гаусса совпадают с нечетными узлами Кронрода
+        if (k % 2 == 1) {
+            gauss += rule.gauss_weights[k / 2] * pair;
+        }
+    }
+
+    const double mean = 0.5 * kronrod;
+    double deviation = rule.kronrod_weights[NK - 1] * std::abs(f_center - mean);
+    for (std::size_t k = 0; k + 1 < NK; ++k) {
+        deviation += rule.kronrod_weights[k] * (std::abs(f[2 * k] - mean) + std::abs(f[2 * k + 1] - mean));
+    }
+
+    Estimate estimate;
+    estimate.value = kronrod * half_length;
+    estimate.error = std::abs((kronrod - gauss) * half_length);
+    deviation *= std::abs(half_length);
+    abs_sum *= std::abs(half_length);
+    if (deviation != 0.0 && estimate.error != 0.0) {
+        estimate.error = deviation * std::min(1.0, std::pow(200.0 * estimate.error / deviation, 1.5));
+    }
+    constexpr double epsilon = std::numeric_limits<double>::epsilon();
+    if (abs_sum > std::numeric_limits<double>::min() / (50.0 * epsilon)) {
+        estimate.error = std::max(50.0 * epsilon * abs_sum, estimate.error);
+    }
+    return estimate;
+}
+
+/**
+ * @brief Глобально адаптивное интегрирование: всегда делится отрезок с наибольшей погрешностью.
+ */
+template<std::size_t NK, std::size_t NG>
+Estimate adaptive_kronrod(const Integrand& f, const quadrature::KronrodRule<NK, NG>& rule,
+                          double lower_bound, double upper_bound,
+                          double abs_tol, double rel_tol, std::size_t max_intervals) {
+    struct Segment {
+        double a;
+        double b;
+        Estimate estimate;
+    };
+    auto by_error = [](const Segment& lhs, const Segment& rhs) {
+        return lhs.estimate.error < rhs.estimate.error;
+    };
+    std::priority_queue<Segment, std::vector<Segment>, decltype(by_error)> heap(by_error);
+
+    Estimate total = apply_kronrod(f, rule, lower_bound, upper_bound);
+    heap.push({lower_bound, upper_bound, total});
+
+    while (total.error > std::max(abs_tol, rel_tol * std::abs(total.value)) && heap.size() < max_intervals) {
+        Segment worst = heap.top();
+        double middle = 0.5 * (worst.a + worst.b);
+        if (!(worst.a < middle && middle < worst.b)) {
+            break; // Отрезок больше нельзя разделить в double
+        }
+        heap.pop();
+
+        Segment left{worst.a, middle, apply_kronrod(f, rule, worst.a, middle)};
+        Segment right{middle, worst.b, apply_kronrod(f, rule, middle, worst.b)};
+        total.value += left.estimate.value + right.estimate.value - worst.estimate.value;
+        total.error += left.estimate.error + right.estimate.error - worst.estimate.error;
+        heap.push(left);
+        heap.push(right);
+    }
+
+    // Пересуммируем, чтобы не копить ошибки округления от инкрементных обновлений
+    total = Estimate{};
+    while (!heap.empty()) {
+        total.value += heap.top().estimate.value;
+        total.error += heap.top().estimate.error;
+        heap.pop();
+    }
+    return total;
+}
+
+/**
+ * @brief Добавляет в sum вклад панелей [first, last) сетки составной формулой метода method.
+ */
+void accumulate_composite(const Integrand& f, IntegrationMethod method, unsigned order, const Grid& grid,
+                          uint64_t first, uint64_t last, ExactSum& sum) {
+    switch (method) {
+        case IntegrationMethod::Simpson:
+            return MethodKernel<IntegrationMethod::Simpson>::accumulate(f, grid, first, last, order, sum);
+        case IntegrationMethod::GaussLegendre:
+            return MethodKernel<IntegrationMethod::GaussLegendre>::accumulate(f, grid, first, last, order, sum);
+        case IntegrationMethod::TanhSinh:
+            return MethodKernel<IntegrationMethod::TanhSinh>::accumulate(f, grid, first, last, order, sum);
+        default:
+            break;
+    }
+    MethodKernel<IntegrationMethod::Midpoint>::accumulate(f, grid, first, last, order, sum);
+}
+
+/**
+ * @brief Составная формула метода method для функции f на всей сетке; методы без шага сюда не попадают.
+ */
+double integrate_composite(const Integrand& f, IntegrationMethod method, unsigned order,
+                           double lower_bound, double upper_bound, double step) {
+    const Grid grid = make_grid(lower_bound, upper_bound, step);
+    ExactSum sum;
+    accumulate_composite(f, method, order, grid, 0, grid.panels(), sum);
+    return sum.round();
+}
+
+/**
+ * @brief Адаптивный метод для функции f: G7K15 при points = 15, иначе G10K21.
+ */
+Estimate integrate_adaptive(const Integrand& f, unsigned points, double lower_bound, double upper_bound,
+                            double abs_tol, double rel_tol, std::size_t max_intervals) {
+    if (!(upper_bound - lower_bound > 0)) {
+        return Estimate{};
+    }
+    if (points == 15) {
+        return adaptive_kronrod(f, quadrature::kGaussKronrod15, lower_bound, upper_bound, abs_tol, rel_tol,
+                                max_intervals);
+    }
+    return adaptive_kronrod(f, quadrature::kGaussKronrod21, lower_bound, upper_bound, abs_tol, rel_tol,
+                            max_intervals);
+}
+
+} // namespace
+
+double integrate_function(double x) {
+    if (x <= kSingularThreshold) {
+        // Возвращаем 0 для точек, где функция не определена
+        return 0.0;
+    }
+    return integrands::InvLog<simd::Scalar>(IntegrandParams{}).eval(x);
+}
+
+double integrate_midpoint(double lower_bound, double upper_bound, double step) {
+    return integrate_range(IntegrationMethod::Midpoint, 0, lower_bound, upper_bound, step);
+}
+
+double integrate_range(IntegrationMethod method, unsigned order,
+                       double lower_bound, double upper_bound, double step) {
+    IntegrationTask task;
+    task.lower_bound = lower_bound;
+    task.upper_bound = upper_bound;
+    task.step = step;
+    task.task_id = 0;
+    task.method = method;
+    task.order = order;
+    task.rel_tol = method == IntegrationMethod::AdaptiveGaussKronrod ? kDefaultRelTol : 0.0;
+    return integrate_task(task, lower_bound, upper_bound, 0.0).value;
+}
+
+Estimate integrate_adaptive(unsigned points, double lower_bound, double upper_bound,
+                            double abs_tol, double rel_tol, std::size_t max_intervals) {
+    return integrate_adaptive(make_integrand(IntegrandId::InvLog, IntegrandParams{}), points, lower_bound, upper_bound,
+                              abs_tol, rel_tol, max_intervals);
+}
+
+Estimate integrate_task(const IntegrationTask& task, double lower_bound, double upper_bound, double abs_tol) {
+    if (!(upper_bound - lower_bound > 0) || (!(task.step > 0) && method_uses_step(task.method))) {
+        return Estimate{};
+    }
+    if (task.principal_value && task.integrand == IntegrandId::InvLog) {
+        // Особенность вычтена: сингулярную часть добавляет вызывающий код один раз на весь диапазон
+        return integrate_remainder(task.method, task.order, lower_bound, upper_bound, task.step, abs_tol,
+                                   task.rel_tol);
+    }
+
+    // Функция выбирается здесь, один раз на задачу
+    const IntegrandParams params = resolve_params(task.integrand, task.params);
+    switch (task.method) {
+        case IntegrationMethod::Midpoint:
+        case IntegrationMethod::Simpson:
+        case IntegrationMethod::GaussLegendre:
+        case IntegrationMethod::TanhSinh:
+            break;
+        case IntegrationMethod::ClosedForm: {
+            Estimate estimate;
+            if (integrate_closed_form(task.integrand, params, lower_bound, upper_bound, estimate.value)) {
+                return estimate;
+            }
+            // Точной формулы нет: считаем адаптивным методом
+            return integrate_adaptive(make_integrand(task.integrand, params), 0, lower_bound, upper_bound, abs_tol,
+                                      kDefaultRelTol, kDefaultMaxIntervals);
+        }
+        case IntegrationMethod::AdaptiveGaussKronrod:
+            return integrate_adaptive(make_integrand(task.integrand, params), task.order, lower_bound, upper_bound,
+                                      abs_tol, task.rel_tol, kDefaultMaxIntervals);
+        case IntegrationMethod::Chebyshev:
+            return chebyshev::SurrogateCache::shared(task.integrand, params)
+                ->integrate(lower_bound, upper_bound, task.rel_tol);
+    }
+    Estimate estimate;
+    estimate.value = integrate_composite(make_integrand(task.integrand, params), task.method, task.order,
+                                         lower_bound, upper_bound, task.step);
+    return estimate;
+}
+
+uint64_t grid_panels(double lower_bound, double upper_bound, double step) {
+    if (!(upper_bound - lower_bound > 0) || !(step > 0)) {
+        return 0;
+    }
+    return make_grid(lower_bound, upper_bound, step).panels();
+}
+
+std::vector<uint64_t> split_panels(uint64_t first_panel, uint64_t last_panel, std::size_t parts) {
+    std::vector<uint64_t> bounds{first_panel};
+    if (first_panel >= last_panel) {
+        return bounds;
+    }
+    parts = std::max<std::size_t>(parts, 1);
+    const uint64_t count = last_panel - first_panel;
+    for (std::size_t i = 1; i < parts; ++i) {
+        uint64_t bound = first_panel + count / parts * i + count % parts * i / parts;
+        // Граница выравнивается по глобальной сетке, а не по началу диапазона
+        bound = (bound + kReductionBlock - 1) / kReductionBlock * kReductionBlock;
+        if (bound > bounds.back() && bound < last_panel) {
+            bounds.push_back(bound);
+        }
+    }
+    bounds.push_back(last_panel);
+    return bounds;
+}
+
+void accumulate_task(const IntegrationTask& task, uint64_t first_panel, uint64_t last_panel, ExactSum& sum) {
+    if (!method_uses_step(task.method)) {
+        return;
+    }
+    const uint64_t panels = grid_panels(task.lower_bound, task.upper_bound, task.step);
+    last_panel = std::min(last_panel, panels);
+    if (first_panel >= last_panel) {
+        return;
+    }
+    // При вычитании особенности интегрируется гладкий остаток (см. integrate_task)
+    const Integrand f = task.principal_value && task.integrand == IntegrandId::InvLog
+                            ? make_integrand(IntegrandId::InvLogRemainder, IntegrandParams{})
+                            : make_integrand(task.integrand, resolve_params(task.integrand, task.params));
+    accumulate_composite(f, task.method, task.order, make_grid(task.lower_bound, task.upper_bound, task.step),
+                         first_panel, last_panel, sum);
+}
+
+uint64_t task_evaluations(const IntegrationTask& task) {
+    if (!method_uses_step(task.method) || !(task.step > 0.0) || !(task.upper_bound > task.lower_bound)) {
+        return 0;
+    }
+    const uint64_t panels = grid_panels(task.lower_bound, task.upper_bound, task.step);
+    const uint64_t last_panel = task.last_panel > 0 ? std::min(task.last_panel, panels) : panels;
+    const uint64_t task_panels = last_panel > task.first_panel ? last_panel - task.first_panel : 0;
+
+    uint64_t nodes = 1;
+    switch (task.method) {
+        case IntegrationMethod::Simpson:
+            nodes = 2;
+            break;
+        case IntegrationMethod::GaussLegendre: {
+            const unsigned order = task.order == 0 ? kDefaultGaussLegendreOrder : task.order;
+            nodes = std::min(std::max(order, quadrature::kGaussLegendreMinOrder), quadrature::kGaussLegendreMaxOrder);
+            break;
+        }
+        case IntegrationMethod::TanhSinh:
+            nodes = tanh_sinh_rule(task.order).offsets.size();
+            break;
+        default:
+            break;
+    }
+    return task_panels * nodes;
+}
+
+bool integrate_closed_form(IntegrandId integrand, const IntegrandParams& params,
+                           double lower_bound, double upper_bound, double& value) {
+    switch (integrand) {
+        case IntegrandId::InvLog:
+            value = special::log_integral_difference(lower_bound, upper_bound);
+            return true;
+        case IntegrandId::PowerOverLog:
+            // Замена t = x^p
+            value = special::log_integral_difference(std::pow(lower_bound, params[0]),
+                                                     std::pow(upper_bound, params[0]));
+            return true;
+        case IntegrandId::Gaussian: {
+            const double root = std::sqrt(params[0]);
+            value = 0.5 * std::sqrt(kPi / params[0]) * (std::erf(root * upper_bound) - std::erf(root * lower_bound));
+            return true;
+        }
+        case IntegrandId::InvLogRemainder:
+        case IntegrandId::ExpOverX:
+            break;
+    }
+    return false;
+}
+
+double singular_part(double lower_bound, double upper_bound) {
+    // При x <= 0 подынтегральная функция не определена: область начинается с 0
+    lower_bound = std::max(lower_bound, 0.0);
+    if (!(upper_bound > lower_bound)) {
+        return 0.0;
+    }
+    return std::log(std::abs(upper_bound - 1.0)) - std::log(std::abs(lower_bound - 1.0));
+}
+
+Estimate integrate_remainder(IntegrationMethod method, unsigned order, double lower_bound, double upper_bound,
+                             double step, double abs_tol, double rel_tol) {
+    if (!(upper_bound - lower_bound > 0)) {
+        return Estimate{};
+    }
+    const Integrand remainder = make_integrand(IntegrandId::InvLogRemainder, IntegrandParams{});
+    if (!method_uses_step(method)) {
+        // Остаток гладкий, поэтому методам без шага достаточно адаптивной квадратуры
+        if (!(abs_tol > 0) && !(rel_tol > 0)) {
+            rel_tol = kDefaultRelTol;
+        }
+        unsigned points = method == IntegrationMethod::AdaptiveGaussKronrod ? order : 0;
+        return integrate_adaptive(remainder, points, lower_bound, upper_bound, abs_tol, rel_tol,
+                                  kDefaultMaxIntervals);
+    }
+    Estimate estimate;
+    if (step > 0) {
+        estimate.value = integrate_composite(remainder, method, order, lower_bound, upper_bound, step);
+    }
+    return estimate;
+}
+
+Estimate integrate_principal_value(IntegrationMethod method, unsigned order, double lower_bound, double upper_bound,
+                                   double step, double abs_tol, double rel_tol) {
+    Estimate estimate = integrate_remainder(method, order, lower_bound, upper_bound, step, abs_tol, rel_tol);
+    estimate.value += singular_part(lower_bound, upper_bound);
+    return estimate;
+}
+
+Estimate integrate_chebyshev(double lower_bound, double upper_bound, double rel_tol) {
+    return chebyshev::SurrogateCache::shared()->integrate(lower_bound, upper_bound, rel_tol);
+}
+
+const IntegrandInfo& integrand_info(IntegrandId integrand) {
+    static const std::array<IntegrandInfo, kIntegrandCount> info = make_info(integrands::Registry{});
+    const auto index = static_cast<unsigned>(integrand);
+    return info[index < kIntegrandCount ? index : 0];
+}
+
+IntegrandParams resolve_params(IntegrandId integrand, const std::vector<double>& params) {
+    const IntegrandInfo& info = integrand_info(integrand);
+    IntegrandParams resolved = info.defaults;
+    for (std::size_t i = 0; i < info.param_count && i < params.size(); ++i) {
+        resolved[i] = params[i];
+    }
+    return resolved;
+}
+
+void integrand_values(IntegrandId integrand, const IntegrandParams& params, const double* x, double* y,
+                      std::size_t n) {
+    const Integrand f = make_integrand(integrand, params);
+    f.values(f.params, x, y, n);
+    for (std::size_t i = 0; i < n; ++i) {
+        if (x[i] <= f.threshold) {
+            y[i] = 0.0;
+        }
+    }
+}
+
+IsaLevel active_isa() {
+    return active_table().load(std::memory_order_relaxed)->isa;
+}
+
+bool select_isa(IsaLevel level) {
+    const KernelTable* table = table_for(level);
+    if (table == nullptr || static_cast<int>(level) > static_cast<int>(best_isa_level(detect_cpu_features()))) {
+        return false;
+    }
+    active_table().store(table, std::memory_order_relaxed);
+    return true;
+}
+
+const char* kernel_isa_name() {
+    return isa_level_name(active_isa());
+}
+
+} // namespace kernels
@@ -0,0 +1,295 @@
+#pragma once
+
+#include "CpuFeatures.h"
+#include "DataStructures.h"
+#include "ExactSum.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Вычислительные ядра интегрирования функции 1/ln(x).
+ */
+namespace kernels {
+
+/**
+ * @brief Значение интеграла с оценкой абсолютной погрешности.
+ */
+struct Estimate {
+    double value = 0.0; ///< Значение интеграла
+    double error = 0.0; ///< Оценка абсолютной погрешности
+};
+
+/// Ограничение на число отрезков адаптивного метода по умолчанию.
+constexpr std::size_t kDefaultMaxIntervals = 100000;
+
+/// Относительный допуск адаптивного метода, когда допуски не заданы.
+constexpr double kDefaultRelTol = 1e-12;
+
+/// Точки не дальше этого порога от 1 дают нулевой вклад (|ln x| < 1e-10).
+constexpr double kSingularThreshold = 1.0 + 1e-10;
+
+/// Размер блока редукции в панелях; границы частей задания должны быть ему кратны.
+constexpr uint64_t kReductionBlock = 1024;
+
+/// Число частичных сумм внутри блока (не меньше ширины самого широкого вектора).
+constexpr uint64_t kReductionLanes = 8;
+
+/// Ревизия ядер: увеличивается с исправлением, меняющим результаты (кэш прежней ревизии отбрасывается).
+constexpr uint32_t kRevision = 1;
+
+/**
+ * @brief Вычисляет значение функции 1/ln(x) для интегрирования.
+ *
+ * @param x Точка, в которой вычисляется функция.
+ * @return Значение функции или 0.0 для особых случаев.
+ */
+double integrate_function(double x);
+
+/**
+ * @brief Интегрирует 1/ln(x) методом средних прямоугольников.
+ *
+ * Сетка задается целыми номерами шагов: i-я средняя точка равна
+ * lower_bound + (i + 0.5) * step, последний шаг укорачивается до upper_bound.
+ * Проверка области определения выполняется один раз на диапазон, после чего
+ * средние точки обрабатываются пачками векторным ядром.
+ *
+ * @param lower_bound Нижний предел интегрирования.
+ * @param upper_bound Верхний предел интегрирования.
+ * @param step Шаг интегрирования.
+ * @return Результат интегрирования.
+ */
+double integrate_midpoint(double lower_bound, double upper_bound, double step);
+
+/**
+ * @brief Интегрирует 1/ln(x) заданным методом.
+ *
+ * Диапазон делится на панели шириной step (последняя укорачивается до
+ * upper_bound), на каждой панели применяется формула метода. Для каждого
+ * узла формулы сумма по всем панелям вычисляется векторным ядром.
+ * Адаптивный метод игнорирует step и работает с допуском kDefaultRelTol;
+ * чтобы задать допуски, используйте integrate_adaptive. Метод ClosedForm
+ * вычисляет li(b) - li(a) (см. LogIntegral.h), метод Chebyshev - интеграл
+ * аппроксимации из общего кэша (см. integrate_chebyshev).
+ *
+ * @param method Метод интегрирования.
+ * @param order Параметр метода (0 - значение по умолчанию).
+ * @param lower_bound Нижний предел интегрирования.
+ * @param upper_bound Верхний предел интегрирования.
+ * @param step Ширина панели.
+ * @return Результат интегрирования.
+ */
+double integrate_range(IntegrationMethod method, unsigned order,
+                       double lower_bound, double upper_bound, double step);
+
+/**
+ * @brief Глобально адаптивное интегрирование 1/ln(x) формулой Гаусса-Кронрода.
+ *
+ * Отрезки хранятся в куче по оценке погрешности; на каждом шаге делится
+ * пополам отрезок с наибольшей погрешностью, пока суммарная оценка не станет
+ * меньше max(abs_tol, rel_tol * |I|) или не будет достигнут предел отрезков.
+ *
+ * @param points Число узлов Кронрода: 15 (G7K15) или 21 (G10K21, по умолчанию).
+ * @param lower_bound Нижний предел интегрирования.
+ * @param upper_bound Верхний предел интегрирования.
+ * @param abs_tol Допустимая абсолютная погрешность.
+ * @param rel_tol Допустимая относительная погрешность.
+ * @param max_intervals Максимальное число отрезков.
+ * @return Значение интеграла и оценка погрешности.
+ */
+Estimate integrate_adaptive(unsigned points, double lower_bound, double upper_bound,
+                            double abs_tol, double rel_tol,
+                            std::size_t max_intervals = kDefaultMaxIntervals);
+
+/**
+ * @brief Интеграл выделенной особенности: v.p. ∫[a, b] dx / (x - 1) = ln|b - 1| - ln|a - 1|.
+ *
+ * Вместе с интегралом гладкого остатка (integrate_remainder) дает интеграл
+ * 1/ln(x), в том числе в смысле главного значения через x = 1. Точки x <= 0
+ * вне области определения: нижний предел ограничивается нулем.
+ *
+ * @param lower_bound Нижний предел интегрирования.
+ * @param upper_bound Верхний предел интегрирования.
+ * @return Значение интеграла (±inf, если предел равен 1).
+ */
+double singular_part(double lower_bound, double upper_bound);
+
+/**
+ * @brief Интегрирует гладкий остаток g(x) = 1/ln(x) - 1/(x - 1) при x > 0.
+ *
+ * g(x) аналитична в x = 1 (g(1) = 1/2), поэтому обычные шаги дают полную
+ * точность и у особой точки. Методы 0-3 применяют свою составную формулу
+ * с шагом step, остальные методы - адаптивный Гаусс-Кронрод с допусками.
+ *
+ * @param method Метод интегрирования.
+ * @param order Параметр метода (0 - значение по умолчанию).
+ * @param lower_bound Нижний предел интегрирования.
+ * @param upper_bound Верхний предел интегрирования.
+ * @param step Ширина панели (методы 0-3).
+ * @param abs_tol Допустимая абсолютная погрешность (методы без шага).
+ * @param rel_tol Допустимая относительная погрешность (методы без шага).
+ * @return Значение интеграла и оценка погрешности (0 для составных формул).
+ */
+Estimate integrate_remainder(IntegrationMethod method, unsigned order, double lower_bound, double upper_bound,
+                             double step, double abs_tol, double rel_tol);
+
+/**
+ * @brief Интегрирует 1/ln(x) с вычитанием особенности: singular_part + integrate_remainder.
+ *
+ * При lower_bound < 1 < upper_bound результат - интеграл в смысле главного значения.
+ * Параметры - как у integrate_remainder.
+ */
+Estimate integrate_principal_value(IntegrationMethod method, unsigned order, double lower_bound, double upper_bound,
+                                   double step, double abs_tol, double rel_tol);
+
+/**
+ * @brief Интегрирует 1/ln(x) по кусочной аппроксимации рядами Чебышёва.
+ *
+ * Коэффициенты берутся из кэша, общего для процесса, поэтому повторные и
+ * перекрывающиеся диапазоны не пересчитывают функцию (см. ChebyshevSurrogate.h).
+ *
+ * @param lower_bound Нижний предел интегрирования.
+ * @param upper_bound Верхний предел интегрирования.
+ * @param rel_tol Допуск хвоста ряда на ячейке (0 - значение по умолчанию).
+ * @return Значение интеграла и оценка погрешности.
+ */
+Estimate integrate_chebyshev(double lower_bound, double upper_bound, double rel_tol);
+
+/**
+ * @brief Описание подынтегральной функции из реестра (см. Integrands.h).
+ */
+struct IntegrandInfo {
+    IntegrandId id;           ///< Идентификатор
+    const char* name;         ///< Формула для журнала
+    unsigned param_count;     ///< Число параметров
+    IntegrandParams defaults; ///< Параметры по умолчанию
+    double domain_start;      ///< Точки не правее этой дают нулевой вклад
+};
+
+/**
+ * @brief Возвращает описание функции реестра.
+ */
+const IntegrandInfo& integrand_info(IntegrandId integrand);
+
+/**
+ * @brief Дополняет параметры задачи значениями по умолчанию.
+ *
+ * @param integrand Функция.
+ * @param params Параметры из задачи (лишние игнорируются).
+ * @return Полный набор параметров.
+ */
+IntegrandParams resolve_params(IntegrandId integrand, const std::vector<double>& params);
+
+/**
+ * @brief Вычисляет y[i] = f(x[i]) активным вариантом ядер; точки вне области дают 0.
+ *
+ * @param integrand Функция.
+ * @param params Параметры функции.
+ * @param x Точки.
+ * @param y Значения функции.
+ * @param n Число точек.
+ */
+void integrand_values(IntegrandId integrand, const IntegrandParams& params, const double* x, double* y,
+                      std::size_t n);
+
+/**
+ * @brief Интегрирует функцию задачи на [lower_bound, upper_bound] методом задачи.
+ *
+ * Функция и ее ядра выбираются один раз на вызов; внутренние циклы
+ * специализированы под функцию. При task.principal_value для 1/ln(x)
+ * возвращается только интеграл гладкого остатка (см. integrate_remainder).
+ *
+ * @param task Задача: функция, параметры, метод, шаг и допуски.
+ * @param lower_bound Нижний предел части задачи.
+ * @param upper_bound Верхний предел части задачи.
+ * @param abs_tol Допустимая абсолютная погрешность этой части.
+ * @return Значение интеграла и оценка погрешности (0 для составных формул).
+ */
+Estimate integrate_task(const IntegrationTask& task, double lower_bound, double upper_bound, double abs_tol);
+
+/**
+ * @brief Возвращает число панелей сетки: полные панели шириной step и укороченная последняя.
+ *
+ * @return 0 для пустого диапазона или неположительного шага.
+ * @throws std::invalid_argument Если диапазон бесконечен или число панелей не помещается в uint64_t.
+ */
+uint64_t grid_panels(double lower_bound, double upper_bound, double step);
+
+/**
+ * @brief Делит панели [first_panel, last_panel) на не более чем parts частей.
+ *
+ * Внутренние границы кратны kReductionBlock, поэтому суммы частей,
+ * сложенные точно, побитно совпадают с суммой всего диапазона.
+ *
+ * @return Границы частей: first_panel, ..., last_panel (пустых частей нет).
+ */
+std::vector<uint64_t> split_panels(uint64_t first_panel, uint64_t last_panel, std::size_t parts);
+
+/**
+ * @brief Добавляет в sum вклад панелей [first_panel, last_panel) сетки задачи.
+ *
+ * Сетка задается целыми номерами панелей на всем задании: узел k панели i
+ * равен task.lower_bound + (i + u_k) * task.step, последняя панель
+ * укорачивается до task.upper_bound. Суммирование идет блоками
+ * kReductionBlock, выровненными по номерам, и точно добавляется в sum.
+ * Поэтому при границах частей, кратных kReductionBlock (см. split_panels),
+ * сумма частей побитно совпадает с результатом для всей сетки при любом
+ * разбиении между потоками и клиентами и любом варианте ядер.
+ * Методы без шага ничего не добавляют.
+ *
+ * @param task Задача: функция, метод, шаг и границы всего задания.
+ * @param first_panel Первая панель части.
+ * @param last_panel Панель за последней панелью части.
+ * @param sum Точный накопитель.
+ */
+void accumulate_task(const IntegrationTask& task, uint64_t first_panel, uint64_t last_panel, ExactSum& sum);
+
+/**
+ * @brief Возвращает число вычислений функции в задаче метода с шагом.
+ *
+ * Панели задачи умножаются на число узлов панели (у Симпсона узлы на
+ * границах панелей общие, поэтому их два). Служит мерой объема работы
+ * при калибровке и оценке производительности клиентов.
+ *
+ * @return 0 для методов без шага: их объем заранее неизвестен.
+ */
+uint64_t task_evaluations(const IntegrationTask& task);
+
+/**
+ * @brief Вычисляет интеграл по точной формуле, если она известна для функции.
+ *
+ * 1/ln(x): li(b) - li(a); x^(p-1)/ln(x): li(b^p) - li(a^p);
+ * exp(-p x^2): sqrt(π/p)/2 (erf(√p b) - erf(√p a)).
+ *
+ * @param integrand Функция.
+ * @param params Параметры функции.
+ * @param lower_bound Нижний предел интегрирования.
+ * @param upper_bound Верхний предел интегрирования.
+ * @param value Значение интеграла.
+ * @return false, если точной формулы нет.
+ */
+bool integrate_closed_form(IntegrandId integrand, const IntegrandParams& params,
+                           double lower_bound, double upper_bound, double& value);
+
+/**
+ * @brief Возвращает уровень инструкций активного варианта ядер.
+ *
+ * При первом обращении выбирается лучший вариант, поддерживаемый процессором.
+ */
+IsaLevel active_isa();
+
+/**
+ * @brief Принудительно выбирает вариант ядер.
+ *
+ * @param level Требуемый уровень инструкций.
+ * @return false, если вариант не собран или не поддерживается процессором.
+ */
+bool select_isa(IsaLevel level);
+
+/**
+ * @brief Возвращает имя набора инструкций активного варианта ядер.
+ */
+const char* kernel_isa_name();
+
+} // namespace kernels
@@ -0,0 +1,129 @@
+#pragma once
+
+/**
+ * @brief Шаблонные реализации ядер, общие для всех вариантов набора инструкций.
+ *
+ * Заголовок включается только единицами трансляции ядер
+ * (IntegrationKernels*.cpp); каждая из них инстанцирует шаблоны со своим
+ * типом вектора.
+ */
+
+#include "Integrands.h"
+#include "IntegrationKernelsVariants.h"
+#include "SimdMath.h"
+
+#include <cstdint>
+
+namespace kernels {
+namespace detail {
+inline namespace SIMD_VARIANT_NAMESPACE {
+
+/**
+ * @brief Добавляет в sum взвешенную сумму weight * F(origin + (i + offset) * step) для i в [first, last).
+ *
+ * Смещение offset задает положение узла внутри панели шириной step:
+ * 0.5 для средних точек, узлы квадратурных формул для остальных методов.
+ * Все точки должны лежать в области определения F (правее F::domain_start).
+ *
+ * Порядок округлений определяется только номерами узлов: индексы делятся на
+ * блоки по kReductionBlock, выровненные по глобальной сетке; узел i попадает
+ * в частичную сумму i mod kReductionLanes, частичные суммы блока складываются
+ * фиксированным деревом, и блок точно добавляется в sum. Координата узла
+ * вычисляется заново из номера, а не накоплением шага. Поэтому при границах
+ * частей, кратных kReductionBlock, результат не зависит ни от разбиения
+ * диапазона, ни от ширины вектора V.
+ */
+template<template<class> class F, class V>
+void grid_accumulate(const IntegrandParams& params, double origin, double step, double offset,
+                     uint64_t first, uint64_t last, double weight, ExactSum& sum) {
+    using vec = typename V::vec;
+    static_assert(kReductionLanes == 8, "Дерево сложения блока рассчитано на восемь частичных сумм");
+    static_assert(kReductionLanes % V::width == 0, "Ширина вектора должна делить число частичных сумм");
+    constexpr uint64_t vectors = kReductionLanes / V::width;
+    const F<V> f(params);
+    const F<simd::Scalar> f_scalar(params);
+
+    const vec vorigin = V::set1(origin);
+    const vec vstep = V::set1(step);
+    const vec voffset = V::set1(offset);
+    const vec advance = V::set1(static_cast<double>(kReductionLanes));
+
+    for (uint64_t block = first - first % kReductionBlock; block < last; block += kReductionBlock) {
+        alignas(64) double lanes[kReductionLanes] = {};
+        if (block >= first && block + kReductionBlock <= last) {
+            vec acc[vectors];
+            for (uint64_t r = 0; r < vectors; ++r) {
+                acc[r] = V::zero();
+            }
+            // Номера узлов - целые числа в double (точно до 2^53); смещение добавляется
+            // одним округлением, как в скалярной ветви
+            vec index[vectors];
+            for (uint64_t r = 0; r < vectors; ++r) {
+                index[r] = V::iota(static_cast<double>(block + r * V::width));
+            }
+            // Четыре независимых вектора за итерацию скрывают задержку деления; значения
+            // складываются в аккумуляторы строго по порядку номеров
+            constexpr uint64_t unroll = vectors >= 4 ? 1 : 4 / vectors;
+            for (uint64_t group = 0; group < kReductionBlock; group += unroll * kReductionLanes) {
+                vec values[unroll][vectors];
+                for (uint64_t u = 0; u < unroll; ++u) {
+                    for (uint64_t r = 0; r < vectors; ++r) {
+                        values[u][r] = f.eval(V::fmadd(V::add(index[r], voffset), vstep, vorigin));
+                        index[r] = V::add(index[r], advance);
+                    }
+                }
+                for (uint64_t u = 0; u < unroll; ++u) {
+                    for (uint64_t r = 0; r < vectors; ++r) {
+                        acc[r] = V::add(acc[r], values[u][r]);
+                    }
+                }
+            }
+            for (uint64_t r = 0; r < vectors; ++r) {
+                V::storeu(lanes + r * V::width, acc[r]);
+            }
+        } else {
+            // Неполный блок на краю диапазона: те же дорожки, отсутствующие узлы дают ноль
+            const uint64_t begin = block < first ? first : block;
+            const uint64_t end = block + kReductionBlock < last ? block + kReductionBlock : last;
+            for (uint64_t i = begin; i < end; ++i) {
+                double x = simd::Scalar::fmadd(static_cast<double>(i) + offset, step, origin);
+                lanes[i % kReductionLanes] += f_scalar.eval(x);
+            }
+        }
+        double block_sum = ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) + ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7]));
+        sum.add(weight * block_sum);
+    }
+}
+
+/**
+ * @brief Вычисляет y[i] = F(x[i]) для произвольного набора точек.
+ *
+ * Используется адаптивными методами, где узлы не образуют регулярную сетку.
+ * Проверка области определения остается за вызывающим кодом.
+ */
+template<template<class> class F, class V>
+void grid_values(const IntegrandParams& params, const double* x, double* y, uint64_t n) {
+    const F<V> f(params);
+    const F<simd::Scalar> f_scalar(params);
+    uint64_t i = 0;
+    for (; i + V::width <= n; i += V::width) {
+        V::storeu(y + i, f.eval(V::loadu(x + i)));
+    }
+    for (; i < n; ++i) {
+        y[i] = f_scalar.eval(x[i]);
+    }
+}
+
+/**
+ * @brief Собирает точки входа варианта для всех функций реестра.
+ *
+ * Порядок элементов совпадает с IntegrandId (проверяется в Integrands.h).
+ */
+template<class V, template<class> class... F>
+VariantEntries make_entries(integrands::IntegrandList<F...>) {
+    return VariantEntries{{&grid_accumulate<F, V>...}, {&grid_values<F, V>...}};
+}
+
+} // inline namespace SIMD_VARIANT_NAMESPACE
+} // namespace detail
+} // namespace kernels
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "DataStructures.h"
+#include "ExactSum.h"
+#include "IntegrationKernels.h"
+
+#include <cstdint>
+
+/**
+ * @brief Точки входа вариантов ядер, собранных с разными наборами инструкций.
+ *
+ * Объявления не зависят от флагов компиляции; вызывать функции варианта
+ * можно только если процессор его поддерживает (см. CpuFeatures.h).
+ */
+namespace kernels {
+
+/// Взвешенная сумма функции по регулярной сетке узлов (см. detail::grid_accumulate).
+using GridSumFn = void (*)(const IntegrandParams& params, double origin, double step, double offset,
+                           uint64_t first, uint64_t last, double weight, ExactSum& sum);
+
+/// Значения функции в произвольных точках (см. detail::grid_values).
+using ValuesFn = void (*)(const IntegrandParams& params, const double* x, double* y, uint64_t n);
+
+/**
+ * @brief Точки входа одного варианта ядер, индексированные IntegrandId.
+ */
+struct VariantEntries {
+    GridSumFn sum[kIntegrandCount];
+    ValuesFn values[kIntegrandCount];
+};
+
+#define KERNELS_DECLARE_VARIANT(ns)                                                   \
+    namespace ns {                                                                   \
+    const VariantEntries& entries();                                                 \
+    }
+
+KERNELS_DECLARE_VARIANT(baseline)
+#if defined(KERNELS_X86_VARIANTS)
+KERNELS_DECLARE_VARIANT(avx2)
+KERNELS_DECLARE_VARIANT(avx512)
+#endif
+
+#undef KERNELS_DECLARE_VARIANT
+
+} // namespace kernels
@@ -0,0 +1,16 @@
+// Вариант ядер для AVX2 + FMA. Собирается с -mavx2 -mfma (см. common/CMakeLists.txt)
+// и вызывается только после проверки cpuid.
+#define SIMD_VARIANT_NAMESPACE avx2_variant
+#include "IntegrationKernelsImpl.h"
+#include "IntegrationKernelsVariants.h"
+
+namespace kernels {
+namespace avx2 {
+
+const VariantEntries& entries() {
+    static const VariantEntries table = detail::make_entries<simd::Avx2>(integrands::Registry{});
+    return table;
+}
+
+} // namespace avx2
+} // namespace kernels
@@ -0,0 +1,16 @@
+// Вариант ядер для AVX-512F. Собирается с -mavx512f -mavx2 -mfma (см. common/CMakeLists.txt)
+// и вызывается только после проверки cpuid.
+#define SIMD_VARIANT_NAMESPACE avx512_variant
+#include "IntegrationKernelsImpl.h"
+#include "IntegrationKernelsVariants.h"
+
+namespace kernels {
+namespace avx512 {
+
+const VariantEntries& entries() {
+    static const VariantEntries table = detail::make_entries<simd::Avx512>(integrands::Registry{});
+    return table;
+}
+
+} // namespace avx512
+} // namespace kernels
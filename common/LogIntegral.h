@@ -0,0 +1,34 @@
+#pragma once
+
+/**
+ * @brief Интегральный логарифм li(x) - первообразная функции 1/ln(x).
+ */
+namespace special {
+
+/**
+ * @brief Вычисляет интегральный логарифм li(x) = v.p. ∫[0, x] dt / ln(t).
+ *
+ * Для умеренных x используется быстро сходящийся ряд Рамануджана,
+ * для больших x (ln x >= 45) - асимптотическое разложение.
+ * При 0 < x < 1 и x > 1 погрешность порядка нескольких ulp.
+ *
+ * @param x Аргумент (x >= 0).
+ * @return li(x); -inf при x = 1, NaN при x < 0.
+ */
+double log_integral(double x);
+
+/**
+ * @brief Вычисляет ∫[a, b] dx / ln(x) = li(b) - li(a).
+ *
+ * Для интервала, пересекающего x = 1, результат - интеграл в смысле главного
+ * значения. Для узкого интервала вдали от x = 1 разность li(b) - li(a)
+ * теряет точность из-за сокращения, поэтому интеграл считается напрямую
+ * формулой Гаусса-Лежандра с 16 узлами.
+ *
+ * @param a Нижний предел (a > 0).
+ * @param b Верхний предел.
+ * @return Значение интеграла.
+ */
+double log_integral_difference(double a, double b);
+
+} // namespace special
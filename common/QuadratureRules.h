@@ -0,0 +1,191 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief Узлы и веса квадратурных формул на отрезке панели [0, 1].
+ *
+ * Узел задается смещением u ∈ [0, 1] внутри панели, поэтому формула на панели
+ * [x, x + h] равна h * Σ w_k f(x + u_k h).
+ */
+namespace quadrature {
+
+/// Допустимый диапазон числа узлов формулы Гаусса-Лежандра.
+constexpr unsigned kGaussLegendreMinOrder = 2;
+constexpr unsigned kGaussLegendreMaxOrder = 16;
+
+/// Допустимый диапазон уровня формулы tanh-sinh (шаг по t равен 2^-level).
+constexpr unsigned kTanhSinhMinLevel = 1;
+constexpr unsigned kTanhSinhMaxLevel = 6;
+
+/**
+ * @brief Узлы и веса формулы с N узлами на панели [0, 1].
+ */
+template<std::size_t N>
+struct PanelRule {
+    std::array<double, N> offsets{}; ///< Смещения узлов внутри панели
+    std::array<double, N> weights{}; ///< Веса узлов (сумма равна 1)
+};
+
+namespace detail {
+
+constexpr double kPi = 3.14159265358979323846;
+
+/**
+ * @brief constexpr-косинус на [0, π] рядом Тейлора (нужен только для начального приближения).
+ */
+constexpr double constexpr_cos(double x) {
+    double term = 1.0;
+    double sum = 1.0;
+    for (int k = 1; k < 40; ++k) {
+        term *= -x * x / ((2.0 * k - 1.0) * (2.0 * k));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr double constexpr_abs(double x) {
+    return x < 0 ? -x : x;
+}
+
+/**
+ * @brief Вычисляет P_n(x) и P_n'(x) по трехчленной рекурсии.
+ */
+constexpr void legendre(std::size_t n, double x, double& value, double& derivative) {
+    double p0 = 1.0;
+    double p1 = x;
+    for (std::size_t k = 2; k <= n; ++k) {
+        double p2 = ((2.0 * k - 1.0) * x * p1 - (k - 1.0) * p0) / static_cast<double>(k);
+        p0 = p1;
+        p1 = p2;
+    }
+    value = p1;
+    derivative = static_cast<double>(n) * (x * p1 - p0) / (x * x - 1.0);
+}
+
+} // namespace detail
+
+/**
+ * @brief Строит формулу Гаусса-Лежандра с N узлами на этапе компиляции.
+ *
+ * Корни P_N находятся методом Ньютона от приближения cos(π(k - 1/4)/(N + 1/2)).
+ */
+template<std::size_t N>
+constexpr PanelRule<N> make_gauss_legendre() {
+    PanelRule<N> rule;
+    for (std::size_t k = 0; k < N; ++k) {
+        double x = detail::constexpr_cos(detail::kPi * (static_cast<double>(k) + 0.75) / (N + 0.5));
+        double value = 0.0;
+        double derivative = 0.0;
+        for (int iteration = 0; iteration < 100; ++iteration) {
+            detail::legendre(N, x, value, derivative);
+            double dx = value / derivative;
+            x -= dx;
+            if (detail::constexpr_abs(dx) < 1e-17) {
+                break;
+            }
+        }
+        detail::legendre(N, x, value, derivative);
+        // Переход с [-1, 1] на [0, 1]: u = (1 + x) / 2, вес делится на 2
+        rule.offsets[N - 1 - k] = (1.0 + x) / 2.0;
+        rule.weights[N - 1 - k] = 1.0 / ((1.0 - x * x) * derivative * derivative);
+    }
+    return rule;
+}
+
+/**
+ * @brief Формула Гаусса-Лежандра с N узлами, вычисленная при компиляции.
+ */
+template<std::size_t N>
+inline constexpr PanelRule<N> kGaussLegendre = make_gauss_legendre<N>();
+
+/**
+ * @brief Пара формул Гаусса-Кронрода на отрезке [-1, 1].
+ *
+ * nodes содержит положительные узлы Кронрода по убыванию и центр 0 последним;
+ * узлы Гаусса - нечетные элементы nodes (и центр, если NK - 1 четно).
+ */
+template<std::size_t NK, std::size_t NG>
+struct KronrodRule {
+    std::array<double, NK> nodes;           ///< Узлы Кронрода (x >= 0)
+    std::array<double, NK> kronrod_weights; ///< Веса Кронрода
+    std::array<double, NG> gauss_weights;   ///< Веса Гаусса (последний - для центра)
+};
+
+/// Формула G7K15 (коэффициенты QUADPACK qk15).
+inline constexpr KronrodRule<8, 4> kGaussKronrod15 = {
+    {0.991455371120812639206854697526329, 0.949107912342758524526189684047851,
+     0.864864423359769072789712788640926, 0.741531185599394439863864773280788,
+     0.586087235467691130294144845693013, 0.405845151377397166906606412076961,
+     0.207784955007898467600689403773245, 0.000000000000000000000000000000000},
+    {0.022935322010529224963732008058970, 0.063092092629978553290700663189204,
+     0.104790010322250183839876322541518, 0.140653259715525918745189590510238,
+     0.169004726639267902826583426598550, 0.190350578064785409913256402421014,
+     0.204432940075298892414161999234649, 0.209482141084727828012999174891714},
+    {0.129484966168869693270611432679082, 0.279705391489276667901467771423780,
+     0.381830050505118944950369775488975, 0.417959183673469387755102040816327},
+};
+
+/// Формула G10K21 (коэффициенты QUADPACK qk21); у 10-точечной формулы Гаусса нет центрального узла.
+inline constexpr KronrodRule<11, 6> kGaussKronrod21 = {
+    {0.995657163025808080735527280689003, 0.973906528517171720077964012084452,
+     0.930157491355708226001207180059508, 0.865063366688984510732096688423493,
+     0.780817726586416897063717578345042, 0.679409568299024406234327365114874,
+     0.562757134668604683339000099272694, 0.433395394129247190799265943165784,
+     0.294392862701460198131126603103866, 0.148874338981631210884826001129720,
+     0.000000000000000000000000000000000},
+    {0.011694638867371874278064396062192, 0.032558162307964727478818972459390,
+     0.054755896574351996031381300244580, 0.075039674810919952767043140916190,
+     0.093125454583697605535065465083366, 0.109387158802297641899210590325805,
+     0.123491976262065851077208980297648, 0.134709217311473325928054001771707,
+     0.142775938577060080797094273138717, 0.147739104901338491374841515972068,
+     0.149445554002916905664936468389821},
+    {0.066671344308688137593568809893332, 0.149451349150580593145776339657697,
+     0.219086362515982043995534934228163, 0.269266719309996355091226921569469,
+     0.295524224714752870173892994651146, 0.0},
+};
+
+/**
+ * @brief Узлы и веса формулы tanh-sinh на панели [0, 1].
+ */
+struct TanhSinhRule {
+    std::vector<double> offsets; ///< Смещения узлов внутри панели
+    std::vector<double> weights; ///< Веса узлов
+};
+
+/**
+ * @brief Строит формулу tanh-sinh заданного уровня.
+ *
+ * Узлы u_k = 1 / (1 + exp(-π sinh(t_k))), t_k = k * 2^-level; это та же
+ * замена x = tanh(π/2 sinh t), записанная без потери точности у концов панели.
+ * Узлы с пренебрежимо малым весом отбрасываются.
+ *
+ * @param level Уровень (шаг по t равен 2^-level).
+ * @return Формула, веса которой в сумме дают 1.
+ */
+inline TanhSinhRule make_tanh_sinh(unsigned level) {
+    const double h = std::ldexp(1.0, -static_cast<int>(level));
+    TanhSinhRule rule;
+    for (int k = 0;; ++k) {
+        double t = k * h;
+        double y = detail::kPi / 2.0 * std::sinh(t);
+        double cosh_y = std::cosh(y);
+        double weight = h * (detail::kPi / 4.0) * std::cosh(t) / (cosh_y * cosh_y);
+        if (weight < 1e-20 || !std::isfinite(cosh_y)) {
+            break;
+        }
+        double right = 1.0 / (1.0 + std::exp(-2.0 * y));
+        rule.offsets.push_back(right);
+        rule.weights.push_back(weight);
+        if (k != 0) {
+            rule.offsets.push_back(1.0 / (1.0 + std::exp(2.0 * y)));
+            rule.weights.push_back(weight);
+        }
+    }
+    return rule;
+}
+
+} // namespace quadrature
@@ -0,0 +1,260 @@
+#include "ResultCache.h"
+
+#include "IntegrationKernels.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define RESULT_CACHE_MMAP 1
+#endif
+
+namespace {
+
+constexpr char kFileMagic[8] = {'I', 'N', 'T', 'C', 'A', 'C', 'H', 'E'};
+constexpr uint32_t kFileVersion = 2;
+
+/**
+ * @brief Заголовок файла кэша; за ним следуют записи.
+ */
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t slot_size; ///< Размер записи: меняется вместе с форматом ключа и ExactSum
+    uint64_t capacity;  ///< Число записей в файле
+    uint32_t kernel_revision; ///< kernels::kRevision ядер, вычисливших результаты
+    uint32_t reserved;
+};
+
+} // namespace
+
+bool ResultCache::Key::operator==(const Key& other) const {
+    return std::memcmp(this, &other, sizeof(Key)) == 0;
+}
+
+std::size_t ResultCache::KeyHash::operator()(const Key& key) const {
+    // FNV-1a по байтам ключа
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&key);
+    uint64_t hash = 14695981039346656037ull;
+    for (std::size_t i = 0; i < sizeof(Key); ++i) {
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    }
+    return static_cast<std::size_t>(hash);
+}
+
+ResultCache::ResultCache(std::size_t capacity)
+    : capacity_(std::max<std::size_t>(capacity, 1)) {
+    for (std::size_t slot = capacity_; slot > 0; --slot) {
+        free_slots_.push_back(slot - 1);
+    }
+}
+
+ResultCache::~ResultCache() {
+    close_file();
+}
+
+ResultCache::Key ResultCache::make_key(const IntegrationTask& task) {
+    static_assert(sizeof(Key) == 4 * sizeof(uint32_t) + (5 + kMaxIntegrandParams) * sizeof(double) +
+                                     2 * sizeof(uint64_t),
+                  "ключ кэша не должен содержать выравнивающих пропусков");
+    Key key;
+    std::memset(&key, 0, sizeof(key));
+    key.integrand = static_cast<uint32_t>(task.integrand);
+    key.method = static_cast<uint32_t>(task.method);
+    key.order = task.order;
+    key.principal_value = task.principal_value ? 1 : 0;
+    key.lower_bound = task.lower_bound;
+    key.upper_bound = task.upper_bound;
+    key.step = task.step;
+    key.abs_tol = task.abs_tol;
+    key.rel_tol = task.rel_tol;
+    const IntegrandParams params = kernels::resolve_params(task.integrand, task.params);
+    std::copy(params.begin(), params.end(), key.params);
+    key.first_panel = task.first_panel;
+    key.last_panel = task.last_panel;
+    return key;
+}
+
+bool ResultCache::lookup(const IntegrationTask& task, IntegrationResult& result) {
+    const Key key = make_key(task);
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto found = index_.find(key);
+    if (found == index_.end()) {
+        ++misses_;
+        return false;
+    }
+    ++hits_;
+    entries_.splice(entries_.begin(), entries_, found->second);
+    touch(*found->second);
+    result = found->second->result;
+    result.task_id = task.task_id;
+    return true;
+}
+
+void ResultCache::store(const IntegrationTask& task, const IntegrationResult& result) {
+    const Key key = make_key(task);
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto found = index_.find(key);
+    if (found != index_.end()) {
+        found->second->result = result;
+        entries_.splice(entries_.begin(), entries_, found->second);
+        write_slot(*found->second);
+        return;
+    }
+
+    if (free_slots_.empty()) {
+        // Вытесняется давно не использованный результат, его запись в файле переиспользуется
+        free_slots_.push_back(entries_.back().slot);
+        index_.erase(entries_.back().key);
+        entries_.pop_back();
+    }
+    entries_.push_front(Entry{key, result, free_slots_.back()});
+    free_slots_.pop_back();
+    index_[key] = entries_.begin();
+    write_slot(entries_.front());
+}
+
+ResultCacheStats ResultCache::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ResultCacheStats stats;
+    stats.hits = hits_;
+    stats.misses = misses_;
+    stats.entries = entries_.size();
+    stats.capacity = capacity_;
+    stats.persistent = mapping_ != nullptr;
+    return stats;
+}
+
+void ResultCache::touch(const Entry& entry) {
+    if (mapping_ == nullptr) {
+        return;
+    }
+    Slot* slots = reinterpret_cast<Slot*>(static_cast<char*>(mapping_) + sizeof(FileHeader));
+    slots[entry.slot].stamp = ++clock_;
+}
+
+void ResultCache::write_slot(const Entry& entry) {
+    if (mapping_ == nullptr) {
+        return;
+    }
+    static_assert(std::is_trivially_copyable<Slot>::value, "запись файла кэша копируется побайтно");
+    Slot slot{};
+    slot.key = entry.key;
+    slot.result = entry.result.result;
+    slot.error_estimate = entry.result.error_estimate;
+    slot.sum = entry.result.sum.raw();
+    Slot* slots = reinterpret_cast<Slot*>(static_cast<char*>(mapping_) + sizeof(FileHeader));
+
+    // Запись публикуется штампом последней: прерванная на середине запись остается свободной
+    Slot& target = slots[entry.slot];
+    target.stamp = 0;
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(&target, &slot, sizeof(slot));
+    std::atomic_thread_fence(std::memory_order_release);
+    target.stamp = ++clock_;
+}
+
+bool ResultCache::open_file(const std::string& path) {
+#if defined(RESULT_CACHE_MMAP)
+    std::lock_guard<std::mutex> lock(mutex_);
+    close_file();
+
+    const int file = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (file < 0) {
+        return false;
+    }
+    // Файлом владеет один процесс: занятый другим файл не отображается
+    if (::flock(file, LOCK_EX | LOCK_NB) != 0) {
+        ::close(file);
+        return false;
+    }
+    const std::size_t size = sizeof(FileHeader) + capacity_ * sizeof(Slot);
+    struct stat info;
+    if (::fstat(file, &info) != 0) {
+        ::close(file);
+        return false;
+    }
+    bool valid = static_cast<std::size_t>(info.st_size) == size;
+    if (!valid && ::ftruncate(file, 0) != 0) {
+        ::close(file);
+        return false;
+    }
+    if (!valid && ::ftruncate(file, static_cast<off_t>(size)) != 0) {
+        ::close(file);
+        return false;
+    }
+    void* mapping = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+    if (mapping == MAP_FAILED) {
+        ::close(file);
+        return false;
+    }
+
+    FileHeader* header = static_cast<FileHeader*>(mapping);
+    valid = valid && std::memcmp(header->magic, kFileMagic, sizeof(kFileMagic)) == 0 &&
+            header->version == kFileVersion && header->slot_size == sizeof(Slot) && header->capacity == capacity_ &&
+            header->kernel_revision == kernels::kRevision;
+    Slot* slots = reinterpret_cast<Slot*>(static_cast<char*>(mapping) + sizeof(FileHeader));
+    if (!valid) {
+        // Новый или несовместимый файл: все записи свободны
+        std::memset(mapping, 0, size);
+        std::memcpy(header->magic, kFileMagic, sizeof(kFileMagic));
+        header->version = kFileVersion;
+        header->slot_size = sizeof(Slot);
+        header->capacity = capacity_;
+        header->kernel_revision = kernels::kRevision;
+    }
+
+    // Результаты, уже бывшие в памяти, уступают сохраненным в файле
+    entries_.clear();
+    index_.clear();
+    free_slots_.clear();
+    std::vector<std::pair<uint64_t, std::size_t>> used;
+    for (std::size_t i = 0; i < capacity_; ++i) {
+        if (slots[i].stamp != 0 && ExactSum::valid(slots[i].sum)) {
+            used.emplace_back(slots[i].stamp, i);
+        } else {
+            // Испорченная запись освобождается
+            slots[i].stamp = 0;
+            free_slots_.push_back(i);
+        }
+    }
+    std::reverse(free_slots_.begin(), free_slots_.end());
+    std::sort(used.begin(), used.end());
+    clock_ = used.empty() ? 0 : used.back().first;
+    for (const auto& pair : used) {
+        const Slot& slot = slots[pair.second];
+        IntegrationResult result{slot.result, 0, slot.error_estimate, ExactSum::from_raw(slot.sum)};
+        entries_.push_front(Entry{slot.key, result, pair.second});
+        index_[slot.key] = entries_.begin();
+    }
+
+    mapping_ = mapping;
+    mapping_size_ = size;
+    file_ = file;
+    return true;
+#else
+    (void)path;
+    return false;
+#endif
+}
+
+void ResultCache::close_file() {
+#if defined(RESULT_CACHE_MMAP)
+    if (mapping_ != nullptr) {
+        ::msync(mapping_, mapping_size_, MS_SYNC);
+        ::munmap(mapping_, mapping_size_);
+        ::close(file_);
+    }
+#endif
+    mapping_ = nullptr;
+    mapping_size_ = 0;
+    file_ = -1;
+}
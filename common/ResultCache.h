@@ -0,0 +1,147 @@
+#pragma once
+
+#include "DataStructures.h"
+#include "ExactSum.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Счетчики кэша результатов.
+ */
+struct ResultCacheStats {
+    std::size_t hits = 0;     ///< Задачи, результат которых взят из кэша
+    std::size_t misses = 0;   ///< Задачи, вычисленные заново
+    std::size_t entries = 0;  ///< Результатов в кэше сейчас
+    std::size_t capacity = 0; ///< Предел числа результатов
+    bool persistent = false;  ///< Кэш отображен на файл
+};
+
+/**
+ * @brief Кэш результатов задач с вытеснением давно не использованных (LRU).
+ *
+ * Ключ - каноническое описание задачи: функция и ее параметры (с
+ * подставленными значениями по умолчанию), метод и его параметр, границы,
+ * шаг, допуски, вычитание особенности и диапазон панелей. Номера задачи и
+ * запроса в ключ не входят, поэтому повторно присланный поддиапазон
+ * находится при любом номере. Результат хранится вместе с точной суммой,
+ * поэтому попадание не меняет итог сервера даже в последнем бите.
+ *
+ * Кэш можно отобразить на файл (open_file()): записи и их порядок
+ * использования пишутся прямо в отображенную память и переживают
+ * перезапуск процесса. Отображение файлов поддерживается на POSIX-системах.
+ */
+class ResultCache {
+public:
+    /**
+     * @brief Создает пустой кэш в памяти.
+     *
+     * @param capacity Предел числа результатов (0 заменяется на 1).
+     */
+    explicit ResultCache(std::size_t capacity);
+
+    /**
+     * @brief Сбрасывает отображенный файл на диск и закрывает его.
+     */
+    ~ResultCache();
+
+    ResultCache(const ResultCache&) = delete;
+    ResultCache& operator=(const ResultCache&) = delete;
+
+    /**
+     * @brief Отображает кэш на файл и загружает сохраненные в нем результаты.
+     *
+     * Файл другого формата, емкости или ревизии ядер перезаписывается пустым.
+     * Файл блокируется (flock) на время работы кэша.
+     *
+     * @param path Путь к файлу (создается при отсутствии).
+     * @return false, если файл не удалось открыть, заблокировать или отобразить
+     *         (кэш остается в памяти).
+     */
+    bool open_file(const std::string& path);
+
+    /**
+     * @brief Ищет результат задачи.
+     *
+     * @param task Задача.
+     * @param result Найденный результат с номером задачи task.task_id.
+     * @return false при промахе.
+     */
+    bool lookup(const IntegrationTask& task, IntegrationResult& result);
+
+    /**
+     * @brief Сохраняет результат задачи, вытесняя давно не использованный при переполнении.
+     */
+    void store(const IntegrationTask& task, const IntegrationResult& result);
+
+    /**
+     * @brief Возвращает счетчики попаданий и промахов.
+     */
+    ResultCacheStats stats() const;
+
+private:
+    /**
+     * @brief Каноническое описание задачи; без выравнивающих пропусков, сравнивается побайтно.
+     */
+    struct Key {
+        uint32_t integrand;
+        uint32_t method;
+        uint32_t order;
+        uint32_t principal_value;
+        double lower_bound;
+        double upper_bound;
+        double step;
+        double abs_tol;
+        double rel_tol;
+        double params[kMaxIntegrandParams];
+        uint64_t first_panel;
+        uint64_t last_panel;
+
+        bool operator==(const Key& other) const;
+    };
+
+    struct KeyHash {
+        std::size_t operator()(const Key& key) const;
+    };
+
+    /**
+     * @brief Запись файла кэша (stamp == 0 - свободна).
+     */
+    struct Slot {
+        uint64_t stamp; ///< Время последнего использования по часам кэша
+        Key key;
+        double result;
+        double error_estimate;
+        ExactSum::Raw sum;
+    };
+
+    struct Entry {
+        Key key;
+        IntegrationResult result;
+        std::size_t slot; ///< Номер записи в файле
+    };
+
+    static Key make_key(const IntegrationTask& task);
+    void touch(const Entry& entry);
+    void write_slot(const Entry& entry);
+    void close_file();
+
+    const std::size_t capacity_;
+    mutable std::mutex mutex_;
+    std::list<Entry> entries_; ///< В порядке использования: первым - последний использованный
+    std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> index_;
+    std::vector<std::size_t> free_slots_;
+    std::size_t hits_ = 0;
+    std::size_t misses_ = 0;
+    uint64_t clock_ = 0; ///< Часы кэша для порядка использования
+
+    // Отображенный файл (mapping_ == nullptr - кэш только в памяти)
+    void* mapping_ = nullptr;
+    std::size_t mapping_size_ = 0;
+    int file_ = -1;
+};
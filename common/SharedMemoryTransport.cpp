@@ -0,0 +1,359 @@
+#include "SharedMemoryTransport.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <thread>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#define SHARED_MEMORY_TRANSPORT 1
+#endif
+
+namespace {
+
+constexpr char kSegmentMagic[8] = {'I', 'N', 'T', 'R', 'I', 'N', 'G', 'S'};
+constexpr uint32_t kSegmentVersion = 1;
+/// Префикс имен сегментов; open() не принимает других имен
+constexpr char kNamePrefix[] = "/integrator-";
+/// Наименьший размер кольца: в него помещается заголовок любого кадра
+constexpr std::size_t kMinRingSize = 4096;
+/// Проверок кольца перед сном на futex: короткое ожидание обходится без системных вызовов
+constexpr int kSpinChecks = 64;
+/// Наибольший сон на futex, после которого проверяется сокет собеседника
+constexpr std::chrono::milliseconds kPeerCheckInterval{100};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free,
+              "кольцо в общей памяти требует атомарных операций без блокировок");
+
+} // namespace
+
+/**
+ * @brief Указатели одного кольца; голова и хвост - в разных кэш-линиях.
+ */
+struct SharedMemoryTransport::Ring {
+    alignas(64) std::atomic<uint64_t> head{0}; ///< Записано байт (двигает писатель)
+    alignas(64) std::atomic<uint64_t> tail{0}; ///< Прочитано байт (двигает читатель)
+    alignas(64) std::atomic<uint32_t> data_seq{0};  ///< Слово futex читателя: растет при записи
+    std::atomic<uint32_t> reader_waiting{0};        ///< Читатель спит на data_seq
+    std::atomic<uint32_t> space_seq{0};             ///< Слово futex писателя: растет при чтении
+    std::atomic<uint32_t> writer_waiting{0};        ///< Писатель спит на space_seq
+};
+
+/**
+ * @brief Заголовок сегмента; за ним следуют данные кольца к серверу и кольца к клиенту.
+ */
+struct SharedMemoryTransport::Segment {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t ring_size;
+    std::atomic<uint32_t> closed{0};
+    Ring rings[2]; ///< [0] - от создавшей стороны, [1] - к ней
+};
+
+#if defined(SHARED_MEMORY_TRANSPORT)
+
+namespace {
+
+void futex_wait(std::atomic<uint32_t>& word, uint32_t expected, std::chrono::milliseconds timeout) {
+    timespec relative{};
+    relative.tv_sec = static_cast<time_t>(timeout.count() / 1000);
+    relative.tv_nsec = static_cast<long>(timeout.count() % 1000) * 1000000L;
+    // Слово разделяется процессами, поэтому futex не FUTEX_PRIVATE
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT, expected, &relative, nullptr, 0);
+}
+
+void futex_wake(std::atomic<uint32_t>& word) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+std::string unique_name() {
+    static std::atomic<unsigned> counter{0};
+    return kNamePrefix + std::to_string(::getpid()) + "-" + std::to_string(counter++);
+}
+
+std::runtime_error system_error(const std::string& what) {
+    return std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+/**
+ * @brief Проверяет, что имя имеет вид unique_name(): префикс, номер процесса и счетчик.
+ */
+bool valid_name(const std::string& name) {
+    const std::size_t prefix = sizeof(kNamePrefix) - 1;
+    if (name.compare(0, prefix, kNamePrefix) != 0) {
+        return false;
+    }
+    const std::size_t dash = name.find('-', prefix);
+    const auto digits = [&name](std::size_t begin, std::size_t end) {
+        return begin < end && std::all_of(name.begin() + begin, name.begin() + end,
+                                          [](char c) { return c >= '0' && c <= '9'; });
+    };
+    return dash != std::string::npos && digits(prefix, dash) && digits(dash + 1, name.size());
+}
+
+/**
+ * @brief Проверяет указатели кольца, которые собеседник может испортить.
+ */
+void check_ring(uint64_t head, uint64_t tail, std::size_t ring_size) {
+    // Беззнаковая разность покрывает и хвост впереди головы
+    if (head - tail > ring_size) {
+        throw std::runtime_error("кольцо общей памяти повреждено");
+    }
+}
+
+} // namespace
+
+std::unique_ptr<SharedMemoryTransport> SharedMemoryTransport::create(std::size_t ring_size) {
+    if (ring_size < kMinRingSize || (ring_size & (ring_size - 1)) != 0) {
+        throw std::invalid_argument("размер кольца общей памяти должен быть степенью двойки не меньше 4096");
+    }
+    std::unique_ptr<SharedMemoryTransport> transport(new SharedMemoryTransport());
+    transport->name_ = unique_name();
+    const int fd = ::shm_open(transport->name_.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0) {
+        throw system_error("не удалось создать сегмент общей памяти " + transport->name_);
+    }
+    transport->owner_ = true;
+    const std::size_t size = sizeof(Segment) + 2 * ring_size;
+    void* memory = MAP_FAILED;
+    if (::ftruncate(fd, static_cast<off_t>(size)) == 0) {
+        memory = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    const int error = errno;
+    ::close(fd);
+    if (memory == MAP_FAILED) {
+        errno = error;
+        throw system_error("не удалось отобразить сегмент общей памяти " + transport->name_);
+    }
+    transport->memory_ = memory;
+    transport->mapped_size_ = size;
+    transport->ring_size_ = ring_size;
+
+    Segment* segment = new (memory) Segment();
+    std::memcpy(segment->magic, kSegmentMagic, sizeof(kSegmentMagic));
+    segment->version = kSegmentVersion;
+    segment->ring_size = ring_size;
+    transport->segment_ = segment;
+
+    char* data = static_cast<char*>(memory) + sizeof(Segment);
+    transport->outgoing_ = &segment->rings[0];
+    transport->incoming_ = &segment->rings[1];
+    transport->outgoing_data_ = data;
+    transport->incoming_data_ = data + ring_size;
+    return transport;
+}
+
+std::unique_ptr<SharedMemoryTransport> SharedMemoryTransport::open(const std::string& name) {
+    if (!valid_name(name)) {
+        throw std::invalid_argument("некорректное имя сегмента общей памяти");
+    }
+    const int fd = ::shm_open(name.c_str(), O_RDWR, 0);
+    if (fd < 0) {
+        throw system_error("не удалось открыть сегмент общей памяти " + name);
+    }
+
+    struct stat info {};
+    void* memory = MAP_FAILED;
+    std::size_t size = 0;
+    if (::fstat(fd, &info) == 0 && info.st_uid == ::geteuid() &&
+        static_cast<std::size_t>(info.st_size) >= sizeof(Segment)) {
+        size = static_cast<std::size_t>(info.st_size);
+        memory = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if (memory == MAP_FAILED) {
+        throw std::runtime_error("некорректный сегмент общей памяти " + name);
+    }
+
+    std::unique_ptr<SharedMemoryTransport> transport(new SharedMemoryTransport());
+    transport->name_ = name;
+    transport->memory_ = memory;
+    transport->mapped_size_ = size;
+    Segment* segment = static_cast<Segment*>(memory);
+    const std::size_t ring_size = static_cast<std::size_t>(segment->ring_size);
+    if (std::memcmp(segment->magic, kSegmentMagic, sizeof(kSegmentMagic)) != 0 ||
+        segment->version != kSegmentVersion || ring_size < kMinRingSize || (ring_size & (ring_size - 1)) != 0 ||
+        sizeof(Segment) + 2 * ring_size != size) {
+        throw std::runtime_error("некорректный заголовок сегмента общей памяти " + name);
+    }
+    // Имя больше не нужно: сегмент живет, пока его отображают обе стороны
+    ::shm_unlink(name.c_str());
+    transport->segment_ = segment;
+    transport->ring_size_ = ring_size;
+
+    char* data = static_cast<char*>(memory) + sizeof(Segment);
+    transport->outgoing_ = &segment->rings[1];
+    transport->incoming_ = &segment->rings[0];
+    transport->outgoing_data_ = data + ring_size;
+    transport->incoming_data_ = data;
+    return transport;
+}
+
+SharedMemoryTransport::~SharedMemoryTransport() {
+    if (segment_ != nullptr) {
+        close();
+    }
+    if (memory_ != nullptr) {
+        ::munmap(memory_, mapped_size_);
+    }
+    if (owner_) {
+        // Имя уже удалено открывшей стороной, если она успела подключиться
+        ::shm_unlink(name_.c_str());
+    }
+}
+
+void SharedMemoryTransport::write(const char* data, std::size_t size) {
+    Ring& ring = *outgoing_;
+    while (size > 0) {
+        const uint64_t head = ring.head.load(std::memory_order_relaxed);
+        const uint64_t tail = ring.tail.load(std::memory_order_acquire);
+        check_ring(head, tail, ring_size_);
+        const std::size_t free = ring_size_ - static_cast<std::size_t>(head - tail);
+        if (free == 0) {
+            wait(ring, false, [&ring, tail] { return ring.tail.load(std::memory_order_acquire) != tail; });
+            continue;
+        }
+        if (segment_->closed.load(std::memory_order_acquire) != 0) {
+            throw std::runtime_error("канал общей памяти закрыт");
+        }
+        const std::size_t chunk = std::min(size, free);
+        const std::size_t offset = static_cast<std::size_t>(head) & (ring_size_ - 1);
+        const std::size_t first = std::min(chunk, ring_size_ - offset);
+        std::memcpy(outgoing_data_ + offset, data, first);
+        std::memcpy(outgoing_data_, data + first, chunk - first);
+        ring.head.store(head + chunk, std::memory_order_release);
+        notify(ring, true);
+        data += chunk;
+        size -= chunk;
+    }
+}
+
+void SharedMemoryTransport::read(char* data, std::size_t size) {
+    Ring& ring = *incoming_;
+    while (size > 0) {
+        const uint64_t tail = ring.tail.load(std::memory_order_relaxed);
+        const uint64_t head = ring.head.load(std::memory_order_acquire);
+        check_ring(head, tail, ring_size_);
+        const std::size_t available = static_cast<std::size_t>(head - tail);
+        if (available == 0) {
+            wait(ring, true, [&ring, head] { return ring.head.load(std::memory_order_acquire) != head; });
+            continue;
+        }
+        const std::size_t chunk = std::min(size, available);
+        const std::size_t offset = static_cast<std::size_t>(tail) & (ring_size_ - 1);
+        const std::size_t first = std::min(chunk, ring_size_ - offset);
+        std::memcpy(data, incoming_data_ + offset, first);
+        std::memcpy(data + first, incoming_data_, chunk - first);
+        ring.tail.store(tail + chunk, std::memory_order_release);
+        notify(ring, false);
+        data += chunk;
+        size -= chunk;
+    }
+}
+
+template<typename Ready>
+void SharedMemoryTransport::wait(Ring& ring, bool for_data, Ready ready) {
+    std::atomic<uint32_t>& seq = for_data ? ring.data_seq : ring.space_seq;
+    std::atomic<uint32_t>& waiting = for_data ? ring.reader_waiting : ring.writer_waiting;
+    for (int i = 0; i < kSpinChecks; ++i) {
+        if (ready()) {
+            return;
+        }
+        std::this_thread::yield();
+    }
+    while (true) {
+        // Счетчик читается до проверки: если собеседник продвинет указатель после
+        // проверки, он увеличит счетчик, и futex_wait сразу вернется
+        const uint32_t observed = seq.load(std::memory_order_seq_cst);
+        if (ready()) {
+            return;
+        }
+        if (segment_->closed.load(std::memory_order_acquire) != 0) {
+            throw std::runtime_error("канал общей памяти закрыт");
+        }
+        waiting.store(1, std::memory_order_seq_cst);
+        if (!ready()) {
+            futex_wait(seq, observed, kPeerCheckInterval);
+        }
+        waiting.store(0, std::memory_order_relaxed);
+        if (!ready() && !peer_alive()) {
+            throw std::runtime_error("собеседник по общей памяти отключился");
+        }
+    }
+}
+
+void SharedMemoryTransport::notify(Ring& ring, bool data) {
+    std::atomic<uint32_t>& seq = data ? ring.data_seq : ring.space_seq;
+    std::atomic<uint32_t>& waiting = data ? ring.reader_waiting : ring.writer_waiting;
+    seq.fetch_add(1, std::memory_order_seq_cst);
+    if (waiting.load(std::memory_order_seq_cst) != 0) {
+        futex_wake(seq);
+    }
+}
+
+void SharedMemoryTransport::close() {
+    segment_->closed.store(1, std::memory_order_release);
+    for (Ring& ring : segment_->rings) {
+        ring.data_seq.fetch_add(1, std::memory_order_seq_cst);
+        ring.space_seq.fetch_add(1, std::memory_order_seq_cst);
+        futex_wake(ring.data_seq);
+        futex_wake(ring.space_seq);
+    }
+}
+
+void SharedMemoryTransport::watch_socket(int socket) {
+    socket_ = socket;
+}
+
+bool SharedMemoryTransport::peer_alive() const {
+    if (socket_ < 0) {
+        return true;
+    }
+    // Закрытый собеседником (или локально) сокет читается как конец потока
+    char byte = 0;
+    const ssize_t received = ::recv(socket_, &byte, 1, MSG_PEEK | MSG_DONTWAIT);
+    return received > 0 || (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR));
+}
+
+#else
+
+std::unique_ptr<SharedMemoryTransport> SharedMemoryTransport::create(std::size_t) {
+    throw std::runtime_error("общая память не поддерживается на этой платформе");
+}
+
+std::unique_ptr<SharedMemoryTransport> SharedMemoryTransport::open(const std::string&) {
+    throw std::runtime_error("общая память не поддерживается на этой платформе");
+}
+
+SharedMemoryTransport::~SharedMemoryTransport() = default;
+
+void SharedMemoryTransport::write(const char*, std::size_t) {
+    throw std::runtime_error("общая память не поддерживается на этой платформе");
+}
+
+void SharedMemoryTransport::read(char*, std::size_t) {
+    throw std::runtime_error("общая память не поддерживается на этой платформе");
+}
+
+void SharedMemoryTransport::close() {
+}
+
+void SharedMemoryTransport::watch_socket(int socket) {
+    socket_ = socket;
+}
+
+#endif
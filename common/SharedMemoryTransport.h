@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+/**
+ * @brief Обмен кадрами сообщений через кольца в общей памяти (процессы одного узла).
+ *
+ * Сегмент общей памяти (shm_open) создает клиент и передает его имя серверу
+ * в описании клиента; сервер отображает сегмент и удаляет имя. В сегменте
+ * два кольца - по одному на направление, в каждом ровно один писатель и
+ * один читатель, поэтому кольцо обходится без блокировок: писатель
+ * продвигает голову, читатель - хвост. Ждущая сторона засыпает на futex и
+ * просыпается, когда собеседник продвинет свой указатель. Кадры те же, что
+ * и в сокете, но без системного вызова на сообщение и без стека TCP.
+ *
+ * Сокет соединения остается открытым: каждые kPeerCheckInterval ожидания
+ * кольцо проверяет, что он не закрыт, и замечает упавшего собеседника.
+ * Поддерживается только в Linux; на других платформах create() и open()
+ * бросают исключение, и обмен остается в сокете.
+ */
+class SharedMemoryTransport {
+public:
+    /// Размер кольца одного направления по умолчанию.
+    static constexpr std::size_t kDefaultRingSize = std::size_t(1) << 20;
+
+    /**
+     * @brief Создает сегмент с уникальным именем (сторона клиента).
+     *
+     * @param ring_size Размер кольца одного направления, степень двойки.
+     * @throws std::runtime_error Если сегмент не создан.
+     */
+    static std::unique_ptr<SharedMemoryTransport> create(std::size_t ring_size = kDefaultRingSize);
+
+    /**
+     * @brief Отображает сегмент, созданный собеседником, и удаляет его имя (сторона сервера).
+     *
+     * Принимаются только имена вида create() и сегменты того же пользователя;
+     * имя удаляется лишь после проверки заголовка.
+     *
+     * @param name Имя сегмента (name() создавшей стороны).
+     * @throws std::invalid_argument Если имя создано не create().
+     * @throws std::runtime_error Если сегмент не найден, принадлежит другому
+     *         пользователю или его заголовок некорректен.
+     */
+    static std::unique_ptr<SharedMemoryTransport> open(const std::string& name);
+
+    /**
+     * @brief Закрывает кольца и снимает отображение сегмента.
+     */
+    ~SharedMemoryTransport();
+
+    SharedMemoryTransport(const SharedMemoryTransport&) = delete;
+    SharedMemoryTransport& operator=(const SharedMemoryTransport&) = delete;
+
+    /**
+     * @brief Пишет байты в исходящее кольцо; ждет места, если кольцо заполнено.
+     *
+     * Вызывается одним потоком (или под внешним мьютексом).
+     *
+     * @throws std::runtime_error Если кольца закрыты или повреждены, или собеседник отключился.
+     */
+    void write(const char* data, std::size_t size);
+
+    /**
+     * @brief Читает ровно size байт из входящего кольца; ждет, пока они появятся.
+     *
+     * Вызывается одним потоком, параллельно с write().
+     *
+     * @throws std::runtime_error Если кольца закрыты или повреждены, или собеседник отключился.
+     */
+    void read(char* data, std::size_t size);
+
+    /**
+     * @brief Закрывает кольца обоих направлений и будит ждущие потоки обеих сторон.
+     */
+    void close();
+
+    /**
+     * @brief Задает сокет соединения, по закрытию которого замечается отключение собеседника.
+     *
+     * @param socket Дескриптор сокета (-1 - не проверять).
+     */
+    void watch_socket(int socket);
+
+    /**
+     * @brief Имя сегмента для передачи собеседнику.
+     */
+    const std::string& name() const {
+        return name_;
+    }
+
+    /**
+     * @brief Размер кольца одного направления.
+     */
+    std::size_t ring_size() const {
+        return ring_size_;
+    }
+
+private:
+    struct Segment;
+    struct Ring;
+
+    SharedMemoryTransport() = default;
+
+    /**
+     * @brief Ждет, пока ready() не станет истинным: короткий опрос, затем сон на futex.
+     */
+    template<typename Ready>
+    void wait(Ring& ring, bool for_data, Ready ready);
+
+    /**
+     * @brief Будит собеседника, если он спит на futex.
+     */
+    static void notify(Ring& ring, bool data);
+
+    bool peer_alive() const;
+
+    std::string name_;
+    bool owner_ = false;  ///< Сегмент создан этой стороной: имя удаляется при разрушении
+    void* memory_ = nullptr;
+    std::size_t mapped_size_ = 0;
+    std::size_t ring_size_ = 0;
+    Segment* segment_ = nullptr;
+    Ring* outgoing_ = nullptr;
+    Ring* incoming_ = nullptr;
+    char* outgoing_data_ = nullptr;
+    char* incoming_data_ = nullptr;
+    int socket_ = -1;
+};
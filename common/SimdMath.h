@@ -0,0 +1,299 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+/**
+ * @brief Тонкие обертки над векторными регистрами double и векторный логарифм.
+ *
+ * Каждая структура описывает один набор инструкций и предоставляет одинаковый
+ * набор статических операций, поэтому вычислительные ядра пишутся один раз
+ * как шаблоны от типа вектора. Доступность вариантов определяется флагами
+ * компиляции текущей единицы трансляции.
+ *
+ * Единицы трансляции, собираемые с разными флагами (-mavx2, -mavx512f),
+ * определяют свой SIMD_VARIANT_NAMESPACE до включения заголовка: так
+ * встраиваемые функции каждого варианта получают собственные имена, и
+ * компоновщик не подставит AVX-версию в код для старых процессоров.
+ *
+ * Библиотека собирается с -ffp-contract=off: компилятор не сливает a * b + c
+ * сам, и каждая дорожка выполняет ровно записанную последовательность
+ * операций IEEE. Варианты AVX2 и AVX-512 (fmadd - инструкция FMA) поэтому
+ * дают одинаковые биты; у SSE2 и скалярного варианта fmadd не слит, и их
+ * результаты отличаются в пределах округления.
+ */
+#ifndef SIMD_VARIANT_NAMESPACE
+#define SIMD_VARIANT_NAMESPACE baseline_variant
+#endif
+
+namespace simd {
+inline namespace SIMD_VARIANT_NAMESPACE {
+
+/**
+ * @brief Скалярный "вектор" из одного double.
+ *
+ * Используется для хвостов циклов и как запасной вариант без SIMD.
+ */
+struct Scalar {
+    using vec = double;
+    static constexpr std::size_t width = 1;
+    static constexpr const char* name = "scalar";
+
+    static vec zero() { return 0.0; }
+    static vec set1(double v) { return v; }
+    static vec iota(double start) { return start; }
+    static vec loadu(const double* p) { return *p; }
+    static void storeu(double* p, vec a) { *p = a; }
+    static vec add(vec a, vec b) { return a + b; }
+    static vec sub(vec a, vec b) { return a - b; }
+    static vec mul(vec a, vec b) { return a * b; }
+    static vec div(vec a, vec b) { return a / b; }
+    static vec fmadd(vec a, vec b, vec c) { return a * b + c; }
+    static vec select_lt(vec a, vec b, vec if_true, vec if_false) { return a < b ? if_true : if_false; }
+    static double reduce_add(vec a) { return a; }
+
+    /**
+     * @brief Разбивает положительное нормализованное x на мантиссу [0.5, 1) и порядок.
+     */
+    static vec frexp(vec x, vec& exponent) {
+        uint64_t bits;
+        std::memcpy(&bits, &x, sizeof(bits));
+        exponent = static_cast<double>(static_cast<int64_t>(bits >> 52)) - 1022.0;
+        bits = (bits & 0x000FFFFFFFFFFFFFULL) | 0x3FE0000000000000ULL;
+        double mantissa;
+        std::memcpy(&mantissa, &bits, sizeof(mantissa));
+        return mantissa;
+    }
+
+    /**
+     * @brief Возвращает 2^n для целого n в [-1022, 1023], записанного в double.
+     */
+    static vec pow2i(vec n) {
+        uint64_t bits = static_cast<uint64_t>(static_cast<int64_t>(n) + 1023) << 52;
+        double result;
+        std::memcpy(&result, &bits, sizeof(result));
+        return result;
+    }
+};
+
+#if defined(__SSE2__) || defined(_M_X64)
+/**
+ * @brief Два double в регистре SSE2.
+ */
+struct Sse2 {
+    using vec = __m128d;
+    static constexpr std::size_t width = 2;
+    static constexpr const char* name = "sse2";
+
+    static vec zero() { return _mm_setzero_pd(); }
+    static vec set1(double v) { return _mm_set1_pd(v); }
+    static vec iota(double start) { return _mm_set_pd(start + 1.0, start); }
+    static vec loadu(const double* p) { return _mm_loadu_pd(p); }
+    static void storeu(double* p, vec a) { _mm_storeu_pd(p, a); }
+    static vec add(vec a, vec b) { return _mm_add_pd(a, b); }
+    static vec sub(vec a, vec b) { return _mm_sub_pd(a, b); }
+    static vec mul(vec a, vec b) { return _mm_mul_pd(a, b); }
+    static vec div(vec a, vec b) { return _mm_div_pd(a, b); }
+    static vec fmadd(vec a, vec b, vec c) { return _mm_add_pd(_mm_mul_pd(a, b), c); }
+    static vec select_lt(vec a, vec b, vec if_true, vec if_false) {
+        vec mask = _mm_cmplt_pd(a, b);
+        return _mm_or_pd(_mm_and_pd(mask, if_true), _mm_andnot_pd(mask, if_false));
+    }
+    static double reduce_add(vec a) {
+        return _mm_cvtsd_f64(_mm_add_sd(a, _mm_unpackhi_pd(a, a)));
+    }
+    static vec frexp(vec x, vec& exponent) {
+        __m128i bits = _mm_castpd_si128(x);
+        __m128i biased = _mm_or_si128(_mm_srli_epi64(bits, 52), _mm_set1_epi64x(0x4330000000000000LL));
+        exponent = _mm_sub_pd(_mm_castsi128_pd(biased), _mm_set1_pd(4503599627370496.0 + 1022.0));
+        __m128i mantissa = _mm_or_si128(_mm_and_si128(bits, _mm_set1_epi64x(0x000FFFFFFFFFFFFFLL)),
+                                        _mm_set1_epi64x(0x3FE0000000000000LL));
+        return _mm_castsi128_pd(mantissa);
+    }
+    static vec pow2i(vec n) {
+        // В младших битах мантиссы 2^52 + 1023 + n лежит n + 1023 - это и есть поле порядка 2^n
+        __m128i biased = _mm_castpd_si128(_mm_add_pd(n, _mm_set1_pd(4503599627370496.0 + 1023.0)));
+        return _mm_castsi128_pd(_mm_slli_epi64(biased, 52));
+    }
+};
+#endif
+
+#if defined(__AVX2__) && (defined(__FMA__) || defined(_MSC_VER))
+/**
+ * @brief Четыре double в регистре AVX2 (с FMA).
+ */
+struct Avx2 {
+    using vec = __m256d;
+    static constexpr std::size_t width = 4;
+    static constexpr const char* name = "avx2";
+
+    static vec zero() { return _mm256_setzero_pd(); }
+    static vec set1(double v) { return _mm256_set1_pd(v); }
+    static vec iota(double start) { return _mm256_set_pd(start + 3.0, start + 2.0, start + 1.0, start); }
+    static vec loadu(const double* p) { return _mm256_loadu_pd(p); }
+    static void storeu(double* p, vec a) { _mm256_storeu_pd(p, a); }
+    static vec add(vec a, vec b) { return _mm256_add_pd(a, b); }
+    static vec sub(vec a, vec b) { return _mm256_sub_pd(a, b); }
+    static vec mul(vec a, vec b) { return _mm256_mul_pd(a, b); }
+    static vec div(vec a, vec b) { return _mm256_div_pd(a, b); }
+    static vec fmadd(vec a, vec b, vec c) { return _mm256_fmadd_pd(a, b, c); }
+    static vec select_lt(vec a, vec b, vec if_true, vec if_false) {
+        return _mm256_blendv_pd(if_false, if_true, _mm256_cmp_pd(a, b, _CMP_LT_OQ));
+    }
+    static double reduce_add(vec a) {
+        __m128d sum = _mm_add_pd(_mm256_castpd256_pd128(a), _mm256_extractf128_pd(a, 1));
+        return _mm_cvtsd_f64(_mm_add_sd(sum, _mm_unpackhi_pd(sum, sum)));
+    }
+    static vec frexp(vec x, vec& exponent) {
+        __m256i bits = _mm256_castpd_si256(x);
+        __m256i biased = _mm256_or_si256(_mm256_srli_epi64(bits, 52), _mm256_set1_epi64x(0x4330000000000000LL));
+        exponent = _mm256_sub_pd(_mm256_castsi256_pd(biased), _mm256_set1_pd(4503599627370496.0 + 1022.0));
+        __m256i mantissa = _mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi64x(0x000FFFFFFFFFFFFFLL)),
+                                           _mm256_set1_epi64x(0x3FE0000000000000LL));
+        return _mm256_castsi256_pd(mantissa);
+    }
+    static vec pow2i(vec n) {
+        __m256i biased = _mm256_castpd_si256(_mm256_add_pd(n, _mm256_set1_pd(4503599627370496.0 + 1023.0)));
+        return _mm256_castsi256_pd(_mm256_slli_epi64(biased, 52));
+    }
+};
+#endif
+
+#if defined(__AVX512F__)
+/**
+ * @brief Восемь double в регистре AVX-512.
+ */
+struct Avx512 {
+    using vec = __m512d;
+    static constexpr std::size_t width = 8;
+    static constexpr const char* name = "avx512";
+
+    static vec zero() { return _mm512_setzero_pd(); }
+    static vec set1(double v) { return _mm512_set1_pd(v); }
+    static vec iota(double start) {
+        return _mm512_add_pd(_mm512_set1_pd(start), _mm512_set_pd(7.0, 6.0, 5.0, 4.0, 3.0, 2.0, 1.0, 0.0));
+    }
+    static vec loadu(const double* p) { return _mm512_loadu_pd(p); }
+    static void storeu(double* p, vec a) { _mm512_storeu_pd(p, a); }
+    static vec add(vec a, vec b) { return _mm512_add_pd(a, b); }
+    static vec sub(vec a, vec b) { return _mm512_sub_pd(a, b); }
+    static vec mul(vec a, vec b) { return _mm512_mul_pd(a, b); }
+    static vec div(vec a, vec b) { return _mm512_div_pd(a, b); }
+    static vec fmadd(vec a, vec b, vec c) { return _mm512_fmadd_pd(a, b, c); }
+    static vec select_lt(vec a, vec b, vec if_true, vec if_false) {
+        return _mm512_mask_blend_pd(_mm512_cmp_pd_mask(a, b, _CMP_LT_OQ), if_false, if_true);
+    }
+    static double reduce_add(vec a) {
+        alignas(64) double lanes[8];
+        _mm512_store_pd(lanes, a);
+        return ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) + ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7]));
+    }
+    static vec frexp(vec x, vec& exponent) {
+        __m512i bits = _mm512_castpd_si512(x);
+        // maskz-вариант: безмасочный сдвиг в GCC 12 дает ложное -Wmaybe-uninitialized
+        __m512i biased = _mm512_or_si512(_mm512_maskz_srli_epi64(0xFF, bits, 52), _mm512_set1_epi64(0x4330000000000000LL));
+        exponent = _mm512_sub_pd(_mm512_castsi512_pd(biased), _mm512_set1_pd(4503599627370496.0 + 1022.0));
+        __m512i mantissa = _mm512_or_si512(_mm512_and_si512(bits, _mm512_set1_epi64(0x000FFFFFFFFFFFFFLL)),
+                                           _mm512_set1_epi64(0x3FE0000000000000LL));
+        return _mm512_castsi512_pd(mantissa);
+    }
+    static vec pow2i(vec n) {
+        __m512i biased = _mm512_castpd_si512(_mm512_add_pd(n, _mm512_set1_pd(4503599627370496.0 + 1023.0)));
+        return _mm512_castsi512_pd(_mm512_maskz_slli_epi64(0xFF, biased, 52));
+    }
+};
+#endif
+
+/**
+ * @brief Векторный натуральный логарифм (алгоритм Cephes, погрешность ~1 ulp).
+ *
+ * Аргумент раскладывается как x = m * 2^e, m приводится к [sqrt(1/2), sqrt(2)),
+ * а log(m) вычисляется рациональной аппроксимацией степени 5/5.
+ * Определен только для положительных нормализованных конечных x: проверка
+ * области определения выполняется вызывающим кодом один раз на диапазон.
+ *
+ * @tparam V Тип вектора (Scalar, Sse2, Avx2, Avx512).
+ * @param x Аргумент.
+ * @return Значение ln(x) в каждой дорожке.
+ */
+template<class V>
+inline typename V::vec log(typename V::vec x) {
+    using vec = typename V::vec;
+    const vec one = V::set1(1.0);
+
+    vec e;
+    vec m = V::frexp(x, e);
+    const vec sqrth = V::set1(0.70710678118654752440);
+    e = V::select_lt(m, sqrth, V::sub(e, one), e);
+    m = V::select_lt(m, sqrth, V::add(m, m), m);
+    m = V::sub(m, one);
+
+    vec p = V::set1(1.01875663804580931796E-4);
+    p = V::fmadd(p, m, V::set1(4.97494994976747001425E-1));
+    p = V::fmadd(p, m, V::set1(4.70579119878881725854E0));
+    p = V::fmadd(p, m, V::set1(1.44989225341610930846E1));
+    p = V::fmadd(p, m, V::set1(1.79368678507819816313E1));
+    p = V::fmadd(p, m, V::set1(7.70838733755885391666E0));
+
+    vec q = V::add(m, V::set1(1.12873587189167450590E1));
+    q = V::fmadd(q, m, V::set1(4.52279145837532221105E1));
+    q = V::fmadd(q, m, V::set1(8.29875266912776603211E1));
+    q = V::fmadd(q, m, V::set1(7.11544750618563894466E1));
+    q = V::fmadd(q, m, V::set1(2.31251620126765340583E1));
+
+    vec z = V::mul(m, m);
+    vec y = V::mul(m, V::mul(z, V::div(p, q)));
+    y = V::fmadd(e, V::set1(-2.121944400546905827679e-4), y);
+    y = V::fmadd(z, V::set1(-0.5), y);
+    vec r = V::add(m, y);
+    return V::fmadd(e, V::set1(0.693359375), r);
+}
+
+/**
+ * @brief Векторная экспонента (алгоритм Cephes, погрешность ~1 ulp).
+ *
+ * x = n ln 2 + r, |r| <= ln 2 / 2; exp(r) вычисляется рациональной
+ * аппроксимацией Паде, а 2^n собирается прямо в поле порядка. Аргумент
+ * ограничивается отрезком [-708, 709], поэтому результат всегда нормализован.
+ *
+ * @tparam V Тип вектора (Scalar, Sse2, Avx2, Avx512).
+ * @param x Аргумент.
+ * @return Значение exp(x) в каждой дорожке.
+ */
+template<class V>
+inline typename V::vec exp(typename V::vec x) {
+    using vec = typename V::vec;
+    const vec lower = V::set1(-708.0);
+    const vec upper = V::set1(709.0);
+    x = V::select_lt(x, lower, lower, x);
+    x = V::select_lt(upper, x, upper, x);
+
+    // Округление x / ln 2 до ближайшего целого сложением с 1.5 * 2^52
+    const vec round_magic = V::set1(6755399441055744.0);
+    vec n = V::sub(V::fmadd(x, V::set1(1.4426950408889634073599), round_magic), round_magic);
+    x = V::fmadd(n, V::set1(-6.93145751953125E-1), x);
+    x = V::fmadd(n, V::set1(-1.42860682030941723212E-6), x);
+
+    vec xx = V::mul(x, x);
+    vec p = V::set1(1.26177193074810590878E-4);
+    p = V::fmadd(p, xx, V::set1(3.02994407707441961300E-2));
+    p = V::fmadd(p, xx, V::set1(9.99999999999999999910E-1));
+    p = V::mul(p, x);
+
+    vec q = V::set1(3.00198505138664455042E-6);
+    q = V::fmadd(q, xx, V::set1(2.52448340349684104192E-3));
+    q = V::fmadd(q, xx, V::set1(2.27265548208155028766E-1));
+    q = V::fmadd(q, xx, V::set1(2.00000000000000000009E0));
+
+    vec r = V::div(p, V::sub(q, p));
+    r = V::fmadd(r, V::set1(2.0), V::set1(1.0));
+    return V::mul(r, V::pow2i(n));
+}
+
+} // inline namespace SIMD_VARIANT_NAMESPACE
+} // namespace simd
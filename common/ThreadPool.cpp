@@ -0,0 +1,148 @@
+#include "ThreadPool.h"
+
+#include "CpuTopology.h"
+
+#include <exception>
+
+ThreadPool::ThreadPool(std::size_t workers, const std::vector<int>& cpus) {
+    if (workers == 0) {
+        workers = 1;
+    }
+    queues_.resize(workers);
+    for (std::size_t i = 0; i < workers; ++i) {
+        const int cpu = cpus.empty() ? -1 : cpus[i % cpus.size()];
+        threads_.emplace_back([this, i, cpu]() { run(i, cpu); });
+    }
+
+    // Очереди создаются потоками; пул готов, когда созданы все
+    std::unique_lock<std::mutex> lock(wake_mutex_);
+    wake_cv_.wait(lock, [this, workers]() { return started_ == workers; });
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        stopping_ = true;
+    }
+    wake_cv_.notify_all();
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+void ThreadPool::parallel_for(std::size_t count, const std::function<void(std::size_t)>& body,
+                              const CancellationToken* token) {
+    if (count == 0) {
+        return;
+    }
+
+    struct State {
+        std::atomic<std::size_t> remaining;
+        std::mutex mutex;
+        std::condition_variable done;
+        std::exception_ptr error;
+    };
+    auto state = std::make_shared<State>();
+    state->remaining = count;
+
+    // Счетчик увеличивается до постановки заданий, чтобы не уйти в минус при их раннем взятии
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        pending_ += count;
+    }
+
+    // Непрерывные отрезки заданий по очередям: владелец идет с конца, вор - с начала
+    const std::size_t workers = queues_.size();
+    for (std::size_t w = 0; w < workers; ++w) {
+        const std::size_t begin = count * w / workers;
+        const std::size_t end = count * (w + 1) / workers;
+        std::lock_guard<std::mutex> lock(queues_[w]->mutex);
+        for (std::size_t i = end; i > begin; --i) {
+            queues_[w]->tasks.emplace_back([state, &body, token, i]() {
+                try {
+                    if (token == nullptr || !token->cancelled()) {
+                        body(i - 1);
+                    }
+                } catch (...) {
+                    std::lock_guard<std::mutex> error_lock(state->mutex);
+                    if (!state->error) {
+                        state->error = std::current_exception();
+                    }
+                }
+                if (state->remaining.fetch_sub(1) == 1) {
+                    std::lock_guard<std::mutex> done_lock(state->mutex);
+                    state->done.notify_all();
+                }
+            });
+        }
+    }
+    wake_cv_.notify_all();
+
+    // Вызывающий поток только ждет: иначе параллельные вызовы (по одному на
+    // выполняемую клиентом задачу) добавили бы к пулу незакрепленные потоки
+    // сверх емкости и брали бы задания друг друга
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->done.wait(lock, [&state]() { return state->remaining.load() == 0; });
+    if (state->error) {
+        std::rethrow_exception(state->error);
+    }
+}
+
+void ThreadPool::run(std::size_t index, int cpu) {
+    const bool pinned = cpu >= 0 && pin_current_thread(cpu);
+    auto queue = std::make_unique<Queue>();
+    {
+        // Чужие очереди доступны для кражи, только когда созданы все
+        std::unique_lock<std::mutex> lock(wake_mutex_);
+        queues_[index] = std::move(queue);
+        pinned_ += pinned ? 1 : 0;
+        ++started_;
+        wake_cv_.notify_all();
+        wake_cv_.wait(lock, [this]() { return started_ == queues_.size(); });
+    }
+
+    std::function<void()> task;
+    while (true) {
+        if (try_pop(index, task) || try_steal(index, task)) {
+            task();
+            task = nullptr;
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(wake_mutex_);
+        wake_cv_.wait(lock, [this]() { return stopping_ || pending_.load() > 0; });
+        if (stopping_ && pending_.load() == 0) {
+            return;
+        }
+    }
+}
+
+bool ThreadPool::try_pop(std::size_t index, std::function<void()>& task) {
+    Queue& queue = *queues_[index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) {
+        return false;
+    }
+    task = std::move(queue.tasks.back());
+    queue.tasks.pop_back();
+    pending_.fetch_sub(1);
+    return true;
+}
+
+bool ThreadPool::try_steal(std::size_t thief, std::function<void()>& task) {
+    // Обход начинается с соседа, чтобы воры не толпились у одной очереди
+    const std::size_t workers = queues_.size();
+    for (std::size_t offset = 1; offset <= workers; ++offset) {
+        const std::size_t victim = (thief + offset) % workers;
+        Queue& queue = *queues_[victim];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty()) {
+            continue;
+        }
+        task = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+        pending_.fetch_sub(1);
+        steals_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
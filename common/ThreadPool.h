@@ -0,0 +1,131 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Признак отмены задачи, который проверяют ее части.
+ *
+ * Отмена кооперативная: выполняющаяся часть замечает ее на ближайшей
+ * проверке, а еще не начатые части пропускаются.
+ */
+class CancellationToken {
+public:
+    /**
+     * @brief Отменяет задачу.
+     */
+    void cancel() {
+        cancelled_.store(true, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Возвращает true, если задача отменена.
+     */
+    bool cancelled() const {
+        return cancelled_.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<bool> cancelled_{false};
+};
+
+/**
+ * @brief Долгоживущий пул потоков с очередью на каждый поток и кражей работы.
+ *
+ * Потоки создаются один раз при запуске клиента. Задания parallel_for
+ * раскладываются по очередям непрерывными отрезками: поток берет задания
+ * из конца своей очереди, а освободившийся поток крадет из начала чужой,
+ * то есть самую дальнюю от владельца работу. Поэтому медленное ядро
+ * (энергоэффективное, занятое соседом) не задерживает всю задачу: его
+ * недоделанную часть заберут остальные.
+ *
+ * Потоки можно закрепить за процессорами. Очередь потока создается самим
+ * потоком после закрепления, поэтому ее память выделяется на его узле NUMA.
+ */
+class ThreadPool {
+public:
+    /**
+     * @brief Запускает пул.
+     *
+     * @param workers Число потоков (0 заменяется на 1).
+     * @param cpus Номера логических CPU для закрепления потоков (поток i -
+     *             cpus[i % cpus.size()]); пустой список - без закрепления.
+     */
+    explicit ThreadPool(std::size_t workers, const std::vector<int>& cpus = {});
+
+    /**
+     * @brief Дожидается выполнения поставленных заданий и останавливает потоки.
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief Возвращает число потоков пула.
+     */
+    std::size_t size() const {
+        return threads_.size();
+    }
+
+    /**
+     * @brief Возвращает число потоков, успешно закрепленных за процессорами.
+     */
+    std::size_t pinned() const {
+        return pinned_;
+    }
+
+    /**
+     * @brief Выполняет body(i) для всех i в [0, count) и ждет завершения.
+     *
+     * Задания выполняют только потоки пула, вызывающий поток ждет; поэтому
+     * одновременные вызовы из нескольких потоков не превышают размер пула
+     * и закрепление потоков. Исключение первого
+     * упавшего задания пробрасывается вызывающему после завершения остальных.
+     * После отмены еще не начатые задания пропускаются.
+     *
+     * @param count Число заданий.
+     * @param body Задание; вызывается из разных потоков одновременно.
+     * @param token Признак отмены (nullptr - задания не отменяются).
+     */
+    void parallel_for(std::size_t count, const std::function<void(std::size_t)>& body,
+                      const CancellationToken* token = nullptr);
+
+    /**
+     * @brief Возвращает число заданий, украденных потоками пула из чужих очередей с запуска пула.
+     */
+    uint64_t steals() const {
+        return steals_.load(std::memory_order_relaxed);
+    }
+
+private:
+    /**
+     * @brief Очередь заданий одного потока.
+     */
+    struct Queue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    void run(std::size_t index, int cpu);
+    bool try_pop(std::size_t index, std::function<void()>& task);
+    bool try_steal(std::size_t thief, std::function<void()>& task);
+
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::thread> threads_;
+    std::mutex wake_mutex_;                 ///< Защищает pending_ при засыпании потоков
+    std::condition_variable wake_cv_;
+    std::atomic<std::size_t> pending_{0};   ///< Заданий в очередях
+    bool stopping_ = false;
+    std::atomic<uint64_t> steals_{0};
+    std::size_t started_ = 0;               ///< Потоков, создавших свою очередь (под wake_mutex_)
+    std::size_t pinned_ = 0;                ///< Закрепленных потоков (под wake_mutex_)
+};
@@ -1,62 +1,258 @@
 #pragma once
 
 #include <boost/asio.hpp>
-#include <boost/serialization/serialization.hpp>
-#include <boost/archive/text_oarchive.hpp>
-#include <boost/archive/text_iarchive.hpp>
 
-#include <string>
-#include <iostream>
-#include <sstream>
+#include "SharedMemoryTransport.h"
+#include "WireFormat.h"
+
 #include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
 
 /**
- * @brief Отправляет сериализованные данные по сокету.
+ * @brief Сокет соединения сервера с клиентом: TCP или AF_UNIX.
  * 
- * Сначала отправляет размер данных (4 байта), затем сами данные.
+ * Кадры и сообщения одинаковы для обоих транспортов; сокет конкретного
+ * протокола перемещается в MessageSocket после подключения.
+ */
+using MessageSocket = boost::asio::generic::stream_protocol::socket;
+
+/// Префикс адреса сокета AF_UNIX: "unix:<путь>"
+constexpr const char kUnixAddressPrefix[] = "unix:";
+
+/// Наибольший размер сообщения: защищает от выделения памяти по испорченному префиксу.
+constexpr uint32_t kMaxMessageSize = 64u << 20;
+
+/// Размер буферов приема и отправки сокета: вмещает пачку задач или результатов целиком.
+constexpr int kSocketBufferSize = 256 * 1024;
+
+/**
+ * @brief Настраивает сокет для обмена короткими сообщениями.
  * 
- * @tparam T Тип отправляемых данных.
- * @param socket Ссылка на сокет Boost.Asio.
- * @param data Данные для отправки.
+ * Для TCP отключает алгоритм Нейгла (TCP_NODELAY): иначе короткое сообщение
+ * ждет подтверждения предыдущего, которое получатель откладывает, и задержка
+ * вырастает до десятков миллисекунд. Задает размеры буферов сокета.
+ * Ошибки настройки не прерывают соединение.
+ * 
+ * @param socket Подключенный сокет.
  */
-template<typename T>
-void send_data(boost::asio::ip::tcp::socket& socket, const T& data) {
-    // Сериализуем данные в строку
-    std::ostringstream archive_stream;
-    boost::archive::text_oarchive archive(archive_stream);
-    archive << data;
-    
-    std::string outbound_data = archive_stream.str();
-    
-    // Отправляем размер данных
-    uint32_t size = static_cast<uint32_t>(outbound_data.size());
-    boost::asio::write(socket, boost::asio::buffer(&size, sizeof(size)));
-    
-    // Отправляем сами данные
-    boost::asio::write(socket, boost::asio::buffer(outbound_data));
+inline void configure_socket(MessageSocket& socket) {
+    boost::system::error_code ignored;
+    const int family = socket.local_endpoint(ignored).protocol().family();
+    if (family == AF_INET || family == AF_INET6) {
+        socket.set_option(boost::asio::ip::tcp::no_delay(true), ignored);
+    }
+    socket.set_option(boost::asio::socket_base::send_buffer_size(kSocketBufferSize), ignored);
+    socket.set_option(boost::asio::socket_base::receive_buffer_size(kSocketBufferSize), ignored);
 }
 
 /**
- * @brief Получает и десериализует данные из сокета.
+ * @brief Дописывает в буфер кадр: размер (4 байта), конверт и данные сообщения.
  * 
- * Сначала читает размер данных (4 байта), затем сами данные.
+ * Несколько кадров одного буфера отправляются одной записью (MessageChannel::flush()).
  * 
- * @tparam T Тип получаемых данных.
- * @param socket Ссылка на сокет Boost.Asio.
- * @param data Ссылка, куда будут десериализованы данные.
+ * @tparam T Тип данных сообщения (см. wire::MessageType).
+ * @param frames Буфер кадров.
+ * @param envelope Конверт сообщения (wire::make_envelope()).
+ * @param payload Данные сообщения.
  */
 template<typename T>
-void receive_data(boost::asio::ip::tcp::socket& socket, T& data) {
+void append_frame(std::vector<char>& frames, const wire::Envelope& envelope, const T& payload) {
+    const std::size_t header = frames.size();
+    frames.resize(header + sizeof(uint32_t));
+    wire::Writer writer(frames);
+    wire::encode_message(writer, envelope, payload);
+    const uint32_t size = static_cast<uint32_t>(frames.size() - header - sizeof(uint32_t));
+    std::memcpy(frames.data() + header, &size, sizeof(size));
+}
+
+/**
+ * @brief Получает из сокета кадр без префикса размера.
+ * 
+ * @param socket Ссылка на сокет Boost.Asio.
+ * @param frame Буфер кадра; переиспользуется между вызовами.
+ * @throws std::runtime_error Если размер кадра больше kMaxMessageSize.
+ */
+inline void receive_frame(MessageSocket& socket, std::vector<char>& frame) {
     // Читаем размер данных
     uint32_t size = 0;
     boost::asio::read(socket, boost::asio::buffer(&size, sizeof(size)));
+    if (size > kMaxMessageSize) {
+        throw std::runtime_error("слишком большое сообщение");
+    }
     
     // Читаем сами данные
-    boost::asio::streambuf response_buf;
-    boost::asio::read(socket, response_buf, boost::asio::transfer_exactly(size));
-    
-    // Десериализуем данные
-    std::istream archive_stream(&response_buf);
-    boost::archive::text_iarchive archive(archive_stream);
-    archive >> data;
+    frame.resize(size);
+    boost::asio::read(socket, boost::asio::buffer(frame));
 }
+
+/**
+ * @brief Обмен сообщениями по сокету с буферами, переиспользуемыми между сообщениями.
+ * 
+ * У соединения свои буферы чтения и записи: они растут до наибольшего
+ * сообщения и больше не освобождаются. Кадры кодируются прямо в буфер
+ * записи и декодируются прямо из буфера чтения, поэтому в установившемся
+ * режиме обмен сообщениями не выделяет память. Запись (queue(), flush(),
+ * send()) выполняет один поток или несколько под общим мьютексом; чтение -
+ * один поток, параллельно с записью.
+ * 
+ * После рукопожатия кадры могут идти через кольца общей памяти
+ * (use_shared_memory()) вместо сокета; формат кадров тот же.
+ */
+class MessageChannel {
+public:
+    /**
+     * @param socket Подключенный сокет; должен пережить канал.
+     */
+    explicit MessageChannel(MessageSocket& socket) : socket_(socket) {}
+
+    MessageChannel(const MessageChannel&) = delete;
+    MessageChannel& operator=(const MessageChannel&) = delete;
+
+    /**
+     * @brief Дописывает сообщение в буфер записи; отправляется при flush().
+     * 
+     * Если сообщение не кодируется, буфер остается прежним.
+     */
+    template<typename T>
+    void queue(const wire::Envelope& envelope, const T& payload) {
+        const std::size_t size = write_buffer_.size();
+        try {
+            append_frame(write_buffer_, envelope, payload);
+        } catch (...) {
+            write_buffer_.resize(size);
+            throw;
+        }
+    }
+
+    /**
+     * @brief Отправляет накопленные сообщения одной записью в сокет.
+     * 
+     * Буфер очищается и при ошибке отправки.
+     * 
+     * @throws boost::system::system_error Если запись не удалась.
+     */
+    void flush() {
+        if (write_buffer_.empty()) {
+            return;
+        }
+        if (shared_memory_) {
+            try {
+                shared_memory_->write(write_buffer_.data(), write_buffer_.size());
+            } catch (...) {
+                write_buffer_.clear();
+                throw;
+            }
+            write_buffer_.clear();
+            return;
+        }
+        boost::system::error_code error;
+        boost::asio::write(socket_, boost::asio::buffer(write_buffer_), error);
+        write_buffer_.clear();
+        if (error) {
+            throw boost::system::system_error(error);
+        }
+    }
+
+    /**
+     * @brief Отправляет одно сообщение (вместе с ранее накопленными).
+     */
+    template<typename T>
+    void send(const wire::Envelope& envelope, const T& payload) {
+        queue(envelope, payload);
+        flush();
+    }
+
+    /**
+     * @brief Получает кадр и передает его таблице обработчиков.
+     * 
+     * @param dispatcher Таблица обработчиков.
+     * @param envelope Конверт полученного сообщения.
+     * @return false, если сообщение пропущено (см. wire::Dispatcher::dispatch()).
+     */
+    bool receive(const wire::Dispatcher& dispatcher, wire::Envelope& envelope) {
+        read_frame();
+        return dispatcher.dispatch(read_buffer_.data(), read_buffer_.size(), envelope);
+    }
+
+    /**
+     * @brief Получает сообщение заданного типа (например, при рукопожатии).
+     * 
+     * @tparam T Тип данных сообщения.
+     * @param expected Ожидаемый тип сообщения.
+     * @param payload Ссылка, куда будут декодированы данные.
+     * @return Конверт сообщения (по нему видна версия протокола отправителя).
+     * @throws std::runtime_error Если пришло сообщение другого типа или оно некорректно.
+     */
+    template<typename T>
+    wire::Envelope receive(wire::MessageType expected, T& payload) {
+        read_frame();
+        wire::Reader reader(read_buffer_.data(), read_buffer_.size());
+        wire::Envelope envelope;
+        wire::decode(reader, envelope);
+        if (envelope.type != expected) {
+            throw std::runtime_error("неожиданный тип сообщения " +
+                                     std::to_string(static_cast<unsigned>(envelope.type)));
+        }
+        wire::decode(reader, payload);
+        return envelope;
+    }
+
+    /**
+     * @brief Переводит обмен сообщениями с сокета на кольца общей памяти.
+     * 
+     * Вызывается до запуска потоков чтения и записи, когда обе стороны
+     * договорились о сегменте. Сокет остается открытым: по его закрытию
+     * кольца замечают отключение собеседника.
+     * 
+     * @param transport Отображенный сегмент общей памяти.
+     */
+    void use_shared_memory(std::unique_ptr<SharedMemoryTransport> transport) {
+        transport->watch_socket(static_cast<int>(socket_.native_handle()));
+        shared_memory_ = std::move(transport);
+    }
+
+    /**
+     * @brief Проверяет, идут ли сообщения через общую память.
+     */
+    bool uses_shared_memory() const {
+        return shared_memory_ != nullptr;
+    }
+
+    /**
+     * @brief Закрывает соединение: потоки, ждущие сокет или кольцо, завершаются.
+     */
+    void shutdown() {
+        boost::system::error_code ignored;
+        socket_.shutdown(MessageSocket::shutdown_both, ignored);
+        if (shared_memory_) {
+            shared_memory_->close();
+        }
+    }
+
+private:
+    /**
+     * @brief Получает кадр из сокета или из кольца общей памяти в буфер чтения.
+     */
+    void read_frame() {
+        if (!shared_memory_) {
+            receive_frame(socket_, read_buffer_);
+            return;
+        }
+        uint32_t size = 0;
+        shared_memory_->read(reinterpret_cast<char*>(&size), sizeof(size));
+        if (size > kMaxMessageSize) {
+            throw std::runtime_error("слишком большое сообщение");
+        }
+        read_buffer_.resize(size);
+        shared_memory_->read(read_buffer_.data(), size);
+    }
+
+    MessageSocket& socket_;
+    std::vector<char> read_buffer_;
+    std::vector<char> write_buffer_;
+    std::unique_ptr<SharedMemoryTransport> shared_memory_; ///< Кольца общей памяти (нет - сокет)
+};
@@ -0,0 +1,310 @@
+#include "WireFormat.h"
+
+#include <algorithm>
+#include <string>
+
+namespace wire {
+
+namespace {
+
+/**
+ * @brief Читает число элементов списка; каждый занимает не меньше min_size байт сообщения.
+ */
+uint32_t decode_count(Reader& in, uint32_t min_size) {
+    uint32_t count = 0;
+    in.value(count);
+    if (count > in.remaining() / min_size) {
+        throw std::runtime_error("некорректное число элементов в сообщении");
+    }
+    return count;
+}
+
+template<typename T>
+void encode_list(Writer& out, Span<T> items) {
+    out.value(static_cast<uint32_t>(items.size));
+    for (std::size_t i = 0; i < items.size; ++i) {
+        encode(out, items.data[i]);
+    }
+}
+
+template<typename T>
+Span<T> make_span(const std::vector<T>& items) {
+    return Span<T>{items.data(), items.size()};
+}
+
+template<typename T>
+void decode_list(Reader& in, std::vector<T>& items, uint32_t min_size) {
+    items.resize(decode_count(in, min_size));
+    for (T& item : items) {
+        decode(in, item);
+    }
+}
+
+/// Наибольшая длина строки в описании клиента.
+constexpr uint32_t kMaxStringLength = 256;
+
+void encode_string(Writer& out, const std::string& value) {
+    const uint32_t length = static_cast<uint32_t>(std::min<std::size_t>(value.size(), kMaxStringLength));
+    out.value(length);
+    out.bytes(value.data(), length);
+}
+
+void decode_string(Reader& in, std::string& value) {
+    uint32_t length = 0;
+    in.value(length);
+    if (length > kMaxStringLength || length > in.remaining()) {
+        throw std::runtime_error("некорректная длина строки в сообщении");
+    }
+    value.resize(length);
+    in.bytes(&value[0], length);
+}
+
+} // namespace
+
+void encode(Writer& out, const Envelope& envelope) {
+    EnvelopeBlock block{};
+    block.type = static_cast<uint16_t>(envelope.type);
+    block.protocol = envelope.protocol;
+    block.flags = envelope.flags;
+    block.correlation_id = envelope.correlation_id;
+    out.block(block);
+}
+
+void decode(Reader& in, Envelope& envelope) {
+    EnvelopeBlock block;
+    in.block(block);
+    if (block.protocol < kMinProtocolVersion) {
+        throw std::runtime_error("неподдерживаемая версия протокола " + std::to_string(block.protocol));
+    }
+    envelope.type = static_cast<MessageType>(block.type);
+    envelope.protocol = block.protocol;
+    envelope.flags = block.flags;
+    envelope.correlation_id = block.correlation_id;
+}
+
+void encode(Writer&, Empty) {
+}
+
+void decode(Reader&, Empty&) {
+}
+
+void encode(Writer& out, std::size_t value) {
+    out.value(static_cast<uint64_t>(value));
+}
+
+void decode(Reader& in, std::size_t& value) {
+    uint64_t wire_value = 0;
+    in.value(wire_value);
+    value = static_cast<std::size_t>(wire_value);
+}
+
+void encode(Writer& out, const IntegrationTask& task) {
+    if (task.params.size() > kMaxIntegrandParams) {
+        throw std::invalid_argument("слишком много параметров подынтегральной функции");
+    }
+    TaskBlock block{};
+    block.task_id = task.task_id;
+    block.job_id = task.job_id;
+    block.first_panel = task.first_panel;
+    block.last_panel = task.last_panel;
+    block.lower_bound = task.lower_bound;
+    block.upper_bound = task.upper_bound;
+    block.step = task.step;
+    block.abs_tol = task.abs_tol;
+    block.rel_tol = task.rel_tol;
+    std::copy(task.params.begin(), task.params.end(), block.params);
+    block.method = static_cast<uint32_t>(task.method);
+    block.order = task.order;
+    block.integrand = static_cast<uint32_t>(task.integrand);
+    block.flags = task.principal_value ? TaskBlock::kPrincipalValue : 0;
+    block.param_count = static_cast<uint32_t>(task.params.size());
+    out.block(block);
+}
+
+void decode(Reader& in, IntegrationTask& task) {
+    TaskBlock block;
+    in.block(block);
+    if (block.method > static_cast<uint32_t>(IntegrationMethod::Chebyshev) || block.integrand >= kIntegrandCount ||
+        block.param_count > kMaxIntegrandParams) {
+        throw std::runtime_error("некорректная задача в сообщении");
+    }
+    task.task_id = static_cast<std::size_t>(block.task_id);
+    task.job_id = static_cast<std::size_t>(block.job_id);
+    task.first_panel = block.first_panel;
+    task.last_panel = block.last_panel;
+    task.lower_bound = block.lower_bound;
+    task.upper_bound = block.upper_bound;
+    task.step = block.step;
+    task.abs_tol = block.abs_tol;
+    task.rel_tol = block.rel_tol;
+    task.params.assign(block.params, block.params + block.param_count);
+    task.method = static_cast<IntegrationMethod>(block.method);
+    task.order = block.order;
+    task.integrand = static_cast<IntegrandId>(block.integrand);
+    task.principal_value = (block.flags & TaskBlock::kPrincipalValue) != 0;
+}
+
+void encode(Writer& out, const IntegrationResult& result) {
+    // Передаются только ячейки точной суммы между младшей и старшей ненулевыми
+    const ExactSum::Raw raw = result.sum.raw();
+    int lowest = 0;
+    while (lowest < ExactSum::kChunks && raw.chunks[lowest] == 0) {
+        ++lowest;
+    }
+    int highest = ExactSum::kChunks;
+    while (highest > lowest && raw.chunks[highest - 1] == 0) {
+        --highest;
+    }
+
+    if (lowest == highest) {
+        lowest = highest = 0;
+    }
+
+    ResultBlock block{};
+    block.task_id = result.task_id;
+    block.result = result.result;
+    block.error_estimate = result.error_estimate;
+    block.special = raw.special;
+    block.lowest_chunk = lowest;
+    block.chunk_count = static_cast<uint32_t>(highest - lowest);
+    out.block(block);
+    out.bytes(raw.chunks.data() + block.lowest_chunk, block.chunk_count * sizeof(int64_t));
+}
+
+void decode(Reader& in, IntegrationResult& result) {
+    ResultBlock block;
+    in.block(block);
+    if (block.lowest_chunk < 0 || block.chunk_count > static_cast<uint32_t>(ExactSum::kChunks) ||
+        block.lowest_chunk + static_cast<int64_t>(block.chunk_count) > ExactSum::kChunks) {
+        throw std::runtime_error("некорректная точная сумма в сообщении");
+    }
+    ExactSum::Raw raw;
+    raw.special = block.special;
+    in.bytes(raw.chunks.data() + block.lowest_chunk, block.chunk_count * sizeof(int64_t));
+    if (!ExactSum::valid(raw)) {
+        throw std::runtime_error("некорректная точная сумма в сообщении");
+    }
+
+    result.task_id = static_cast<std::size_t>(block.task_id);
+    result.result = block.result;
+    result.error_estimate = block.error_estimate;
+    result.sum = ExactSum::from_raw(raw);
+}
+
+void encode(Writer& out, const CancelRequest& cancel) {
+    CancelBlock block{};
+    block.task_id = cancel.task_id;
+    block.job_id = cancel.job_id;
+    block.whole_job = cancel.whole_job ? 1 : 0;
+    out.block(block);
+}
+
+void decode(Reader& in, CancelRequest& cancel) {
+    CancelBlock block;
+    in.block(block);
+    cancel.task_id = static_cast<std::size_t>(block.task_id);
+    cancel.job_id = static_cast<std::size_t>(block.job_id);
+    cancel.whole_job = block.whole_job != 0;
+}
+
+void encode(Writer& out, const ProgressReport& report) {
+    ProgressBlock block{};
+    block.task_id = report.task_id;
+    block.job_id = report.job_id;
+    block.fraction = report.fraction;
+    block.partial_sum = report.partial_sum;
+    block.elapsed_seconds = report.elapsed_seconds;
+    block.evals_per_sec = report.evals_per_sec;
+    out.block(block);
+}
+
+void decode(Reader& in, ProgressReport& report) {
+    ProgressBlock block;
+    in.block(block);
+    report.task_id = static_cast<std::size_t>(block.task_id);
+    report.job_id = static_cast<std::size_t>(block.job_id);
+    report.fraction = block.fraction;
+    report.partial_sum = block.partial_sum;
+    report.elapsed_seconds = block.elapsed_seconds;
+    report.evals_per_sec = block.evals_per_sec;
+}
+
+void encode(Writer& out, const std::vector<IntegrationTask>& tasks) {
+    encode_list(out, make_span(tasks));
+}
+
+void encode(Writer& out, Span<IntegrationTask> tasks) {
+    encode_list(out, tasks);
+}
+
+void decode(Reader& in, std::vector<IntegrationTask>& tasks) {
+    decode_list(in, tasks, TaskBlock::kMinSize);
+}
+
+void encode(Writer& out, const std::vector<IntegrationResult>& results) {
+    encode_list(out, make_span(results));
+}
+
+void encode(Writer& out, Span<IntegrationResult> results) {
+    encode_list(out, results);
+}
+
+void decode(Reader& in, std::vector<IntegrationResult>& results) {
+    decode_list(in, results, ResultBlock::kMinSize);
+}
+
+void encode(Writer& out, const std::vector<ProgressReport>& reports) {
+    encode_list(out, make_span(reports));
+}
+
+void decode(Reader& in, std::vector<ProgressReport>& reports) {
+    decode_list(in, reports, ProgressBlock::kMinSize);
+}
+
+void encode(Writer& out, const ClientHello& hello) {
+    HelloBlock block{};
+    block.num_cores = hello.num_cores;
+    block.pinned_workers = hello.pinned_workers;
+    block.numa_nodes = hello.numa_nodes;
+    block.capacity = hello.capacity;
+    block.evals_per_sec = hello.evals_per_sec;
+    block.heartbeat_ms = hello.heartbeat_ms;
+    out.block(block);
+    encode_string(out, hello.isa);
+    encode_string(out, hello.pinning);
+    encode_string(out, hello.shared_memory);
+}
+
+void decode(Reader& in, ClientHello& hello) {
+    HelloBlock block;
+    in.block(block);
+    hello.num_cores = static_cast<std::size_t>(block.num_cores);
+    hello.pinned_workers = static_cast<std::size_t>(block.pinned_workers);
+    hello.numa_nodes = static_cast<std::size_t>(block.numa_nodes);
+    hello.capacity = block.capacity;
+    hello.evals_per_sec = block.evals_per_sec;
+    hello.heartbeat_ms = block.heartbeat_ms;
+    decode_string(in, hello.isa);
+    decode_string(in, hello.pinning);
+    if (block.version >= HelloBlock::kSharedMemoryVersion) {
+        decode_string(in, hello.shared_memory);
+    } else {
+        hello.shared_memory.clear();
+    }
+}
+
+bool Dispatcher::dispatch(const char* data, std::size_t size, Envelope& envelope) const {
+    Reader in(data, size);
+    decode(in, envelope);
+    const std::size_t index = static_cast<std::size_t>(envelope.type);
+    if (index >= handlers_.size() || !handlers_[index]) {
+        return false;
+    }
+    if (filter_ && !filter_(envelope)) {
+        return false;
+    }
+    handlers_[index](envelope, in);
+    return true;
+}
+
+} // namespace wire
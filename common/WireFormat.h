@@ -0,0 +1,407 @@
+#pragma once
+
+#include "DataStructures.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#if defined(__BYTE_ORDER__) && defined(__ORDER_BIG_ENDIAN__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#error "Двоичный формат сообщений определен в порядке байтов little-endian"
+#endif
+
+/**
+ * @brief Двоичный формат сообщений между сервером и клиентами.
+ *
+ * Сообщение - последовательность блоков фиксированной структуры в порядке
+ * байтов little-endian. Блок начинается с собственного размера и версии,
+ * поля выровнены естественно и не содержат пропусков, поэтому блок
+ * копируется в структуру одним memcpy, без разбора текста. Числа double
+ * передаются побитно. Читатель принимает блок любого размера не меньше
+ * первой версии: поля более новых версий пропускаются, отсутствующие поля
+ * более старых обнуляются. Переменная часть (разреженные ячейки ExactSum,
+ * строки, списки отчетов) идет после блока с явной длиной.
+ *
+ * Кадр - размер (4 байта), конверт (EnvelopeBlock) и данные сообщения.
+ * Конверт несет тип сообщения, версию протокола, флаги и номер для
+ * сопоставления (correlation id), поэтому получатель разбирает сообщения
+ * по таблице обработчиков (Dispatcher), а не по порядку их прихода:
+ * сообщения новых типов пропускаются.
+ */
+namespace wire {
+
+/// Версия протокола отправителя.
+constexpr uint16_t kProtocolVersion = 2;
+/// Версия протокола, с которой сервер отвечает на предложение общей памяти (MessageType::SharedMemory).
+constexpr uint16_t kSharedMemoryProtocolVersion = 2;
+/// Наименьшая версия протокола, сообщения которой понимает получатель.
+constexpr uint16_t kMinProtocolVersion = 1;
+
+/**
+ * @brief Тип сообщения и данные, которые оно несет.
+ */
+enum class MessageType : uint16_t {
+    Welcome = 0,     ///< Сервер: номер клиента (size_t)
+    Hello = 1,       ///< Клиент: описание клиента (ClientHello)
+    Task = 2,        ///< Сервер: задача (IntegrationTask)
+    TaskBatch = 3,   ///< Сервер: пачка задач (std::vector<IntegrationTask>)
+    Cancel = 4,      ///< Сервер: отмена задачи или запроса (CancelRequest)
+    Result = 5,      ///< Клиент: результат задачи (IntegrationResult)
+    ResultBatch = 6, ///< Клиент: пачка результатов одного запроса (std::vector<IntegrationResult>)
+    Progress = 7,    ///< Клиент: отчеты о выполняющихся задачах (std::vector<ProgressReport>)
+    Heartbeat = 8,   ///< Клиент: жив, задач нет (Empty)
+    SharedMemory = 9, ///< Сервер: ответ на предложение общей памяти (size_t: 1 - принято, 0 - нет)
+    TaskFailed = 10   ///< Клиент: задача не выполнена, результата не будет (size_t: номер задачи)
+};
+
+/// Число типов сообщений: размер таблицы обработчиков.
+constexpr std::size_t kMessageTypeCount = 11;
+
+/**
+ * @brief Конверт сообщения.
+ */
+struct Envelope {
+    MessageType type = MessageType::Heartbeat;
+    uint16_t protocol = kProtocolVersion; ///< Версия протокола отправителя
+    uint32_t flags = 0;                   ///< Флаги (зарезервировано, 0)
+    /// Номер для сопоставления: у задач, отмен и результатов - номер запроса сервера
+    uint64_t correlation_id = 0;
+};
+
+/**
+ * @brief Данные сообщения без полей (Heartbeat).
+ */
+struct Empty {};
+
+/**
+ * @brief Непрерывный диапазон элементов: кодируется как список, без копирования в std::vector.
+ */
+template<typename T>
+struct Span {
+    const T* data;
+    std::size_t size;
+};
+
+/**
+ * @brief Создает конверт сообщения.
+ *
+ * @param type Тип сообщения.
+ * @param correlation_id Номер для сопоставления.
+ */
+inline Envelope make_envelope(MessageType type, uint64_t correlation_id = 0) {
+    Envelope envelope;
+    envelope.type = type;
+    envelope.correlation_id = correlation_id;
+    return envelope;
+}
+
+/**
+ * @brief Конверт сообщения (Envelope).
+ */
+struct EnvelopeBlock {
+    static constexpr uint32_t kVersion = 1;
+    static constexpr uint32_t kMinSize = 24;
+
+    uint32_t size;
+    uint32_t version;
+    uint16_t type;
+    uint16_t protocol;
+    uint32_t flags;
+    uint64_t correlation_id;
+};
+
+/**
+ * @brief Задача интегрирования (IntegrationTask).
+ */
+struct TaskBlock {
+    static constexpr uint32_t kVersion = 1;
+    static constexpr uint32_t kMinSize = 120; ///< Размер версии 1
+    static constexpr uint32_t kPrincipalValue = 1; ///< Флаг вычитания особенности
+
+    uint32_t size;
+    uint32_t version;
+    uint64_t task_id;
+    uint64_t job_id;
+    uint64_t first_panel;
+    uint64_t last_panel;
+    double lower_bound;
+    double upper_bound;
+    double step;
+    double abs_tol;
+    double rel_tol;
+    double params[kMaxIntegrandParams];
+    uint32_t method;
+    uint32_t order;
+    uint32_t integrand;
+    uint32_t flags;
+    uint32_t param_count;
+    uint32_t reserved;
+};
+
+/**
+ * @brief Результат задачи (IntegrationResult); за блоком следуют chunk_count ячеек ExactSum по 8 байт.
+ */
+struct ResultBlock {
+    static constexpr uint32_t kVersion = 1;
+    static constexpr uint32_t kMinSize = 48;
+
+    uint32_t size;
+    uint32_t version;
+    uint64_t task_id;
+    double result;
+    double error_estimate;
+    double special;       ///< Сумма бесконечностей и NaN
+    int32_t lowest_chunk; ///< Номер первой передаваемой ячейки
+    uint32_t chunk_count;
+};
+
+/**
+ * @brief Запрос отмены (CancelRequest).
+ */
+struct CancelBlock {
+    static constexpr uint32_t kVersion = 1;
+    static constexpr uint32_t kMinSize = 32;
+
+    uint32_t size;
+    uint32_t version;
+    uint64_t task_id;
+    uint64_t job_id;
+    uint32_t whole_job;
+    uint32_t reserved;
+};
+
+/**
+ * @brief Отчет о ходе задачи (ProgressReport).
+ */
+struct ProgressBlock {
+    static constexpr uint32_t kVersion = 1;
+    static constexpr uint32_t kMinSize = 56;
+
+    uint32_t size;
+    uint32_t version;
+    uint64_t task_id;
+    uint64_t job_id;
+    double fraction;
+    double partial_sum;
+    double elapsed_seconds;
+    double evals_per_sec;
+};
+
+/**
+ * @brief Описание клиента (ClientHello); за блоком следуют строки isa, pinning и shared_memory.
+ *
+ * Строка shared_memory появилась в версии 2 блока: у блока версии 1 ее нет,
+ * и она читается как пустая.
+ */
+struct HelloBlock {
+    static constexpr uint32_t kVersion = 2;
+    static constexpr uint32_t kSharedMemoryVersion = 2; ///< Первая версия со строкой shared_memory
+    static constexpr uint32_t kMinSize = 56;
+
+    uint32_t size;
+    uint32_t version;
+    uint64_t num_cores;
+    uint64_t pinned_workers;
+    uint64_t numa_nodes;
+    double capacity;
+    double evals_per_sec;
+    uint32_t heartbeat_ms;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(EnvelopeBlock) == EnvelopeBlock::kMinSize,
+              "раскладка EnvelopeBlock не должна зависеть от компилятора");
+static_assert(sizeof(TaskBlock) == TaskBlock::kMinSize, "раскладка TaskBlock не должна зависеть от компилятора");
+static_assert(sizeof(ResultBlock) == ResultBlock::kMinSize, "раскладка ResultBlock не должна зависеть от компилятора");
+static_assert(sizeof(CancelBlock) == CancelBlock::kMinSize, "раскладка CancelBlock не должна зависеть от компилятора");
+static_assert(sizeof(ProgressBlock) == ProgressBlock::kMinSize,
+              "раскладка ProgressBlock не должна зависеть от компилятора");
+static_assert(sizeof(HelloBlock) == HelloBlock::kMinSize, "раскладка HelloBlock не должна зависеть от компилятора");
+
+/**
+ * @brief Дописывает данные сообщения в буфер.
+ */
+class Writer {
+public:
+    explicit Writer(std::vector<char>& out) : out_(out) {}
+
+    void bytes(const void* data, std::size_t size) {
+        const char* begin = static_cast<const char*>(data);
+        out_.insert(out_.end(), begin, begin + size);
+    }
+
+    template<class T>
+    void value(const T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "передаются только тривиально копируемые значения");
+        bytes(&value, sizeof(value));
+    }
+
+    /**
+     * @brief Дописывает блок, заполняя его размер и версию.
+     */
+    template<class Block>
+    void block(Block block) {
+        block.size = sizeof(Block);
+        block.version = Block::kVersion;
+        value(block);
+    }
+
+private:
+    std::vector<char>& out_;
+};
+
+/**
+ * @brief Читает данные сообщения из буфера.
+ *
+ * Выход за конец сообщения и некорректные размеры блоков - исключение std::runtime_error.
+ */
+class Reader {
+public:
+    Reader(const char* data, std::size_t size) : data_(data), remaining_(size) {}
+
+    void bytes(void* out, std::size_t size) {
+        require(size);
+        std::memcpy(out, data_, size);
+        skip(size);
+    }
+
+    template<class T>
+    void value(T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "передаются только тривиально копируемые значения");
+        bytes(&value, sizeof(value));
+    }
+
+    /**
+     * @brief Читает блок любой версии (см. описание формата).
+     */
+    template<class Block>
+    void block(Block& block) {
+        uint32_t size = 0;
+        require(sizeof(size));
+        std::memcpy(&size, data_, sizeof(size));
+        if (size < Block::kMinSize) {
+            throw std::runtime_error("блок сообщения короче первой версии");
+        }
+        require(size);
+        std::memset(&block, 0, sizeof(block));
+        std::memcpy(&block, data_, size < sizeof(Block) ? size : sizeof(Block));
+        skip(size);
+    }
+
+    std::size_t remaining() const {
+        return remaining_;
+    }
+
+private:
+    void require(std::size_t size) const {
+        if (size > remaining_) {
+            throw std::runtime_error("сообщение усечено");
+        }
+    }
+
+    void skip(std::size_t size) {
+        data_ += size;
+        remaining_ -= size;
+    }
+
+    const char* data_;
+    std::size_t remaining_;
+};
+
+// Кодирование конверта и данных сообщений
+void encode(Writer& out, const Envelope& envelope);
+void encode(Writer& out, Empty);
+void encode(Writer& out, std::size_t value);
+void encode(Writer& out, const IntegrationTask& task);
+void encode(Writer& out, const std::vector<IntegrationTask>& tasks);
+void encode(Writer& out, Span<IntegrationTask> tasks);
+void encode(Writer& out, const IntegrationResult& result);
+void encode(Writer& out, const std::vector<IntegrationResult>& results);
+void encode(Writer& out, Span<IntegrationResult> results);
+void encode(Writer& out, const CancelRequest& cancel);
+void encode(Writer& out, const ProgressReport& report);
+void encode(Writer& out, const std::vector<ProgressReport>& reports);
+void encode(Writer& out, const ClientHello& hello);
+
+// Декодирование; некорректное сообщение - исключение std::runtime_error
+void decode(Reader& in, Envelope& envelope);
+void decode(Reader& in, Empty&);
+void decode(Reader& in, std::size_t& value);
+void decode(Reader& in, IntegrationTask& task);
+void decode(Reader& in, std::vector<IntegrationTask>& tasks);
+void decode(Reader& in, IntegrationResult& result);
+void decode(Reader& in, std::vector<IntegrationResult>& results);
+void decode(Reader& in, CancelRequest& cancel);
+void decode(Reader& in, ProgressReport& report);
+void decode(Reader& in, std::vector<ProgressReport>& reports);
+void decode(Reader& in, ClientHello& hello);
+
+/**
+ * @brief Кодирует сообщение: конверт и данные.
+ */
+template<typename T>
+void encode_message(Writer& out, const Envelope& envelope, const T& payload) {
+    encode(out, envelope);
+    encode(out, payload);
+}
+
+/**
+ * @brief Таблица обработчиков сообщений по типу.
+ *
+ * Обработчик получает конверт и декодированные данные; объект данных
+ * принадлежит таблице и переиспользуется следующим сообщением того же типа,
+ * поэтому разбор не выделяет память, пока сообщения не растут. Сообщение
+ * типа без обработчика (в том числе неизвестного этой версии типа) пропускается без
+ * разбора данных. Фильтр, если задан, видит конверт до разбора данных и
+ * может отбросить сообщение.
+ */
+class Dispatcher {
+public:
+    using Filter = std::function<bool(const Envelope&)>;
+
+    /**
+     * @brief Регистрирует обработчик сообщений типа type с данными типа T.
+     *
+     * @param type Тип сообщения.
+     * @param handler Вызывается как handler(const Envelope&, T&).
+     */
+    template<typename T, typename Handler>
+    void on(MessageType type, Handler handler) {
+        // Данные декодируются в один и тот же объект: его векторы сохраняют емкость между сообщениями
+        auto payload = std::make_shared<T>();
+        handlers_[static_cast<std::size_t>(type)] = [payload, handler](const Envelope& envelope, Reader& in) {
+            decode(in, *payload);
+            handler(envelope, *payload);
+        };
+    }
+
+    /**
+     * @brief Задает фильтр конвертов (false - сообщение отбрасывается без разбора данных).
+     */
+    void set_filter(Filter filter) {
+        filter_ = std::move(filter);
+    }
+
+    /**
+     * @brief Разбирает кадр и вызывает обработчик его типа.
+     *
+     * @param data Кадр без префикса размера.
+     * @param size Размер кадра.
+     * @param envelope Конверт кадра.
+     * @return false, если сообщение пропущено (нет обработчика или отброшено фильтром).
+     * @throws std::runtime_error Если кадр некорректен.
+     */
+    bool dispatch(const char* data, std::size_t size, Envelope& envelope) const;
+
+private:
+    std::array<std::function<void(const Envelope&, Reader&)>, kMessageTypeCount> handlers_;
+    Filter filter_;
+};
+
+} // namespace wire
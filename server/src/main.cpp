@@ -1,9 +1,11 @@
+#include <algorithm>
 #include <iostream>
 #include <string>
 #include <vector>
 #include <numeric>
 #include <thread>
 #include <map>
+#include <set>
 #include <mutex>
 #include <future>
 #include <atomic>
@@ -12,12 +14,21 @@
 #include <sstream>
 #include <chrono>
 #include <functional>
+#include <limits>
+#include <memory>
+#include <cstdio>
+#include <filesystem>
 
 #include <boost/asio.hpp>
-#include <boost/archive/text_iarchive.hpp>
-#include <boost/archive/text_oarchive.hpp>
+
+#if defined(__linux__)
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
 
 #include "../../common/DataStructures.h"
+#include "../../common/IntegrationKernels.h"
+#include "../../common/LogIntegral.h"
 #include "../../common/Logger.h"
 #include "../../common/Utils.h"
 
@@ -31,42 +42,149 @@ public:
     /**
      * @brief Конструктор сессии клиента.
      * 
-     * @param socket Сокет для связи с клиентом.
+     * @param socket Сокет для связи с клиентом (TCP или AF_UNIX).
      * @param id Уникальный идентификатор сессии.
      */
-    ClientSession(boost::asio::ip::tcp::socket socket, size_t id)
-        : socket_(std::move(socket)), id_(id), num_cores_(0) {
+    ClientSession(MessageSocket socket, size_t id)
+        : socket_(std::move(socket)), channel_(socket_), id_(id), num_cores_(0) {
         LOG_INFO << "Сессия клиента " << id_ << " создана.";
     }
 
     /**
      * @brief Запускает сессию клиента.
      * 
-     * Отправляет клиенту его ID, получает количество ядер CPU от клиента,
+     * Отправляет клиенту его ID, получает количество ядер CPU и вариант ядра от клиента,
      * затем начинает ожидание результатов.
      */
     void start() {
         try {
             // Отправляем клиенту его ID сессии
-            send_data(socket_, id_);
+            channel_.send(wire::make_envelope(wire::MessageType::Welcome), id_);
             
-            // Получаем количество ядер CPU от клиента
-            receive_data(socket_, num_cores_);
+            // Получаем количество ядер CPU и вариант вычислительного ядра от клиента
+            ClientHello hello;
+            channel_.receive(wire::MessageType::Hello, hello);
+            num_cores_ = hello.num_cores;
+            isa_ = hello.isa;
 
             if (num_cores_ == 0) {
                 num_cores_ = std::thread::hardware_concurrency();
                 LOG_WARNING << "Клиент " << id_ << " сообщил 0 ядер, используем значение по умолчанию: " << num_cores_;
             } else {
-                LOG_INFO << "Клиент " << id_ << " сообщил количество ядер CPU: " << num_cores_;
+                LOG_INFO << "Клиент " << id_ << " сообщил количество ядер CPU: " << num_cores_
+                         << ", вычислительное ядро: " << isa_;
+            }
+            // Старые клиенты не сообщают емкость: считаем ее равной числу ядер
+            capacity_ = hello.capacity > 0.0 ? hello.capacity : static_cast<double>(num_cores_);
+            throughput_ = hello.evals_per_sec;
+            heartbeat_ms_ = hello.heartbeat_ms;
+            last_seen_ = std::chrono::steady_clock::now().time_since_epoch().count();
+            LOG_INFO << "Емкость клиента " << id_ << ": " << capacity_ << " ядер, калибровка: "
+                     << throughput_ << " вычислений/с";
+            LOG_INFO << "Размещение потоков клиента " << id_ << ": закрепление " << hello.pinning
+                     << ", закреплено " << hello.pinned_workers << ", узлов NUMA " << hello.numa_nodes;
+            if (heartbeat_ms_ > 0) {
+                LOG_INFO << "Клиент " << id_ << " сообщает о ходе задач каждые " << heartbeat_ms_ << " мс";
+            }
+            if (!hello.shared_memory.empty()) {
+                accept_shared_memory(hello.shared_memory);
             }
 
             // Начинаем асинхронное чтение результатов от клиента
             do_read_result();
         } catch (const std::exception& e) {
+            alive_ = false;
             LOG_ERROR << "Ошибка при инициализации сессии клиента " << id_ << ": " << e.what();
         }
     }
 
+    /**
+     * @brief Отвечает на предложение клиента обмениваться сообщениями через общую память.
+     * 
+     * Если сегмент отображен, дальнейшие сообщения сессии идут через его
+     * кольца; иначе клиенту отправляется отказ, и обмен остается в сокете.
+     * Выбор делается для каждой сессии отдельно; предложение принимается
+     * только от процесса того же пользователя через локальный сокет.
+     * 
+     * @param name Имя сегмента, созданного клиентом.
+     */
+    void accept_shared_memory(const std::string& name) {
+        std::unique_ptr<SharedMemoryTransport> transport;
+        if (!local_peer()) {
+            LOG_WARNING << "Клиент " << id_ << " предложил общую память не через локальный сокет "
+                        << "или от другого пользователя, предложение отклонено";
+        } else {
+            try {
+                transport = SharedMemoryTransport::open(name);
+            } catch (const std::exception& e) {
+                LOG_WARNING << "Не удалось подключить общую память клиента " << id_ << ": " << e.what();
+            }
+        }
+        // Ответ уходит еще через сокет: клиент переключается, только получив его
+        channel_.send(wire::make_envelope(wire::MessageType::SharedMemory), static_cast<size_t>(transport ? 1 : 0));
+        if (transport) {
+            LOG_INFO << "Клиент " << id_ << " обменивается сообщениями через общую память " << name << " (кольца по "
+                     << transport->ring_size() << " байт)";
+            channel_.use_shared_memory(std::move(transport));
+        }
+    }
+
+    /**
+     * @brief Проверяет, что клиент подключен через сокет AF_UNIX процессом того же пользователя.
+     *
+     * Имя сегмента из сетевой сессии относится к чужому узлу, а пользователь
+     * собеседника известен только для локального сокета (SO_PEERCRED).
+     */
+    bool local_peer() {
+#if defined(__linux__)
+        boost::system::error_code error;
+        const auto endpoint = socket_.local_endpoint(error);
+        if (error || endpoint.protocol().family() != AF_UNIX) {
+            return false;
+        }
+        ucred credentials{};
+        socklen_t length = sizeof(credentials);
+        return ::getsockopt(socket_.native_handle(), SOL_SOCKET, SO_PEERCRED, &credentials, &length) == 0 &&
+               credentials.uid == ::geteuid();
+#else
+        // Общая память поддерживается только в Linux
+        return false;
+#endif
+    }
+
+    /**
+     * @brief Проверяет, что клиент на связи.
+     * 
+     * Клиент потерян, если соединение разорвано или, для клиентов с
+     * heartbeat, от него дольше kMissedHeartbeats периодов (и не меньше
+     * kMinSilence) не приходило ни одного сообщения: зависший процесс
+     * или пропавший узел не закрывают TCP-соединение.
+     * 
+     * @param now Текущее время.
+     * @return false, если клиент потерян.
+     */
+    bool responsive(std::chrono::steady_clock::time_point now) const {
+        if (!alive_) {
+            return false;
+        }
+        if (heartbeat_ms_ == 0) {
+            return true;
+        }
+        const std::chrono::steady_clock::time_point last_seen{std::chrono::steady_clock::duration(last_seen_.load())};
+        const auto silence_limit = std::max<std::chrono::steady_clock::duration>(
+            kMinSilence, std::chrono::milliseconds(heartbeat_ms_) * kMissedHeartbeats);
+        return now - last_seen < silence_limit;
+    }
+
+    /**
+     * @brief Закрывает соединение с клиентом; поток чтения при этом завершается.
+     */
+    void close() {
+        std::lock_guard<std::mutex> lock(socket_mutex_);
+        alive_ = false;
+        channel_.shutdown();
+    }
+
     /**
      * @brief Получает идентификатор сессии.
      * 
@@ -86,12 +204,45 @@ public:
     }
 
     /**
-     * @brief Получает ссылку на сокет клиента.
+     * @brief Получает эффективную емкость клиента.
+     * 
+     * @return Емкость в ядрах с учетом квот контейнера (может быть дробной).
+     */
+    double get_capacity() const {
+        return capacity_;
+    }
+
+    /**
+     * @brief Получает оценку производительности клиента.
+     * 
+     * @return Вычислений функции в секунду (0 - клиент не сообщил калибровку).
+     */
+    double get_throughput() const {
+        return throughput_;
+    }
+
+    /**
+     * @brief Уточняет оценку производительности по наблюдаемому времени выполнения задач.
      * 
-     * @return Ссылка на сокет.
+     * Новая оценка - среднее калибровки (или прежней оценки) и наблюдения,
+     * поэтому одна задача, задержанная сетью, не меняет вес клиента резко.
+     * 
+     * @param observed Вычислений функции в секунду по времени выполнения задач.
+     */
+    void refine_throughput(double observed) {
+        throughput_ = throughput_ > 0.0 ? (1.0 - kThroughputSmoothing) * throughput_ + kThroughputSmoothing * observed
+                                        : observed;
+        LOG_INFO << "Производительность клиента " << id_ << ": наблюдается " << observed
+                 << " вычислений/с, новая оценка " << throughput_;
+    }
+
+    /**
+     * @brief Получает имя варианта вычислительного ядра клиента.
+     * 
+     * @return Набор инструкций ("sse2", "avx2", "avx512").
      */
-    boost::asio::ip::tcp::socket& get_socket() {
-        return socket_;
+    const std::string& get_isa() const {
+        return isa_;
     }
 
     /**
@@ -102,7 +253,8 @@ public:
     void send_task(const IntegrationTask& task) {
         std::lock_guard<std::mutex> lock(socket_mutex_);
         try {
-            send_data(socket_, task);
+            current_job_ = task.job_id;
+            channel_.send(wire::make_envelope(wire::MessageType::Task, task.job_id), task);
             LOG_INFO << "Задача " << task.task_id << " отправлена клиенту " << id_;
         } catch (const std::exception& e) {
             LOG_ERROR << "Ошибка при отправке задачи клиенту " << id_ << ": " << e.what();
@@ -110,6 +262,75 @@ public:
         }
     }
 
+    /**
+     * @brief Выбирает размер пачки задач по производительности клиента.
+     * 
+     * Пачка - примерно kTaskBatchTime работы клиента: быстрый клиент получает
+     * мелкие задачи большими пачками, медленный начинает считать, не дожидаясь
+     * разбора длинного сообщения.
+     * 
+     * @param evaluations_per_task Среднее число вычислений функции в задаче (0 - неизвестно).
+     * @return Задач в пачке, [1, kMaxTaskBatch].
+     */
+    size_t task_batch_size(double evaluations_per_task) const {
+        if (throughput_ <= 0.0 || evaluations_per_task <= 0.0) {
+            return kDefaultTaskBatch;
+        }
+        const double tasks = throughput_ * kTaskBatchTime / evaluations_per_task;
+        return static_cast<size_t>(std::max(1.0, std::min(tasks, static_cast<double>(kMaxTaskBatch))));
+    }
+
+    /**
+     * @brief Отправляет клиенту задачи пачками одной записью в сокет.
+     * 
+     * Пачки кодируются прямо из tasks в буфер записи соединения, без
+     * промежуточных копий задач.
+     * 
+     * @param tasks Задачи одного запроса.
+     * @param batch_size Задач в пачке (task_batch_size()).
+     */
+    void send_tasks(const std::vector<IntegrationTask>& tasks, size_t batch_size) {
+        if (tasks.empty()) {
+            return;
+        }
+        const size_t job_id = tasks.front().job_id;
+        std::lock_guard<std::mutex> lock(socket_mutex_);
+        try {
+            size_t batches = 0;
+            for (size_t first = 0; first < tasks.size(); first += batch_size) {
+                const size_t count = std::min(batch_size, tasks.size() - first);
+                channel_.queue(wire::make_envelope(wire::MessageType::TaskBatch, job_id),
+                               wire::Span<IntegrationTask>{tasks.data() + first, count});
+                ++batches;
+            }
+            current_job_ = job_id;
+            channel_.flush();
+            LOG_INFO << "Клиенту " << id_ << " отправлено задач: " << tasks.size() << " в " << batches << " пачках";
+        } catch (const std::exception& e) {
+            LOG_ERROR << "Ошибка при отправке задач клиенту " << id_ << ": " << e.what();
+            throw;
+        }
+    }
+
+    /**
+     * @brief Отправляет клиенту запрос отмены задачи или запроса.
+     * 
+     * Ошибка отправки не пробрасывается: отключившийся клиент и так не считает.
+     * 
+     * @param cancel Запрос отмены.
+     */
+    void send_cancel(const CancelRequest& cancel) {
+        std::lock_guard<std::mutex> lock(socket_mutex_);
+        try {
+            channel_.send(wire::make_envelope(wire::MessageType::Cancel, cancel.job_id), cancel);
+            LOG_INFO << "Клиенту " << id_ << " отправлена отмена "
+                     << (cancel.whole_job ? "запроса " : "задачи ")
+                     << (cancel.whole_job ? cancel.job_id : cancel.task_id);
+        } catch (const std::exception& e) {
+            LOG_WARNING << "Не удалось отправить отмену клиенту " << id_ << ": " << e.what();
+        }
+    }
+
     /**
      * @brief Устанавливает callback для обработки результатов.
      * 
@@ -119,38 +340,142 @@ public:
         result_callback_ = callback;
     }
 
+    /**
+     * @brief Устанавливает callback для задач, которые клиент не смог выполнить.
+     * 
+     * @param callback Функция, получающая номер задачи и номер сессии.
+     */
+    void set_failure_callback(std::function<void(size_t, size_t)> callback) {
+        failure_callback_ = callback;
+    }
+
+    /**
+     * @brief Устанавливает callback для обработки отчетов о ходе задач.
+     * 
+     * @param callback Функция, которая будет вызвана при получении отчетов.
+     */
+    void set_progress_callback(std::function<void(const std::vector<ProgressReport>&)> callback) {
+        progress_callback_ = callback;
+    }
+
 private:
     /**
-     * @brief Асинхронно читает результат от клиента.
+     * @brief Асинхронно читает результаты, отчеты о ходе задач и heartbeat от клиента.
+     * 
+     * Сообщения разбираются по таблице обработчиков. Результаты запроса,
+     * задачи которого клиенту уже не принадлежат (номер запроса в конверте
+     * отличается от последнего отправленного), отбрасываются без разбора.
      */
     void do_read_result() {
         auto self = shared_from_this();
         
         // Используем отдельный поток для синхронного чтения
         std::thread([this, self]() {
+            wire::Dispatcher dispatcher;
+            dispatcher.on<IntegrationResult>(wire::MessageType::Result,
+                [this](const wire::Envelope&, IntegrationResult& result) { handle_result(result); });
+            dispatcher.on<std::vector<IntegrationResult>>(wire::MessageType::ResultBatch,
+                [this](const wire::Envelope&, std::vector<IntegrationResult>& results) {
+                    LOG_INFO << "Получена пачка результатов от клиента " << id_ << ": " << results.size();
+                    for (const IntegrationResult& result : results) {
+                        handle_result(result);
+                    }
+                });
+            dispatcher.on<size_t>(wire::MessageType::TaskFailed, [this](const wire::Envelope&, size_t& task_id) {
+                LOG_WARNING << "Клиент " << id_ << " не смог выполнить задачу " << task_id;
+                if (failure_callback_) {
+                    failure_callback_(task_id, id_);
+                }
+            });
+            dispatcher.on<std::vector<ProgressReport>>(wire::MessageType::Progress,
+                [this](const wire::Envelope&, std::vector<ProgressReport>& reports) {
+                    if (progress_callback_) {
+                        progress_callback_(reports);
+                    }
+                });
+            // Heartbeat только обновляет время последнего сообщения
+            dispatcher.on<wire::Empty>(wire::MessageType::Heartbeat, [](const wire::Envelope&, wire::Empty&) {});
+            dispatcher.set_filter([this](const wire::Envelope& envelope) {
+                const bool result = envelope.type == wire::MessageType::Result ||
+                                    envelope.type == wire::MessageType::ResultBatch ||
+                                    envelope.type == wire::MessageType::TaskFailed;
+                if (result && envelope.correlation_id != current_job_) {
+                    LOG_WARNING << "Отброшены результаты клиента " << id_ << " для завершенного запроса "
+                                << envelope.correlation_id;
+                    return false;
+                }
+                return true;
+            });
+
             try {
+                wire::Envelope envelope;
                 while (true) {
-                    IntegrationResult result;
-                    receive_data(socket_, result);
-                    
-                    LOG_INFO << "Получен результат от клиента " << id_ << " для задачи " << result.task_id 
-                             << ": " << result.result;
-                    
-                    if (result_callback_) {
-                        result_callback_(result);
+                    const bool handled = channel_.receive(dispatcher, envelope);
+                    last_seen_ = std::chrono::steady_clock::now().time_since_epoch().count();
+                    if (!handled) {
+                        LOG_DEBUG << "Сообщение типа " << static_cast<unsigned>(envelope.type) << " от клиента "
+                                  << id_ << " пропущено";
                     }
                 }
             } catch (const std::exception& e) {
                 LOG_INFO << "Клиент " << id_ << " отключился: " << e.what();
             }
+            alive_ = false;
         }).detach();
     }
 
-    boost::asio::ip::tcp::socket socket_;
+    /**
+     * @brief Передает результат серверу.
+     */
+    void handle_result(const IntegrationResult& result) {
+        LOG_INFO << "Получен результат от клиента " << id_ << " для задачи " << result.task_id << ": " << result.result;
+        if (result_callback_) {
+            result_callback_(result);
+        }
+    }
+
+    MessageSocket socket_;
+    MessageChannel channel_; ///< Буферы сообщений соединения; запись - под socket_mutex_
     size_t id_;
+    /// Вес наблюдения при уточнении производительности
+    static constexpr double kThroughputSmoothing = 0.5;
+    /// Пропущенных подряд heartbeat, после которых клиент считается потерянным
+    static constexpr int kMissedHeartbeats = 10;
+    /// Наименьшее молчание, после которого клиент считается потерянным
+    static constexpr std::chrono::seconds kMinSilence{5};
+    /// Время работы клиента, на которое рассчитана пачка задач, секунд
+    static constexpr double kTaskBatchTime = 0.05;
+    /// Наибольшее число задач в пачке
+    static constexpr size_t kMaxTaskBatch = 256;
+    /// Задач в пачке, если производительность клиента или размер задач неизвестны
+    static constexpr size_t kDefaultTaskBatch = 16;
+
     size_t num_cores_;
+    double capacity_ = 0.0;
+    double throughput_ = 0.0; ///< Вычислений функции в секунду
+    std::string isa_;
     std::function<void(const IntegrationResult&)> result_callback_;
+    std::function<void(size_t, size_t)> failure_callback_;
+    std::function<void(const std::vector<ProgressReport>&)> progress_callback_;
     std::mutex socket_mutex_; ///< Мьютекс для синхронизации доступа к сокету
+    unsigned heartbeat_ms_ = 0;               ///< Период heartbeat клиента (0 - не отправляет)
+    std::atomic<bool> alive_{true};           ///< Соединение не разорвано
+    std::atomic<int64_t> last_seen_{0};       ///< Время последнего сообщения (steady_clock, такты)
+    std::atomic<size_t> current_job_{0};      ///< Запрос последних отправленных задач
+};
+
+/**
+ * @brief Ход выполнения запроса по отчетам клиентов.
+ */
+struct JobProgress {
+    size_t job_id = 0;                ///< Запрос
+    size_t tasks = 0;                 ///< Подзадач в запросе
+    size_t completed = 0;             ///< Подзадач с полученным результатом
+    double fraction = 0.0;            ///< Выполненная доля работы (по вычислениям функции)
+    double partial_sum = 0.0;         ///< Сумма готовых подзадач и готовых частей остальных
+    double elapsed_seconds = 0.0;     ///< Время с начала запроса
+    double eta_seconds = -1.0;        ///< Оценка оставшегося времени (-1 - пока неизвестна)
+    std::vector<size_t> stragglers;   ///< Отстающие подзадачи
 };
 
 /**
@@ -164,20 +489,55 @@ public:
     /**
      * @brief Конструктор сервера.
      * 
+     * Клиенты на том же узле могут подключаться через сокет AF_UNIX: кадры
+     * те же, что и по TCP, но без стека TCP, а доступ ограничивается правами
+     * на файл сокета. Оставшийся от прошлого запуска файл сокета заменяется
+     * (remove_stale_socket()); чужой файл или работающий сервер - ошибка.
+     * 
      * @param io_context Контекст ввода-вывода Boost.Asio.
-     * @param port Порт для прослушивания подключений.
+     * @param port Порт для прослушивания подключений (0 - не слушать TCP).
+     * @param unix_path Путь сокета AF_UNIX (пусто - не слушать).
      */
-    Server(boost::asio::io_context& io_context, short port)
-        : acceptor_(io_context, boost::asio::ip::tcp::endpoint(boost::asio::ip::tcp::v4(), port)),
+    Server(boost::asio::io_context& io_context, unsigned short port, const std::string& unix_path = "")
+        : unix_path_(unix_path),
           next_client_id_(0),
           next_task_id_(0),
           total_cores_(0),
           results_received_(0),
           expected_results_(0),
           final_result_(0.0),
+          final_error_(0.0),
           results_ready_(false) {
-        LOG_INFO << "Сервер запущен на порту " << port;
-        do_accept();
+        if (port != 0) {
+            acceptor_ = std::make_unique<boost::asio::ip::tcp::acceptor>(
+                io_context, boost::asio::ip::tcp::endpoint(boost::asio::ip::tcp::v4(), port));
+            LOG_INFO << "Сервер запущен на порту " << port;
+            do_accept(*acceptor_);
+        }
+        if (!unix_path_.empty()) {
+#if defined(BOOST_ASIO_HAS_LOCAL_SOCKETS)
+            remove_stale_socket(io_context, unix_path_);
+            local_acceptor_ = std::make_unique<boost::asio::local::stream_protocol::acceptor>(
+                io_context, boost::asio::local::stream_protocol::endpoint(unix_path_));
+            LOG_INFO << "Сервер принимает подключения через сокет " << unix_path_;
+            do_accept(*local_acceptor_);
+#else
+            throw std::runtime_error("сокеты AF_UNIX не поддерживаются на этой платформе");
+#endif
+        }
+    }
+
+    /**
+     * @brief Удаляет файл сокета AF_UNIX.
+     */
+    ~Server() {
+#if defined(BOOST_ASIO_HAS_LOCAL_SOCKETS)
+        if (local_acceptor_) {
+            boost::system::error_code ignored;
+            local_acceptor_->close(ignored);
+            std::remove(unix_path_.c_str());
+        }
+#endif
     }
 
     /**
@@ -189,44 +549,124 @@ public:
      * @param lower_bound Нижний предел интегрирования.
      * @param upper_bound Верхний предел интегрирования.
      * @param step Шаг интегрирования.
+     * @param method Метод интегрирования.
+     * @param order Параметр метода (0 - значение по умолчанию).
      * @return Результат интегрирования.
      */
-    double handle_integration_request(double lower_bound, double upper_bound, double step) {
-        LOG_INFO << "Получен запрос на интегрирование: [" << lower_bound << ", " << upper_bound 
-                 << "] с шагом " << step;
+    double handle_integration_request(double lower_bound, double upper_bound, double step,
+                                      IntegrationMethod method = IntegrationMethod::Midpoint,
+                                      unsigned order = 0) {
+        IntegrationTask request;
+        request.lower_bound = lower_bound;
+        request.upper_bound = upper_bound;
+        request.step = step;
+        request.task_id = 0;
+        request.method = method;
+        request.order = order;
+        return handle_integration_request(request).result;
+    }
+
+    /**
+     * @brief Обрабатывает запрос на интегрирование, заданный описанием всей задачи.
+     * 
+     * Границы, метод, шаг и допуски запроса переносятся в подзадачи; допустимая
+     * абсолютная погрешность делится между подзадачами пропорционально их длине.
+     * 
+     * @param request Описание задачи на всем диапазоне (task_id не используется).
+     * @return Результат интегрирования и суммарная оценка погрешности.
+     */
+    IntegrationResult handle_integration_request(const IntegrationTask& request) {
+        LOG_INFO << "Получен запрос на интегрирование: [" << request.lower_bound << ", " << request.upper_bound 
+                 << "] с шагом " << request.step << ", метод " << static_cast<unsigned>(request.method)
+                 << ", функция " << kernels::integrand_info(request.integrand).name
+                 << " (параметр " << request.order << ", допуски " << request.abs_tol << "/" << request.rel_tol
+                 << (request.principal_value ? ", вычитание особенности" : "") << ")";
+
+        IntegrationResult empty_result = {0.0, 0, 0.0, ExactSum()};
+        if (request.method == IntegrationMethod::ClosedForm) {
+            IntegrationResult result = empty_result;
+            if (integrate_closed_form(request, result)) {
+                return result;
+            }
+            // Точной формулы для функции нет: клиенты считают адаптивным методом
+            IntegrationTask adaptive = request;
+            adaptive.method = IntegrationMethod::AdaptiveGaussKronrod;
+            adaptive.rel_tol = kernels::kDefaultRelTol;
+            return handle_integration_request(adaptive);
+        }
 
         std::lock_guard<std::mutex> lock(clients_mutex_);
         
         if (clients_.empty()) {
             LOG_WARNING << "Нет подключенных клиентов для выполнения задачи.";
-            return 0.0;
+            return empty_result;
         }
 
-        // Подсчитываем общее количество ядер CPU
+        // Подсчитываем общее количество ядер CPU и общую емкость
         total_cores_ = 0;
+        double total_capacity = 0.0;
+        double total_throughput = 0.0;
+        bool all_calibrated = true;
         for (const auto& pair : clients_) {
             total_cores_ += pair.second->get_num_cores();
+            total_capacity += pair.second->get_capacity();
+            total_throughput += pair.second->get_throughput();
+            all_calibrated = all_calibrated && pair.second->get_throughput() > 0.0;
         }
 
         if (total_cores_ == 0) {
             LOG_WARNING << "Общее количество ядер CPU равно нулю.";
-            return 0.0;
+            return empty_result;
         }
 
-        LOG_INFO << "Общее количество ядер CPU всех клиентов: " << total_cores_;
+        LOG_INFO << "Общее количество ядер CPU всех клиентов: " << total_cores_ << " (емкость " << total_capacity << ")";
+
+        // Побитная воспроизводимость: варианты с FMA и без него округляют узлы по-разному
+        size_t fma_clients = 0;
+        for (const auto& pair : clients_) {
+            const std::string& isa = pair.second->get_isa();
+            fma_clients += (isa == "avx2" || isa == "avx512") ? 1 : 0;
+        }
+        if (fma_clients != 0 && fma_clients != clients_.size()) {
+            LOG_WARNING << "Клиенты используют ядра с FMA и без него: результат воспроизводим "
+                        << "только в пределах округления.";
+        }
 
-        // Сбрасываем счетчики результатов
+        // Сбрасываем счетчики результатов и хода запроса
+        const size_t job_id = ++next_job_id_;
         {
             std::lock_guard<std::mutex> results_lock(results_mutex_);
             results_.clear();
             results_received_ = 0;
             expected_results_ = 0;
             final_result_ = 0.0;
+            final_error_ = 0.0;
+            final_sum_ = ExactSum();
             results_ready_ = false;
+            result_times_.clear();
+            pending_tasks_.clear();
+            cancel_requested_ = false;
+            current_job_id_ = job_id;
+            job_started_ = std::chrono::steady_clock::now();
+            task_progress_.clear();
+            task_weights_.clear();
+            reported_stragglers_.clear();
+            failed_tasks_.clear();
+            task_failures_.clear();
         }
 
         // Разделяем задачу на подзадачи
-        std::vector<IntegrationTask> tasks = divide_task(lower_bound, upper_bound, step);
+        std::vector<IntegrationTask> tasks;
+        try {
+            tasks = divide_task(request);
+        } catch (const std::invalid_argument& e) {
+            LOG_WARNING << "Некорректные параметры интегрирования: " << e.what();
+            return empty_result;
+        }
+        if (tasks.empty()) {
+            LOG_WARNING << "Некорректные параметры интегрирования.";
+            return empty_result;
+        }
         {
             std::lock_guard<std::mutex> results_lock(results_mutex_);
             expected_results_ = tasks.size();
@@ -240,53 +680,543 @@ public:
                 [this](const IntegrationResult& result) {
                     handle_result(result);
                 });
+            pair.second->set_failure_callback(
+                [this](size_t task_id, size_t client_id) {
+                    handle_failure(task_id, client_id);
+                });
+            pair.second->set_progress_callback(
+                [this](const std::vector<ProgressReport>& reports) {
+                    handle_progress(reports);
+                });
         }
 
+        // Вес клиента - измеренная производительность; если хотя бы один клиент ее не сообщил,
+        // веса несравнимы, и используется емкость
+        const double total_weight = all_calibrated ? total_throughput : total_capacity;
+        LOG_INFO << "Задачи распределяются по " << (all_calibrated ? "производительности" : "емкости") << " клиентов";
+
         // Распределяем задачи между клиентами
+        std::map<size_t, ClientLoad> loads;
         size_t task_index = 0;
+        double cumulative_weight = 0.0;
         for (const auto& pair : clients_) {
             auto client = pair.second;
             size_t client_cores = client->get_num_cores();
             
-            // Вычисляем количество задач для этого клиента пропорционально его ядрам
-            size_t tasks_for_client = (client_cores * tasks.size() + total_cores_ - 1) / total_cores_;
+            // Вычисляем количество задач для этого клиента пропорционально его весу:
+            // граница - округленная доля накопленного веса, поэтому задачи распределяются все
+            cumulative_weight += all_calibrated ? client->get_throughput() : client->get_capacity();
+            size_t task_end = static_cast<size_t>(std::llround(cumulative_weight * tasks.size() / total_weight));
+            size_t tasks_for_client = std::min(task_end, tasks.size()) - std::min(task_index, task_end);
             
             LOG_INFO << "Клиенту " << client->get_id() << " назначено " << tasks_for_client 
-                     << " задач (ядер: " << client_cores << ")";
+                     << " задач (ядер: " << client_cores << ", емкость: " << client->get_capacity()
+                     << ", вычислений/с: " << client->get_throughput() << ", ядро: " << client->get_isa() << ")";
             
-            // Отправляем задачи клиенту
+            // Отправляем задачи клиенту: пачками по его производительности, все одной записью в сокет
+            ClientLoad& load = loads[client->get_id()];
+            load.started = std::chrono::steady_clock::now();
+            std::vector<IntegrationTask> batch;
             for (size_t i = 0; i < tasks_for_client && task_index < tasks.size(); ++i, ++task_index) {
                 tasks[task_index].task_id = next_task_id_++;
-                client->send_task(tasks[task_index]);
+                tasks[task_index].job_id = job_id;
+                const uint64_t evaluations = kernels::task_evaluations(tasks[task_index]);
+                {
+                    std::lock_guard<std::mutex> results_lock(results_mutex_);
+                    pending_tasks_[tasks[task_index].task_id] = PendingTask{tasks[task_index], client->get_id()};
+                    // Методы без шага не сообщают число вычислений: их подзадачи считаются равными
+                    task_weights_[tasks[task_index].task_id] = std::max<double>(static_cast<double>(evaluations), 1.0);
+                }
+                load.task_ids.push_back(tasks[task_index].task_id);
+                load.evaluations += evaluations;
+                batch.push_back(tasks[task_index]);
+            }
+            if (!batch.empty()) {
+                const double evaluations_per_task = static_cast<double>(load.evaluations) / batch.size();
+                client->send_tasks(batch, client->task_batch_size(evaluations_per_task));
             }
         }
 
-        // Ждем получения всех результатов
+        // Ждем получения всех результатов, отмены или истечения времени запроса;
+        // раз в kWatchdogInterval задачи потерянных клиентов передаются остальным
         std::unique_lock<std::mutex> results_lock(results_mutex_);
-        results_cv_.wait(results_lock, [this] { return results_ready_; });
+        auto finished = [this] { return results_ready_ || cancel_requested_; };
+        const auto deadline = job_timeout_.count() > 0 ? std::chrono::steady_clock::now() + job_timeout_
+                                                       : std::chrono::steady_clock::time_point::max();
+        bool clients_lost = false;
+        bool task_failed = false;
+        while (!finished() && std::chrono::steady_clock::now() < deadline) {
+            results_cv_.wait_until(results_lock, std::min(deadline, std::chrono::steady_clock::now() + kWatchdogInterval),
+                                   [this, &finished] { return finished() || !failed_tasks_.empty(); });
+            if (!finished() && !reassign_failed_tasks(results_lock, loads)) {
+                task_failed = true;
+                break;
+            }
+            if (!finished() && !reassign_lost_tasks(results_lock, loads)) {
+                clients_lost = true;
+                break;
+            }
+        }
+        if (!results_ready_) {
+            // Задачи запроса больше не нужны: клиенты освобождают ядра, опоздавшие результаты отбрасываются
+            LOG_WARNING << "Запрос " << job_id
+                        << (cancel_requested_ ? " отменен"
+                            : clients_lost ? " остался без клиентов на связи"
+                            : task_failed ? ": задачу не смог выполнить ни один клиент" : ": истекло время")
+                        << ", получено " << results_received_ << "/" << expected_results_
+                        << " результатов; задачи отменяются.";
+            pending_tasks_.clear();
+            failed_tasks_.clear();
+            cancel_requested_ = false;
+            results_lock.unlock();
+            CancelRequest cancel;
+            cancel.job_id = job_id;
+            cancel.whole_job = true;
+            for (const auto& pair : clients_) {
+                pair.second->send_cancel(cancel);
+            }
+            return IntegrationResult{std::numeric_limits<double>::quiet_NaN(), 0, 0.0, ExactSum()};
+        }
+        refine_throughputs(loads);
+
+        if (request.principal_value && request.integrand == IntegrandId::InvLog) {
+            // Клиенты интегрировали гладкий остаток, особенность добавляется один раз на весь диапазон
+            double singular = kernels::singular_part(request.lower_bound, request.upper_bound);
+            LOG_INFO << "Интеграл остатка: " << final_result_ << ", сингулярная часть ln|b - 1| - ln|a - 1|: " << singular;
+            final_sum_.add(singular);
+            final_result_ = final_sum_.round();
+        }
+
+        LOG_INFO << "Все результаты получены. Итоговый результат: " << final_result_
+                 << " (оценка погрешности " << final_error_ << ")";
+        return IntegrationResult{final_result_, 0, final_error_, final_sum_};
+    }
+
+    /**
+     * @brief Ограничивает время выполнения запроса.
+     * 
+     * По истечении времени задачи запроса отменяются на клиентах, а
+     * handle_integration_request() возвращает NaN.
+     * 
+     * @param timeout Предельное время (0 - без ограничения).
+     */
+    void set_job_timeout(std::chrono::milliseconds timeout) {
+        job_timeout_ = timeout;
+    }
+
+    /**
+     * @brief Отменяет выполняющийся запрос.
+     * 
+     * Вызывается из другого потока: handle_integration_request() прекращает
+     * ожидание, рассылает клиентам отмену запроса и возвращает NaN.
+     */
+    void cancel_job() {
+        std::lock_guard<std::mutex> lock(results_mutex_);
+        cancel_requested_ = true;
+        results_cv_.notify_all();
+    }
+
+    /**
+     * @brief Возвращает ход выполнения текущего (или последнего) запроса.
+     * 
+     * Может вызываться из любого потока, например монитором.
+     */
+    JobProgress job_progress() {
+        std::lock_guard<std::mutex> lock(results_mutex_);
+        return make_progress();
+    }
 
-        LOG_INFO << "Все результаты получены. Итоговый результат: " << final_result_;
-        return final_result_;
+    /**
+     * @brief Устанавливает наблюдателя за ходом запросов.
+     * 
+     * Наблюдатель вызывается из потоков чтения сессий после каждого отчета
+     * клиента о ходе задач текущего запроса.
+     * 
+     * @param listener Функция, получающая ход выполнения запроса.
+     */
+    void set_progress_listener(std::function<void(const JobProgress&)> listener) {
+        std::lock_guard<std::mutex> lock(results_mutex_);
+        progress_listener_ = listener;
     }
 
 private:
+    /**
+     * @brief Подзадача текущего запроса, результат которой еще не получен.
+     */
+    struct PendingTask {
+        IntegrationTask task; ///< Подзадача (для повторной отправки)
+        size_t client_id;     ///< Клиент, выполняющий подзадачу
+    };
+
+    /**
+     * @brief Задачи, отправленные клиенту в текущем запросе.
+     */
+    struct ClientLoad {
+        std::chrono::steady_clock::time_point started; ///< Время отправки первой задачи
+        std::vector<size_t> task_ids;                  ///< Номера задач клиента
+        uint64_t evaluations = 0;                      ///< Вычислений функции во всех задачах
+    };
+
+    /// Меньшие времена выполнения не уточняют производительность: в них преобладает сеть
+    static constexpr double kMinObservedSeconds = 0.05;
+    /// Период проверки клиентов, выполняющих задачи запроса
+    static constexpr std::chrono::seconds kWatchdogInterval{1};
+    /// Подзадача отстает, если ее ожидаемое время выполнения больше медианного во столько раз
+    static constexpr double kStragglerFactor = 2.0;
+
+    /**
+     * @brief Передает подзадачи потерянных клиентов остальным клиентам.
+     * 
+     * Потерянные клиенты (см. ClientSession::responsive()) отключаются и
+     * удаляются; их подзадачи с теми же номерами поровну отправляются
+     * клиентам на связи. Вызывается под results_mutex_ и clients_mutex_;
+     * на время отправки results_mutex_ освобождается.
+     * 
+     * @param results_lock Захваченный results_mutex_.
+     * @param loads Задачи каждого клиента в текущем запросе.
+     * @return false, если у подзадач потерянных клиентов не осталось исполнителей.
+     */
+    bool reassign_lost_tasks(std::unique_lock<std::mutex>& results_lock, std::map<size_t, ClientLoad>& loads) {
+        const auto now = std::chrono::steady_clock::now();
+        std::vector<std::shared_ptr<ClientSession>> responsive;
+        std::set<size_t> lost;
+        for (const auto& pair : clients_) {
+            if (pair.second->responsive(now)) {
+                responsive.push_back(pair.second);
+            } else {
+                lost.insert(pair.first);
+            }
+        }
+        if (lost.empty()) {
+            return true;
+        }
+
+        std::vector<IntegrationTask> orphaned;
+        for (const auto& pair : pending_tasks_) {
+            if (lost.count(pair.second.client_id) != 0) {
+                orphaned.push_back(pair.second.task);
+            }
+        }
+        for (size_t id : lost) {
+            LOG_WARNING << "Клиент " << id << " не отвечает и отключается";
+            clients_[id]->close();
+            clients_.erase(id);
+            loads.erase(id);
+        }
+        if (orphaned.empty()) {
+            return true;
+        }
+        if (responsive.empty()) {
+            return false;
+        }
+
+        std::vector<std::shared_ptr<ClientSession>> owners;
+        for (size_t i = 0; i < orphaned.size(); ++i) {
+            owners.push_back(responsive[i % responsive.size()]);
+        }
+        send_reassigned(results_lock, loads, orphaned, owners);
+        return true;
+    }
+
+    /**
+     * @brief Передает подзадачи, которые клиенты не смогли выполнить, другим клиентам.
+     * 
+     * Подзадача уходит клиенту на связи, который ее еще не пробовал; клиент,
+     * сообщивший об ошибке, остается в работе. Вызывается под results_mutex_ и
+     * clients_mutex_; на время отправки results_mutex_ освобождается.
+     * 
+     * @param results_lock Захваченный results_mutex_.
+     * @param loads Задачи каждого клиента в текущем запросе.
+     * @return false, если подзадачу не смог выполнить ни один клиент на связи.
+     */
+    bool reassign_failed_tasks(std::unique_lock<std::mutex>& results_lock, std::map<size_t, ClientLoad>& loads) {
+        if (failed_tasks_.empty()) {
+            return true;
+        }
+        const auto now = std::chrono::steady_clock::now();
+        std::vector<IntegrationTask> failed;
+        std::vector<std::shared_ptr<ClientSession>> owners;
+        for (size_t task_id : failed_tasks_) {
+            auto pending = pending_tasks_.find(task_id);
+            if (pending == pending_tasks_.end()) {
+                continue;
+            }
+            const std::set<size_t>& tried = task_failures_[task_id];
+            auto assigned = [&loads](size_t client_id) {
+                auto load = loads.find(client_id);
+                return load == loads.end() ? size_t(0) : load->second.task_ids.size();
+            };
+            std::shared_ptr<ClientSession> owner;
+            for (const auto& pair : clients_) {
+                // Из еще не пробовавших выбирается клиент с наименьшим числом задач запроса
+                if (tried.count(pair.first) == 0 && pair.second->responsive(now) &&
+                    (!owner || assigned(pair.first) < assigned(owner->get_id()))) {
+                    owner = pair.second;
+                }
+            }
+            if (!owner) {
+                failed_tasks_.clear();
+                return false;
+            }
+            failed.push_back(pending->second.task);
+            owners.push_back(owner);
+        }
+        failed_tasks_.clear();
+        send_reassigned(results_lock, loads, failed, owners);
+        return true;
+    }
+
+    /**
+     * @brief Отправляет подзадачи новым исполнителям (tasks[i] - клиенту owners[i]).
+     * 
+     * Вызывается под results_mutex_, который освобождается на время отправки.
+     */
+    void send_reassigned(std::unique_lock<std::mutex>& results_lock, std::map<size_t, ClientLoad>& loads,
+                         const std::vector<IntegrationTask>& tasks,
+                         const std::vector<std::shared_ptr<ClientSession>>& owners) {
+        for (size_t i = 0; i < tasks.size(); ++i) {
+            pending_tasks_[tasks[i].task_id].client_id = owners[i]->get_id();
+            task_progress_.erase(tasks[i].task_id);
+            reported_stragglers_.erase(tasks[i].task_id);
+        }
+        results_lock.unlock();
+        for (size_t i = 0; i < tasks.size(); ++i) {
+            LOG_WARNING << "Задача " << tasks[i].task_id << " передана клиенту " << owners[i]->get_id();
+            ClientLoad& load = loads[owners[i]->get_id()];
+            load.task_ids.push_back(tasks[i].task_id);
+            load.evaluations += kernels::task_evaluations(tasks[i]);
+            try {
+                owners[i]->send_task(tasks[i]);
+            } catch (const std::exception&) {
+                // Клиент будет признан потерянным на следующей проверке
+                owners[i]->close();
+            }
+        }
+        results_lock.lock();
+    }
+
+    /**
+     * @brief Запоминает подзадачу, которую клиент не смог выполнить.
+     * 
+     * Сообщения о задачах, уже переданных другому клиенту или завершенных,
+     * не учитываются. Передачу выполняет ожидающий запрос поток
+     * (reassign_failed_tasks()), владеющий clients_mutex_.
+     * 
+     * @param task_id Подзадача.
+     * @param client_id Клиент, сообщивший об ошибке.
+     */
+    void handle_failure(size_t task_id, size_t client_id) {
+        std::lock_guard<std::mutex> lock(results_mutex_);
+        auto pending = pending_tasks_.find(task_id);
+        if (pending == pending_tasks_.end() || pending->second.client_id != client_id) {
+            return;
+        }
+        task_failures_[task_id].insert(client_id);
+        failed_tasks_.push_back(task_id);
+        results_cv_.notify_all();
+    }
+
+    /**
+     * @brief Обрабатывает отчеты клиента о ходе подзадач.
+     * 
+     * Сохраняет отчеты по подзадачам текущего запроса, сообщает о новых
+     * отстающих подзадачах и передает ход запроса наблюдателю.
+     * 
+     * @param reports Отчеты клиента.
+     */
+    void handle_progress(const std::vector<ProgressReport>& reports) {
+        JobProgress progress;
+        std::function<void(const JobProgress&)> listener;
+        {
+            std::lock_guard<std::mutex> lock(results_mutex_);
+            bool updated = false;
+            for (const ProgressReport& report : reports) {
+                if (report.job_id == current_job_id_ && pending_tasks_.count(report.task_id) != 0) {
+                    task_progress_[report.task_id] = report;
+                    updated = true;
+                }
+            }
+            if (!updated) {
+                return;
+            }
+            progress = make_progress();
+            for (size_t task_id : progress.stragglers) {
+                if (reported_stragglers_.insert(task_id).second) {
+                    const ProgressReport& report = task_progress_[task_id];
+                    LOG_WARNING << "Задача " << task_id << " клиента " << pending_tasks_[task_id].client_id
+                                << " отстает: выполнено " << report.fraction * 100.0 << "% за "
+                                << report.elapsed_seconds << " с (" << report.evals_per_sec << " вычислений/с)";
+                }
+            }
+            listener = progress_listener_;
+        }
+        if (listener) {
+            listener(progress);
+        }
+    }
+
+    /**
+     * @brief Оценивает ход текущего запроса по результатам и отчетам клиентов.
+     * 
+     * Доля работы взвешена числом вычислений функции в подзадачах. Оставшееся
+     * время экстраполируется по прошедшему. Ожидаемое время подзадачи -
+     * время ее выполнения на клиенте, деленное на выполненную долю; подзадача
+     * отстает, если оно больше медианного в kStragglerFactor раз. Вызывается
+     * под results_mutex_.
+     */
+    JobProgress make_progress() const {
+        JobProgress progress;
+        progress.job_id = current_job_id_;
+        progress.tasks = expected_results_;
+        progress.completed = results_received_;
+        progress.elapsed_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - job_started_).count();
+
+        double total_weight = 0.0;
+        double done_weight = 0.0;
+        for (const auto& pair : task_weights_) {
+            total_weight += pair.second;
+            auto result = results_.find(pair.first);
+            auto report = task_progress_.find(pair.first);
+            if (result != results_.end()) {
+                done_weight += pair.second;
+                progress.partial_sum += result->second.result;
+            } else if (report != task_progress_.end()) {
+                done_weight += pair.second * report->second.fraction;
+                progress.partial_sum += report->second.partial_sum;
+            }
+        }
+        progress.fraction = total_weight > 0.0 ? done_weight / total_weight : 0.0;
+        if (progress.fraction > 0.0) {
+            progress.eta_seconds = progress.elapsed_seconds * (1.0 - progress.fraction) / progress.fraction;
+        }
+
+        std::vector<double> projected;
+        for (const auto& pair : task_progress_) {
+            if (pair.second.fraction > 0.0) {
+                projected.push_back(pair.second.elapsed_seconds / pair.second.fraction);
+            }
+        }
+        if (projected.size() < 2) {
+            return progress;
+        }
+        std::vector<double> sorted = projected;
+        std::nth_element(sorted.begin(), sorted.begin() + sorted.size() / 2, sorted.end());
+        const double median = sorted[sorted.size() / 2];
+        for (const auto& pair : task_progress_) {
+            if (pair.second.fraction > 0.0 && pending_tasks_.count(pair.first) != 0 &&
+                pair.second.elapsed_seconds / pair.second.fraction > kStragglerFactor * median) {
+                progress.stragglers.push_back(pair.first);
+            }
+        }
+        return progress;
+    }
+
+    /**
+     * @brief Уточняет производительность клиентов по времени выполнения их задач.
+     * 
+     * Время клиента - от отправки его первой задачи до получения последнего
+     * результата. Вызывается под results_mutex_ и clients_mutex_.
+     * 
+     * @param loads Задачи каждого клиента в завершенном запросе.
+     */
+    void refine_throughputs(const std::map<size_t, ClientLoad>& loads) {
+        for (const auto& pair : loads) {
+            const ClientLoad& load = pair.second;
+            auto client = clients_.find(pair.first);
+            if (load.evaluations == 0 || load.task_ids.empty() || client == clients_.end()) {
+                continue;
+            }
+            std::chrono::steady_clock::time_point finished = load.started;
+            for (size_t task_id : load.task_ids) {
+                auto time = result_times_.find(task_id);
+                if (time != result_times_.end() && time->second > finished) {
+                    finished = time->second;
+                }
+            }
+            const double seconds = std::chrono::duration<double>(finished - load.started).count();
+            if (seconds >= kMinObservedSeconds) {
+                client->second->refine_throughput(static_cast<double>(load.evaluations) / seconds);
+            }
+        }
+    }
+
+    /**
+     * @brief Вычисляет интеграл по точной формуле без обращения к клиентам.
+     * 
+     * Для 1/ln(x) оценка погрешности учитывает сокращение при вычитании значений li,
+     * для остальных функций - 8 ulp результата.
+     * 
+     * @param request Описание задачи.
+     * @param result Результат интегрирования.
+     * @return false, если точной формулы для функции задачи нет.
+     */
+    bool integrate_closed_form(const IntegrationTask& request, IntegrationResult& result) {
+        const IntegrandParams params = kernels::resolve_params(request.integrand, request.params);
+        const bool log_integral = request.integrand == IntegrandId::InvLog;
+        if (log_integral && (!(request.lower_bound > 0.0) || !(request.upper_bound > request.lower_bound))) {
+            LOG_WARNING << "Точная формула требует 0 < нижний предел < верхний предел.";
+            return true;
+        }
+        if (log_integral && request.lower_bound <= 1.0) {
+            LOG_WARNING << "Интервал содержит x = 1: результат - интеграл в смысле главного значения.";
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        if (!kernels::integrate_closed_form(request.integrand, params, request.lower_bound, request.upper_bound,
+                                            result.result)) {
+            LOG_WARNING << "Для функции " << kernels::integrand_info(request.integrand).name
+                        << " нет точной формулы, используем адаптивный метод.";
+            return false;
+        }
+        const double epsilon = std::numeric_limits<double>::epsilon();
+        if (log_integral) {
+            result.error_estimate = 8.0 * epsilon * (std::abs(special::log_integral(request.lower_bound)) +
+                                                     std::abs(special::log_integral(request.upper_bound)));
+        } else {
+            result.error_estimate = 8.0 * epsilon * std::abs(result.result);
+        }
+        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+
+        LOG_INFO << "Интеграл вычислен по точной формуле за " << elapsed.count() << " мкс: "
+                 << result.result << " (оценка погрешности " << result.error_estimate << ")";
+        return true;
+    }
+
     /**
      * @brief Разделяет задачу интегрирования на подзадачи.
      * 
-     * @param lower_bound Нижний предел интегрирования.
-     * @param upper_bound Верхний предел интегрирования.
-     * @param step Шаг интегрирования.
+     * Для методов с шагом подзадачи - части сетки всего задания, заданные
+     * номерами панелей с границами, кратными kernels::kReductionBlock: каждый
+     * узел вычисляется одинаково при любом числе клиентов и ядер.
+     * 
+     * @param request Описание задачи на всем диапазоне.
      * @return Вектор подзадач.
      */
-    std::vector<IntegrationTask> divide_task(double lower_bound, double upper_bound, double step) {
+    std::vector<IntegrationTask> divide_task(const IntegrationTask& request) {
         std::vector<IntegrationTask> tasks;
+        const double lower_bound = request.lower_bound;
+        const double upper_bound = request.upper_bound;
         
         // Вычисляем количество интервалов
         double range = upper_bound - lower_bound;
-        if (range <= 0 || step <= 0 || total_cores_ == 0) {
+        if (range <= 0 || (method_uses_step(request.method) && request.step <= 0) || total_cores_ == 0) {
             return tasks;
         }
         
+        if (method_uses_step(request.method)) {
+            // Одна часть сетки на каждое ядро CPU; границы и узлы задаются целыми номерами панелей
+            uint64_t panels = kernels::grid_panels(lower_bound, upper_bound, request.step);
+            std::vector<uint64_t> bounds = kernels::split_panels(0, panels, total_cores_);
+            for (size_t i = 0; i + 1 < bounds.size(); ++i) {
+                IntegrationTask task = request;
+                task.first_panel = bounds[i];
+                task.last_panel = bounds[i + 1];
+                task.task_id = i;
+                tasks.push_back(task);
+            }
+            return tasks;
+        }
+
         // Разделяем на подзадачи пропорционально общему количеству ядер
         // Создаем одну задачу на каждое ядро CPU для равномерного распределения нагрузки
         double task_range = range / total_cores_;
@@ -296,10 +1226,10 @@ private:
         for (size_t i = 0; i < total_cores_ && current_lower < upper_bound; ++i) {
             double current_upper = (i == total_cores_ - 1) ? upper_bound : current_lower + task_range;
             
-            IntegrationTask task;
+            IntegrationTask task = request;
             task.lower_bound = current_lower;
             task.upper_bound = current_upper;
-            task.step = step;
+            task.abs_tol = request.abs_tol * (current_upper - current_lower) / range;
             task.task_id = task_counter++;
             
             tasks.push_back(task);
@@ -317,18 +1247,28 @@ private:
     void handle_result(const IntegrationResult& result) {
         std::lock_guard<std::mutex> lock(results_mutex_);
         
-        results_[result.task_id] = result.result;
+        // Результаты отмененных, прошлых и переданных другому клиенту задач не учитываются
+        if (pending_tasks_.erase(result.task_id) == 0) {
+            LOG_INFO << "Результат задачи " << result.task_id << " отброшен: задача не ожидается";
+            return;
+        }
+        results_[result.task_id] = result;
+        result_times_[result.task_id] = std::chrono::steady_clock::now();
         results_received_++;
         
         LOG_INFO << "Получен результат для задачи " << result.task_id 
                  << " (получено: " << results_received_ << "/" << expected_results_ << ")";
         
-        // Если получены все результаты, суммируем их
+        // Если получены все результаты, суммируем их без округления: итог не зависит
+        // ни от порядка прихода результатов, ни от разбиения задачи
         if (results_received_ >= expected_results_) {
-            final_result_ = 0.0;
+            final_sum_ = ExactSum();
+            final_error_ = 0.0;
             for (const auto& pair : results_) {
-                final_result_ += pair.second;
+                final_sum_.add(pair.second.sum);
+                final_error_ += pair.second.error_estimate;
             }
+            final_result_ = final_sum_.round();
             results_ready_ = true;
             results_cv_.notify_one();
         }
@@ -336,14 +1276,21 @@ private:
 
     /**
      * @brief Принимает новые подключения клиентов.
+     * 
+     * @tparam Acceptor Акцептор TCP или AF_UNIX.
+     * @param acceptor Акцептор; должен пережить ожидание подключения.
      */
-    void do_accept() {
-        acceptor_.async_accept(
-            [this](boost::system::error_code ec, boost::asio::ip::tcp::socket socket) {
+    template<typename Acceptor>
+    void do_accept(Acceptor& acceptor) {
+        acceptor.async_accept(
+            [this, &acceptor](boost::system::error_code ec, typename Acceptor::protocol_type::socket socket) {
                 if (!ec) {
+                    const std::string peer = describe_peer(socket);
+                    MessageSocket message_socket(std::move(socket));
+                    configure_socket(message_socket);
                     next_client_id_++;
                     std::shared_ptr<ClientSession> new_session = 
-                        std::make_shared<ClientSession>(std::move(socket), next_client_id_);
+                        std::make_shared<ClientSession>(std::move(message_socket), next_client_id_);
                     
                     {
                         std::lock_guard<std::mutex> lock(clients_mutex_);
@@ -351,16 +1298,74 @@ private:
                     }
                     
                     new_session->start();
-                    LOG_INFO << "Новое соединение от " << new_session->get_socket().remote_endpoint() 
-                             << ", ID клиента: " << next_client_id_;
+                    LOG_INFO << "Новое соединение от " << peer << ", ID клиента: " << next_client_id_;
+                } else if (ec == boost::asio::error::operation_aborted) {
+                    // Акцептор закрыт при остановке сервера
+                    return;
                 } else {
                     LOG_ERROR << "Ошибка при установке соединения: " << ec.message();
                 }
-                do_accept();
+                do_accept(acceptor);
             });
     }
 
-    boost::asio::ip::tcp::acceptor acceptor_;
+    /**
+     * @brief Описывает клиента TCP для журнала: адрес и порт.
+     */
+    static std::string describe_peer(const boost::asio::ip::tcp::socket& socket) {
+        boost::system::error_code ignored;
+        std::ostringstream peer;
+        peer << socket.remote_endpoint(ignored);
+        return peer.str();
+    }
+
+#if defined(BOOST_ASIO_HAS_LOCAL_SOCKETS)
+    /**
+     * @brief Удаляет файл сокета AF_UNIX, оставшийся от завершившегося сервера.
+     *
+     * Файл удаляется, только если это сокет (ссылки не разыменовываются) и
+     * подключиться к нему нельзя. Иной файл по этому пути или сокет, который
+     * принимает подключения, не трогаются.
+     *
+     * @param io_context Контекст ввода-вывода для пробного подключения.
+     * @param path Путь сокета.
+     * @throws std::runtime_error Путь занят не сокетом или другим сервером.
+     */
+    static void remove_stale_socket(boost::asio::io_context& io_context, const std::string& path) {
+        std::error_code status_error;
+        const std::filesystem::file_status status = std::filesystem::symlink_status(path, status_error);
+        if (status.type() == std::filesystem::file_type::not_found) {
+            return;
+        }
+        if (status_error || status.type() != std::filesystem::file_type::socket) {
+            throw std::runtime_error("путь " + path + " занят и не является сокетом");
+        }
+        boost::asio::local::stream_protocol::socket probe(io_context);
+        boost::system::error_code connect_error;
+        probe.connect(boost::asio::local::stream_protocol::endpoint(path), connect_error);
+        if (!connect_error) {
+            throw std::runtime_error("сокет " + path + " уже принимает подключения другого сервера");
+        }
+        if (connect_error != boost::asio::error::connection_refused) {
+            throw std::runtime_error("не удалось проверить сокет " + path + ": " + connect_error.message());
+        }
+        LOG_INFO << "Удаляется сокет " << path << ", оставшийся от прошлого запуска";
+        std::filesystem::remove(path);
+    }
+
+    /**
+     * @brief Описывает клиента AF_UNIX для журнала: у его конца сокета обычно нет имени.
+     */
+    std::string describe_peer(const boost::asio::local::stream_protocol::socket&) const {
+        return kUnixAddressPrefix + unix_path_;
+    }
+#endif
+
+    std::string unix_path_; ///< Путь сокета AF_UNIX (пусто - не слушает)
+    std::unique_ptr<boost::asio::ip::tcp::acceptor> acceptor_;
+#if defined(BOOST_ASIO_HAS_LOCAL_SOCKETS)
+    std::unique_ptr<boost::asio::local::stream_protocol::acceptor> local_acceptor_;
+#endif
     std::map<size_t, std::shared_ptr<ClientSession>> clients_;
     std::mutex clients_mutex_;
     size_t next_client_id_;
@@ -368,22 +1373,90 @@ private:
     size_t total_cores_;
 
     // Синхронизация результатов
-    std::map<size_t, double> results_;
+    std::map<size_t, IntegrationResult> results_;
     std::mutex results_mutex_;
     std::condition_variable results_cv_;
     std::atomic<size_t> results_received_;
     size_t expected_results_;
     double final_result_;
+    double final_error_;
+    ExactSum final_sum_; ///< Точная сумма результатов подзадач
     bool results_ready_;
+    /// Время получения результата каждой задачи текущего запроса
+    std::map<size_t, std::chrono::steady_clock::time_point> result_times_;
+    std::map<size_t, PendingTask> pending_tasks_; ///< Задачи текущего запроса без результата
+    size_t next_job_id_ = 0;
+    size_t current_job_id_ = 0;
+    std::chrono::steady_clock::time_point job_started_;
+    std::map<size_t, ProgressReport> task_progress_; ///< Последний отчет по каждой задаче запроса
+    std::map<size_t, double> task_weights_;          ///< Вычислений функции в каждой задаче запроса
+    std::set<size_t> reported_stragglers_;           ///< Отстающие задачи, о которых уже сообщено
+    std::vector<size_t> failed_tasks_;               ///< Задачи, ждущие передачи после ошибки клиента
+    std::map<size_t, std::set<size_t>> task_failures_; ///< Клиенты, не сумевшие выполнить задачу
+    std::function<void(const JobProgress&)> progress_listener_;
+    bool cancel_requested_ = false;
+    std::chrono::milliseconds job_timeout_{0};
 };
 
-int main() {
+int main(int argc, char* argv[]) {
     init_logging();
     LOG_INFO << "Приложение сервера запущено.";
 
+    // Параметры запуска: --timeout=<секунд> - предельное время запроса, --port=<порт> - порт для клиентов
+    // (0 - только сокет AF_UNIX), --unix=<путь> - сокет AF_UNIX для клиентов на этом узле
+    std::chrono::milliseconds job_timeout{0};
+    unsigned short port = 12345;
+    std::string unix_path;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const std::string timeout_prefix = "--timeout=";
+        const std::string port_prefix = "--port=";
+        const std::string unix_prefix = "--unix=";
+        if (arg.compare(0, unix_prefix.size(), unix_prefix) == 0 && arg.size() > unix_prefix.size()) {
+            unix_path = arg.substr(unix_prefix.size());
+            continue;
+        }
+        if (arg.compare(0, port_prefix.size(), port_prefix) == 0) {
+            try {
+                const int value = std::stoi(arg.substr(port_prefix.size()));
+                if (value >= 0 && value <= 65535) {
+                    port = static_cast<unsigned short>(value);
+                    continue;
+                }
+            } catch (const std::exception&) {
+            }
+        }
+        if (arg.compare(0, timeout_prefix.size(), timeout_prefix) == 0) {
+            try {
+                const double seconds = std::stod(arg.substr(timeout_prefix.size()));
+                if (seconds > 0.0) {
+                    job_timeout = std::chrono::milliseconds(static_cast<long long>(seconds * 1000.0));
+                    continue;
+                }
+            } catch (const std::exception&) {
+            }
+        }
+        LOG_WARNING << "Неизвестный параметр запуска: " << arg
+                    << " (допустимо --timeout=<секунд> > 0, --port=<0..65535>, --unix=<путь>)";
+    }
+    if (port == 0 && unix_path.empty()) {
+        LOG_WARNING << "Не задан ни порт, ни сокет AF_UNIX: используем порт 12345";
+        port = 12345;
+    }
+
     try {
         boost::asio::io_context io_context;
-        Server server(io_context, 12345);
+        Server server(io_context, port, unix_path);
+        server.set_job_timeout(job_timeout);
+        server.set_progress_listener([](const JobProgress& progress) {
+            std::ostringstream line;
+            line << "Выполнено " << std::llround(progress.fraction * 100.0) << "% (" << progress.completed << "/"
+                 << progress.tasks << " подзадач)";
+            if (progress.eta_seconds >= 0.0) {
+                line << ", осталось около " << progress.eta_seconds << " с";
+            }
+            std::cout << line.str() << std::endl;
+        });
 
         // Запускаем io_context в отдельном потоке
         std::thread io_thread([&io_context]() {
@@ -396,16 +1469,77 @@ int main() {
         std::cin.ignore();
 
         // Пример: запрашиваем у пользователя параметры интегрирования
-        double lower_bound, upper_bound, step;
+        IntegrationTask request;
+        request.task_id = 0;
+        request.step = 0.0;
+
+        unsigned integrand = 0;
+        std::cout << "Выберите функцию (0 - 1/ln(x), 2 - exp(-x)/x, 3 - x^(p-1)/ln(x), 4 - exp(-p x^2)): ";
+        std::cin >> integrand;
+        if (integrand >= kIntegrandCount || integrand == static_cast<unsigned>(IntegrandId::InvLogRemainder)) {
+            std::cout << "Неизвестная функция, используем 1/ln(x)" << std::endl;
+            integrand = 0;
+        }
+        request.integrand = static_cast<IntegrandId>(integrand);
+        const kernels::IntegrandInfo& info = kernels::integrand_info(request.integrand);
+        for (unsigned i = 0; i < info.param_count; ++i) {
+            double param = 0.0;
+            std::cout << "Введите параметр " << i + 1 << " функции " << info.name << ": ";
+            std::cin >> param;
+            request.params.push_back(param);
+        }
+
         std::cout << "Введите нижний предел интегрирования: ";
-        std::cin >> lower_bound;
+        std::cin >> request.lower_bound;
         std::cout << "Введите верхний предел интегрирования: ";
-        std::cin >> upper_bound;
-        std::cout << "Введите шаг интегрирования: ";
-        std::cin >> step;
+        std::cin >> request.upper_bound;
+
+        unsigned method = 0;
+        std::cout << "Выберите метод (0 - прямоугольники, 1 - Симпсон, 2 - Гаусс-Лежандр, 3 - tanh-sinh, "
+                     "4 - адаптивный Гаусс-Кронрод, 5 - точная формула li(b) - li(a), "
+                     "6 - аппроксимация Чебышёва): ";
+        std::cin >> method;
+        if (method > static_cast<unsigned>(IntegrationMethod::Chebyshev)) {
+            std::cout << "Неизвестный метод, используем метод прямоугольников" << std::endl;
+            method = 0;
+        }
+        request.method = static_cast<IntegrationMethod>(method);
+
+        if (request.method == IntegrationMethod::AdaptiveGaussKronrod) {
+            // Шаг не нужен: разбиение выбирается по допускам
+            std::cout << "Введите допустимую абсолютную погрешность: ";
+            std::cin >> request.abs_tol;
+            std::cout << "Введите допустимую относительную погрешность: ";
+            std::cin >> request.rel_tol;
+            std::cout << "Введите число узлов Кронрода (15 или 21): ";
+            std::cin >> request.order;
+        } else if (request.method == IntegrationMethod::Chebyshev) {
+            std::cout << "Введите допуск хвоста ряда Чебышёва (0 - по умолчанию): ";
+            std::cin >> request.rel_tol;
+        } else if (request.method != IntegrationMethod::ClosedForm) {
+            std::cout << "Введите шаг интегрирования: ";
+            std::cin >> request.step;
+            if (request.method == IntegrationMethod::GaussLegendre) {
+                std::cout << "Введите число узлов Гаусса-Лежандра (2..16): ";
+                std::cin >> request.order;
+            } else if (request.method == IntegrationMethod::TanhSinh) {
+                std::cout << "Введите уровень tanh-sinh (1..6): ";
+                std::cin >> request.order;
+            }
+        }
 
-        double result = server.handle_integration_request(lower_bound, upper_bound, step);
-        std::cout << "Результат интегрирования: " << result << std::endl;
+        if (request.method != IntegrationMethod::ClosedForm && request.integrand == IntegrandId::InvLog) {
+            int principal_value = 0;
+            std::cout << "Вычитать особенность в x = 1 (главное значение через x = 1)? (0 - нет, 1 - да): ";
+            std::cin >> principal_value;
+            request.principal_value = principal_value != 0;
+        }
+
+        IntegrationResult result = server.handle_integration_request(request);
+        std::cout << "Результат интегрирования: " << result.result << std::endl;
+        if (result.error_estimate > 0.0) {
+            std::cout << "Оценка погрешности: " << result.error_estimate << std::endl;
+        }
 
         // Даем время для завершения операций
         std::this_thread::sleep_for(std::chrono::seconds(2));
@@ -1,25 +1,63 @@
 #include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
 #include <cmath>
+#include <cstring>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <utility>
 #include <vector>
 #include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <limits>
 
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "../common/ChebyshevSurrogate.h"
+#include "../common/CpuTopology.h"
 #include "../common/DataStructures.h"
+#include "../common/FairShareScheduler.h"
+#include "../common/IntegrationKernels.h"
+#include "../common/LogIntegral.h"
+#include "../common/QuadratureRules.h"
+#include "../common/ResultCache.h"
+#include "../common/SharedMemoryTransport.h"
+#include "../common/SimdMath.h"
+#include "../common/ThreadPool.h"
+#include "../common/Utils.h"
+#include "../common/WireFormat.h"
 
-/**
- * @brief Вычисляет значение функции 1/ln(x) для интегрирования.
- * 
- * @param x Точка, в которой вычисляется функция.
- * @return Значение функции или 0.0 для особых случаев.
- */
-double integrate_function(double x) {
-    if (x <= 1.0 || std::abs(std::log(x)) < 1e-10) {
-        return 0.0; 
+/// Число выделений памяти оператором new с запуска тестов
+static std::atomic<size_t> g_allocations{0};
+
+// Замены глобальных operator new/delete не встраиваются: иначе GCC принимает
+// пару new/free в месте вызова за несогласованную
+__attribute__((noinline)) void* operator new(std::size_t size) {
+    ++g_allocations;
+    if (void* memory = std::malloc(size == 0 ? 1 : size)) {
+        return memory;
     }
-    return 1.0 / std::log(x);
+    throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+__attribute__((noinline)) void operator delete(void* memory, std::size_t) noexcept {
+    std::free(memory);
 }
 
 /**
- * @brief Вычисляет интеграл функции методом прямоугольников.
+ * @brief Вычисляет интеграл функции методом прямоугольников (скалярный эталон для ядер).
  * 
  * @param lower_bound Нижний предел интегрирования.
  * @param upper_bound Верхний предел интегрирования.
@@ -33,13 +71,20 @@ double compute_integral(double lower_bound, double upper_bound, double step) {
     while (x < upper_bound) {
         double next_x = std::min(x + step, upper_bound);
         double mid_x = (x + next_x) / 2.0;
-        result += integrate_function(mid_x) * (next_x - x);
+        result += kernels::integrate_function(mid_x) * (next_x - x);
         x = next_x;
     }
     
     return result;
 }
 
+/**
+ * @brief Эталонное значение интеграла 1/ln(x) на [a, b] через интегральный логарифм.
+ */
+double reference_integral(double a, double b) {
+    return special::log_integral(b) - special::log_integral(a);
+}
+
 /**
  * @brief Тесты для функции интегрирования.
  */
@@ -52,6 +97,22 @@ protected:
     void TearDown() override {
         // Очистка после каждого теста
     }
+
+    /**
+     * @brief Создает пару соединенных TCP-сокетов на loopback с настройками configure_socket().
+     *
+     * @param io_context Контекст ввода-вывода сокетов.
+     * @return Отправляющий (подключившийся) и принимающий (принятый) сокеты.
+     */
+    static std::pair<MessageSocket, MessageSocket> connect_loopback(boost::asio::io_context& io_context) {
+        boost::asio::ip::tcp::acceptor acceptor(io_context, {boost::asio::ip::address_v4::loopback(), 0});
+        boost::asio::ip::tcp::socket tcp_sender(io_context);
+        tcp_sender.connect(acceptor.local_endpoint());
+        std::pair<MessageSocket, MessageSocket> sockets(std::move(tcp_sender), acceptor.accept());
+        configure_socket(sockets.first);
+        configure_socket(sockets.second);
+        return sockets;
+    }
 };
 
 /**
@@ -60,7 +121,7 @@ protected:
 TEST_F(IntegrationTest, FunctionValueNormalPoint) {
     double x = 2.0;
     double expected = 1.0 / std::log(2.0);
-    double actual = integrate_function(x);
+    double actual = kernels::integrate_function(x);
     
     EXPECT_NEAR(expected, actual, 1e-10);
 }
@@ -70,7 +131,7 @@ TEST_F(IntegrationTest, FunctionValueNormalPoint) {
  */
 TEST_F(IntegrationTest, FunctionValueSpecialPoint) {
     double x = 1.0;
-    double actual = integrate_function(x);
+    double actual = kernels::integrate_function(x);
     
     EXPECT_EQ(0.0, actual);
 }
@@ -80,7 +141,7 @@ TEST_F(IntegrationTest, FunctionValueSpecialPoint) {
  */
 TEST_F(IntegrationTest, FunctionValueNearOne) {
     double x = 1.0001;
-    double actual = integrate_function(x);
+    double actual = kernels::integrate_function(x);
     
     // Функция должна быть определена и положительна для x > 1
     EXPECT_GT(actual, 0.0);
@@ -99,8 +160,8 @@ TEST_F(IntegrationTest, SmallIntervalIntegration) {
     // Результат должен быть положительным для интервала [2, 3]
     EXPECT_GT(result, 0.0);
     
-    // Проверяем, что результат разумный (интеграл 1/ln(x) на [2,3] примерно 1.82)
-    EXPECT_NEAR(result, 1.82, 0.1);
+    // Проверяем, что результат разумный (интеграл 1/ln(x) на [2,3] = li(3) - li(2) примерно 1.1184)
+    EXPECT_NEAR(result, reference_integral(2.0, 3.0), 0.1);
 }
 
 /**
@@ -165,6 +226,1324 @@ TEST_F(IntegrationTest, BoundaryCases) {
     EXPECT_GE(result2, 0.0);
 }
 
+/**
+ * @brief Тест точности векторного логарифма.
+ */
+TEST_F(IntegrationTest, VectorLogAccuracy) {
+    for (double x = 1.0 + 1e-9; x < 1e12; x *= 1.37) {
+        double expected = std::log(x);
+        double actual = simd::log<simd::Scalar>(x);
+        EXPECT_NEAR(expected, actual, 4e-16 * std::max(1.0, std::abs(expected))) << "x = " << x;
+    }
+}
+
+/**
+ * @brief Тест совпадения векторного ядра со скалярным методом прямоугольников.
+ */
+TEST_F(IntegrationTest, MidpointKernelMatchesScalar) {
+    const double cases[][3] = {
+        {2.0, 3.0, 0.001},
+        {2.0, 10.0, 0.0007},
+        {1.5, 1.5013, 0.0001},
+        {100.0, 1000.0, 0.37},
+    };
+    for (const auto& c : cases) {
+        double expected = compute_integral(c[0], c[1], c[2]);
+        double actual = kernels::integrate_midpoint(c[0], c[1], c[2]);
+        EXPECT_NEAR(expected, actual, 1e-9 * std::abs(expected)) << "[" << c[0] << ", " << c[1] << "]";
+    }
+}
+
+/**
+ * @brief Тест ядра на интервале, захватывающем особую точку x = 1.
+ */
+TEST_F(IntegrationTest, MidpointKernelSkipsSingularPrefix) {
+    double expected = compute_integral(0.5, 3.0, 0.001);
+    double actual = kernels::integrate_midpoint(0.5, 3.0, 0.001);
+    EXPECT_NEAR(expected, actual, 1e-9 * std::abs(expected));
+    EXPECT_EQ(0.0, kernels::integrate_midpoint(0.5, 1.0, 0.001));
+}
+
+/**
+ * @brief Тест совпадения всех вариантов ядра, поддерживаемых процессором.
+ */
+TEST_F(IntegrationTest, KernelVariantsAgree) {
+    const IsaLevel initial = kernels::active_isa();
+    const IsaLevel levels[] = {IsaLevel::Scalar, IsaLevel::Sse2, IsaLevel::Avx2, IsaLevel::Avx512};
+    double expected = compute_integral(2.0, 50.0, 0.0003);
+
+    EXPECT_GE(static_cast<int>(best_isa_level(detect_cpu_features())), static_cast<int>(initial));
+    for (IsaLevel level : levels) {
+        if (!kernels::select_isa(level)) {
+            continue;
+        }
+        EXPECT_EQ(level, kernels::active_isa());
+        double actual = kernels::integrate_midpoint(2.0, 50.0, 0.0003);
+        EXPECT_NEAR(expected, actual, 1e-9 * std::abs(expected)) << kernels::kernel_isa_name();
+    }
+    EXPECT_TRUE(kernels::select_isa(initial));
+}
+
+/// Интеграл 1/ln(x) на [2, 10]: li(10) - li(2).
+const double kIntegral2To10 = reference_integral(2.0, 10.0);
+
+/**
+ * @brief Тест узлов и весов формулы Гаусса-Лежандра, построенных при компиляции.
+ */
+TEST_F(IntegrationTest, GaussLegendreRuleConstruction) {
+    constexpr auto rule2 = quadrature::kGaussLegendre<2>;
+    static_assert(rule2.offsets[0] < rule2.offsets[1], "nodes must be ordered");
+    EXPECT_NEAR(rule2.offsets[0], 0.5 - 0.5 / std::sqrt(3.0), 1e-15);
+    EXPECT_NEAR(rule2.weights[0], 0.5, 1e-15);
+
+    // Формула с N узлами точна для многочленов степени 2N - 1
+    const auto& rule = quadrature::kGaussLegendre<16>;
+    for (int degree = 0; degree < 32; ++degree) {
+        double sum = 0.0;
+        for (std::size_t k = 0; k < rule.offsets.size(); ++k) {
+            sum += rule.weights[k] * std::pow(rule.offsets[k], degree);
+        }
+        EXPECT_NEAR(sum, 1.0 / (degree + 1), 1e-14) << "degree " << degree;
+    }
+}
+
+/**
+ * @brief Тест точности методов высокого порядка.
+ */
+TEST_F(IntegrationTest, HigherOrderMethodsAccuracy) {
+    EXPECT_NEAR(kIntegral2To10, kernels::integrate_range(IntegrationMethod::Simpson, 0, 2.0, 10.0, 0.01), 1e-9);
+    EXPECT_NEAR(kIntegral2To10, kernels::integrate_range(IntegrationMethod::GaussLegendre, 8, 2.0, 10.0, 0.5), 1e-12);
+    EXPECT_NEAR(kIntegral2To10, kernels::integrate_range(IntegrationMethod::GaussLegendre, 16, 2.0, 10.0, 2.0), 1e-12);
+    EXPECT_NEAR(kIntegral2To10, kernels::integrate_range(IntegrationMethod::TanhSinh, 4, 2.0, 10.0, 1.0), 1e-12);
+
+    // Неполная последняя панель
+    EXPECT_NEAR(kIntegral2To10, kernels::integrate_range(IntegrationMethod::GaussLegendre, 10, 2.0, 10.0, 0.3), 1e-12);
+    EXPECT_NEAR(kIntegral2To10, kernels::integrate_range(IntegrationMethod::Simpson, 0, 2.0, 10.0, 0.0037), 1e-9);
+}
+
+/**
+ * @brief Тест передачи метода интегрирования в задаче.
+ */
+TEST_F(IntegrationTest, TaskMethodRoundTrip) {
+    IntegrationTask original;
+    original.lower_bound = 2.0;
+    original.upper_bound = 10.0;
+    original.step = 0.5;
+    original.task_id = 7;
+    original.method = IntegrationMethod::GaussLegendre;
+    original.order = 12;
+    original.principal_value = true;
+    original.integrand = IntegrandId::PowerOverLog;
+    original.params = {1.5};
+
+    std::vector<char> buffer;
+    wire::Writer writer(buffer);
+    wire::encode(writer, original);
+    IntegrationTask restored;
+    wire::Reader reader(buffer.data(), buffer.size());
+    wire::decode(reader, restored);
+    EXPECT_EQ(restored.task_id, 7u);
+    EXPECT_EQ(restored.method, IntegrationMethod::GaussLegendre);
+    EXPECT_EQ(restored.order, 12u);
+    EXPECT_TRUE(restored.principal_value);
+    EXPECT_EQ(restored.integrand, IntegrandId::PowerOverLog);
+    EXPECT_EQ(restored.params, std::vector<double>{1.5});
+}
+
+/**
+ * @brief Тест адаптивного метода Гаусса-Кронрода.
+ */
+TEST_F(IntegrationTest, AdaptiveGaussKronrod) {
+    for (unsigned points : {15u, 21u}) {
+        kernels::Estimate estimate = kernels::integrate_adaptive(points, 2.0, 10.0, 1e-12, 0.0);
+        EXPECT_NEAR(kIntegral2To10, estimate.value, 1e-12) << points;
+        EXPECT_LE(estimate.error, 1e-12) << points;
+        EXPECT_GE(estimate.error, std::abs(kIntegral2To10 - estimate.value)) << points;
+    }
+
+    // Отрезок вблизи особой точки требует дробления, но сходится
+    kernels::Estimate near_one = kernels::integrate_adaptive(21, 1.001, 2.0, 1e-10, 1e-12);
+    double reference = kernels::integrate_range(IntegrationMethod::TanhSinh, 6, 1.001, 2.0, 0.001);
+    EXPECT_NEAR(reference, near_one.value, 1e-9);
+    EXPECT_LE(near_one.error, 1e-10);
+}
+
+/**
+ * @brief Тест интегрального логарифма по эталонным значениям (30 значащих цифр).
+ */
+TEST_F(IntegrationTest, LogIntegralReferenceValues) {
+    const double cases[][2] = {
+        {0.5, -0.378671043061087976727207184637},
+        {1.5, 0.125064986315296355994350004796},
+        {2.0, 1.04516378011749278484458888919},
+        {3.0, 2.16358859466719197287692236735},
+        {10.0, 6.16559950478729793752298175267},
+        {100.0, 30.126141584079629925901741339},
+        {1e6, 78627.5491594621819198629107479},
+        {1e12, 37607950280.804865489534927091},
+        {1e17, 2623557165610821.77806912487357},
+        {1e20, 2220819602783663483.54830553207},
+        {1e100, 4.361971987140703228164887666e+97},
+        {1.0000001, -15.5408799354729201383343834309},
+    };
+    for (const auto& c : cases) {
+        EXPECT_NEAR(c[1], special::log_integral(c[0]), 1e-14 * std::abs(c[1])) << "x = " << c[0];
+    }
+    EXPECT_TRUE(std::isinf(special::log_integral(1.0)));
+    EXPECT_EQ(0.0, special::log_integral(0.0));
+}
+
+/**
+ * @brief Тест точной формулы li(b) - li(a), включая узкие интервалы.
+ */
+TEST_F(IntegrationTest, LogIntegralDifference) {
+    EXPECT_NEAR(5.120435724669805, special::log_integral_difference(2.0, 10.0), 1e-14);
+
+    // Узкий интервал: прямая квадратура вместо разности больших значений li
+    double narrow = special::log_integral_difference(1e6, 1e6 + 1.0);
+    EXPECT_NEAR(0.072382411030936067946848814463, narrow, 1e-15 * narrow);
+    EXPECT_EQ(narrow, kernels::integrate_range(IntegrationMethod::ClosedForm, 0, 1e6, 1e6 + 1.0, 0.0));
+}
+
+/**
+ * @brief Тест аппроксимации Чебышёва: точность и переиспользование коэффициентов.
+ */
+TEST_F(IntegrationTest, ChebyshevSurrogate) {
+    chebyshev::SurrogateCache cache;
+    kernels::Estimate estimate = cache.integrate(2.0, 10.0);
+    EXPECT_NEAR(kIntegral2To10, estimate.value, 1e-13);
+    EXPECT_LE(estimate.error, 1e-11);
+
+    // Вложенный диапазон целиком покрывается уже аппроксимированными ячейками
+    chebyshev::CacheStats before = cache.stats();
+    kernels::Estimate inner = cache.integrate(3.0, 7.0);
+    chebyshev::CacheStats after = cache.stats();
+    EXPECT_NEAR(reference_integral(3.0, 7.0), inner.value, 1e-13);
+    EXPECT_EQ(before.misses, after.misses);
+    EXPECT_GT(after.hits, before.hits);
+
+    // Ячейки сгущаются к особой точке и к большим x
+    EXPECT_NEAR(reference_integral(1.01, 2.0), cache.integrate(1.01, 2.0).value, 1e-11);
+    EXPECT_NEAR(reference_integral(1e6, 1e9), cache.integrate(1e6, 1e9).value, 1e-14 * 5e7);
+    EXPECT_NEAR(reference_integral(2.0, 10.0),
+                kernels::integrate_range(IntegrationMethod::Chebyshev, 0, 2.0, 10.0, 0.0), 1e-13);
+}
+
+/**
+ * @brief Тест общих кэшей Чебышёва: число наборов параметров ограничено, вытесняется давно не использованный.
+ */
+TEST_F(IntegrationTest, ChebyshevSharedCacheBound) {
+    auto params = [](size_t i) { return IntegrandParams{1.0 + static_cast<double>(i), 0.0}; };
+    std::shared_ptr<chebyshev::SurrogateCache> first =
+        chebyshev::SurrogateCache::shared(IntegrandId::Gaussian, params(0));
+    EXPECT_EQ(first, chebyshev::SurrogateCache::shared(IntegrandId::Gaussian, params(0)));
+    std::shared_ptr<chebyshev::SurrogateCache> recent;
+    for (size_t i = 1; i <= chebyshev::kMaxSharedCaches; ++i) {
+        recent = chebyshev::SurrogateCache::shared(IntegrandId::Gaussian, params(i));
+    }
+    // Первый кэш вытеснен, но живет, пока его держат
+    EXPECT_NE(first, chebyshev::SurrogateCache::shared(IntegrandId::Gaussian, params(0)));
+    EXPECT_EQ(recent, chebyshev::SurrogateCache::shared(IntegrandId::Gaussian, params(chebyshev::kMaxSharedCaches)));
+    EXPECT_NEAR(std::sqrt(std::acos(-1.0)) / 2.0, first->integrate(0.0, 10.0).value, 1e-12);
+}
+
+/**
+ * @brief Тест вычитания особенности: старт у x = 1 и главное значение через x = 1.
+ */
+TEST_F(IntegrationTest, SingularitySubtraction) {
+    // Остаток аналитичен в x = 1 (g(1) = 1/2), ряд у x = 1 и прямая формула сшиваются при |x - 1| = 0.1
+    kernels::Estimate at_one = kernels::integrate_remainder(IntegrationMethod::Midpoint, 0, 1.0 - 1e-3, 1.0 + 1e-3,
+                                                            2e-3, 0.0, 0.0);
+    EXPECT_NEAR(2e-3 * 0.5, at_one.value, 1e-12);
+    double seam = kernels::integrate_remainder(IntegrationMethod::GaussLegendre, 16, 1.05, 1.15, 0.1, 0.0, 0.0).value;
+    EXPECT_NEAR(reference_integral(1.05, 1.15) - std::log(0.15 / 0.05), seam, 1e-14);
+
+    // Нижний предел у x = 1: обычный шаг вместо исчезающе малого
+    double reference = reference_integral(1.0000001, 2.0);
+    kernels::Estimate gauss = kernels::integrate_principal_value(IntegrationMethod::GaussLegendre, 8, 1.0000001, 2.0,
+                                                                 0.1, 0.0, 0.0);
+    EXPECT_NEAR(reference, gauss.value, 1e-13);
+    kernels::Estimate midpoint = kernels::integrate_principal_value(IntegrationMethod::Midpoint, 0, 1.0000001, 2.0,
+                                                                    0.01, 0.0, 0.0);
+    EXPECT_NEAR(reference, midpoint.value, 1e-5);
+
+    // Главное значение через x = 1 совпадает с li(b) - li(a)
+    kernels::Estimate adaptive = kernels::integrate_principal_value(IntegrationMethod::AdaptiveGaussKronrod, 21, 0.5,
+                                                                    3.0, 0.0, 1e-13, 0.0);
+    EXPECT_NEAR(reference_integral(0.5, 3.0), adaptive.value, 1e-12);
+
+    // Разбиение диапазона: остаток по частям плюс сингулярная часть один раз
+    double parts = kernels::integrate_remainder(IntegrationMethod::Simpson, 0, 0.5, 1.0, 1e-3, 0.0, 0.0).value +
+                   kernels::integrate_remainder(IntegrationMethod::Simpson, 0, 1.0, 3.0, 1e-3, 0.0, 0.0).value +
+                   kernels::singular_part(0.5, 3.0);
+    EXPECT_NEAR(reference_integral(0.5, 3.0), parts, 1e-12);
+}
+
+/**
+ * @brief Тест точности векторной экспоненты.
+ */
+TEST_F(IntegrationTest, VectorExpAccuracy) {
+    for (double x = -700.0; x < 700.0; x += 0.737) {
+        double expected = std::exp(x);
+        EXPECT_NEAR(expected, simd::exp<simd::Scalar>(x), 1e-15 * expected) << "x = " << x;
+    }
+}
+
+/**
+ * @brief Тест реестра функций: каждая функция во всех вариантах ядра против точной формулы.
+ */
+TEST_F(IntegrationTest, IntegrandRegistry) {
+    struct Case {
+        IntegrandId integrand;
+        std::vector<double> params;
+        double lower_bound;
+        double upper_bound;
+        double expected;
+    };
+    const Case cases[] = {
+        {IntegrandId::InvLog, {}, 2.0, 10.0, kIntegral2To10},
+        {IntegrandId::ExpOverX, {}, 1.0, 5.0, 0.21823563880424494787983321349},
+        {IntegrandId::PowerOverLog, {2.0}, 2.0, 5.0, 8.54537136127741359021575716096},
+        {IntegrandId::Gaussian, {}, -1.0, 2.0, 1.62890552357484870536694847205},
+        {IntegrandId::Gaussian, {3.0}, -1.0, 2.0, 1.01600642129020493532067794891},
+    };
+
+    const IsaLevel initial = kernels::active_isa();
+    for (IsaLevel level : {IsaLevel::Scalar, IsaLevel::Sse2, IsaLevel::Avx2, IsaLevel::Avx512}) {
+        if (!kernels::select_isa(level)) {
+            continue;
+        }
+        for (const Case& c : cases) {
+            IntegrationTask task;
+            task.lower_bound = c.lower_bound;
+            task.upper_bound = c.upper_bound;
+            task.step = 0.25;
+            task.task_id = 0;
+            task.method = IntegrationMethod::GaussLegendre;
+            task.order = 16;
+            task.integrand = c.integrand;
+            task.params = c.params;
+            const char* name = kernels::integrand_info(c.integrand).name;
+
+            double composite = kernels::integrate_task(task, c.lower_bound, c.upper_bound, 0.0).value;
+            EXPECT_NEAR(c.expected, composite, 1e-13 * std::abs(c.expected)) << name << ", " << kernels::kernel_isa_name();
+
+            task.method = IntegrationMethod::AdaptiveGaussKronrod;
+            task.order = 21;
+            task.rel_tol = 1e-13;
+            double adaptive = kernels::integrate_task(task, c.lower_bound, c.upper_bound, 0.0).value;
+            EXPECT_NEAR(c.expected, adaptive, 1e-12 * std::abs(c.expected)) << name << ", " << kernels::kernel_isa_name();
+
+            task.method = IntegrationMethod::Chebyshev;
+            task.rel_tol = 0.0;
+            double surrogate = kernels::integrate_task(task, c.lower_bound, c.upper_bound, 0.0).value;
+            EXPECT_NEAR(c.expected, surrogate, 1e-13 * std::abs(c.expected)) << name << ", " << kernels::kernel_isa_name();
+        }
+    }
+    EXPECT_TRUE(kernels::select_isa(initial));
+
+    // Точные формулы и параметры по умолчанию
+    double value = 0.0;
+    EXPECT_TRUE(kernels::integrate_closed_form(IntegrandId::Gaussian, kernels::resolve_params(IntegrandId::Gaussian, {}),
+                                               -1.0, 2.0, value));
+    EXPECT_NEAR(1.62890552357484870536694847205, value, 1e-15);
+    EXPECT_FALSE(kernels::integrate_closed_form(IntegrandId::ExpOverX, {}, 1.0, 5.0, value));
+    EXPECT_EQ(2.0, kernels::resolve_params(IntegrandId::PowerOverLog, {})[0]);
+    EXPECT_EQ(0.0, kernels::resolve_params(IntegrandId::InvLog, {5.0})[0]);
+}
+
+/**
+ * @brief Тест точного накопителя: сумма не зависит от порядка и округляется один раз.
+ */
+TEST_F(IntegrationTest, ExactSumIsExact) {
+    ExactSum cancellation;
+    cancellation.add(1e100);
+    cancellation.add(1.0);
+    cancellation.add(-1e100);
+    EXPECT_EQ(1.0, cancellation.round());
+
+    // Десять слагаемых 0.1 в точности дают 1 + 5.55e-17, что округляется до 1
+    ExactSum tenths;
+    for (int i = 0; i < 10; ++i) {
+        tenths.add(0.1);
+    }
+    EXPECT_EQ(1.0, tenths.round());
+
+    // Ровно посередине между соседними double: к четному
+    ExactSum tie(1.0);
+    tie.add(std::ldexp(1.0, -53));
+    EXPECT_EQ(1.0, tie.round());
+    tie.add(std::ldexp(1.0, -105));
+    EXPECT_EQ(1.0 + std::ldexp(1.0, -52), tie.round());
+
+    std::vector<double> values;
+    for (int i = 1; i <= 2000; ++i) {
+        values.push_back(std::ldexp((i % 7 == 0 ? -1.0 : 1.0) / i, (i * 37) % 200 - 100));
+    }
+    values.push_back(std::ldexp(1.0, -1074));
+    ExactSum forward;
+    ExactSum backward;
+    ExactSum halves[2];
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        forward.add(values[i]);
+        backward.add(values[values.size() - 1 - i]);
+        halves[i % 2].add(values[i]);
+    }
+    halves[0].add(halves[1]);
+    EXPECT_TRUE(forward == backward);
+    EXPECT_TRUE(forward == halves[0]);
+    EXPECT_EQ(-1e300, ExactSum(-1e300).round());
+    EXPECT_EQ(std::ldexp(1.0, -1074), ExactSum(std::ldexp(1.0, -1074)).round());
+
+    // Накопитель передается в результате без потерь
+    IntegrationResult original = {0.0, 7, 0.0, forward};
+    std::vector<char> buffer;
+    wire::Writer writer(buffer);
+    wire::encode(writer, original);
+    IntegrationResult restored;
+    wire::Reader reader(buffer.data(), buffer.size());
+    wire::decode(reader, restored);
+    EXPECT_TRUE(original.sum == restored.sum);
+}
+
+/**
+ * @brief Тест числа панелей: пустой диапазон дает 0, непредставимое число панелей отвергается.
+ */
+TEST_F(IntegrationTest, GridPanelsRange) {
+    EXPECT_EQ(4u, kernels::grid_panels(2.0, 4.0, 0.5));
+    EXPECT_EQ(5u, kernels::grid_panels(2.0, 4.1, 0.5));
+    EXPECT_EQ(0u, kernels::grid_panels(4.0, 2.0, 0.5));
+    EXPECT_EQ(0u, kernels::grid_panels(2.0, 4.0, std::nan("")));
+    EXPECT_THROW(kernels::grid_panels(2.0, std::numeric_limits<double>::infinity(), 0.5), std::invalid_argument);
+    EXPECT_THROW(kernels::grid_panels(2.0, 1e300, 1e-300), std::invalid_argument);
+    EXPECT_THROW(kernels::grid_panels(2.0, 4.0, std::numeric_limits<double>::denorm_min()), std::invalid_argument);
+}
+
+/**
+ * @brief Тест воспроизводимости: любое разбиение сетки дает одинаковые биты.
+ *
+ * Варианты AVX2 и AVX-512 выполняют одни и те же операции и тоже должны совпадать побитно.
+ */
+TEST_F(IntegrationTest, PartitionInvariantReduction) {
+    const IsaLevel initial = kernels::active_isa();
+    IntegrationTask task;
+    task.lower_bound = 0.5;
+    task.upper_bound = 7.3;
+    task.step = 4e-4;
+    task.task_id = 0;
+
+    const IntegrationMethod methods[] = {IntegrationMethod::Midpoint, IntegrationMethod::Simpson,
+                                         IntegrationMethod::GaussLegendre, IntegrationMethod::TanhSinh};
+    const IsaLevel levels[] = {IsaLevel::Scalar, IsaLevel::Sse2, IsaLevel::Avx2, IsaLevel::Avx512};
+    const uint64_t panels = kernels::grid_panels(task.lower_bound, task.upper_bound, task.step);
+    EXPECT_EQ(17000u, panels);
+
+    for (bool principal_value : {false, true}) {
+        task.principal_value = principal_value;
+        for (IntegrationMethod method : methods) {
+            task.method = method;
+            std::vector<double> fma_results;
+            for (IsaLevel level : levels) {
+                if (!kernels::select_isa(level)) {
+                    continue;
+                }
+                ExactSum whole;
+                kernels::accumulate_task(task, 0, panels, whole);
+                const double expected = whole.round();
+                EXPECT_EQ(expected, kernels::integrate_task(task, task.lower_bound, task.upper_bound, 0.0).value);
+                if (level == IsaLevel::Avx2 || level == IsaLevel::Avx512) {
+                    fma_results.push_back(expected);
+                }
+
+                for (std::size_t parts : {2u, 3u, 7u, 64u}) {
+                    // Части складываются в обратном порядке, как результаты, пришедшие не по очереди
+                    std::vector<uint64_t> bounds = kernels::split_panels(0, panels, parts);
+                    ExactSum total;
+                    for (std::size_t i = bounds.size() - 1; i > 0; --i) {
+                        ExactSum part;
+                        kernels::accumulate_task(task, bounds[i - 1], bounds[i], part);
+                        total.add(part);
+                    }
+                    // Совпадают не только округленные значения, но и точные суммы
+                    EXPECT_TRUE(whole == total) << "метод " << static_cast<unsigned>(method) << ", частей "
+                                                << parts << ", " << kernels::kernel_isa_name();
+                }
+            }
+            for (double value : fma_results) {
+                EXPECT_EQ(fma_results.front(), value) << "метод " << static_cast<unsigned>(method);
+            }
+            EXPECT_TRUE(kernels::select_isa(initial));
+        }
+    }
+
+    std::vector<uint64_t> bounds = kernels::split_panels(100, 5000, 4);
+    EXPECT_EQ(100u, bounds.front());
+    EXPECT_EQ(5000u, bounds.back());
+    for (std::size_t i = 1; i + 1 < bounds.size(); ++i) {
+        EXPECT_EQ(0u, bounds[i] % kernels::kReductionBlock);
+    }
+}
+
+// Тест пула потоков: каждое задание выполняется ровно один раз, исключение доходит до вызывающего
+TEST_F(IntegrationTest, ThreadPoolWorkStealing) {
+    ThreadPool pool(4);
+    EXPECT_EQ(4u, pool.size());
+
+    // Неравномерные задания: потоки с легкими отрезками забирают работу у остальных
+    for (int round = 0; round < 3; ++round) {
+        std::vector<std::atomic<int>> calls(1000);
+        std::atomic<uint64_t> total{0};
+        pool.parallel_for(calls.size(), [&](std::size_t i) {
+            calls[i].fetch_add(1);
+            volatile double sink = 0.0;
+            for (std::size_t k = 0; k < (i < 250 ? 20000u : 10u); ++k) {
+                sink = sink + std::sqrt(static_cast<double>(k));
+            }
+            total.fetch_add(i);
+        });
+        for (const auto& count : calls) {
+            EXPECT_EQ(1, count.load());
+        }
+        EXPECT_EQ(999u * 1000u / 2u, total.load());
+    }
+
+    // Точная сумма частей не зависит от того, какой поток выполнил какую часть
+    IntegrationTask task;
+    task.lower_bound = 2.0;
+    task.upper_bound = 50.0;
+    task.step = 1e-4;
+    task.task_id = 1;
+    task.method = IntegrationMethod::Simpson;
+    const uint64_t panels = kernels::grid_panels(task.lower_bound, task.upper_bound, task.step);
+    std::vector<uint64_t> bounds = kernels::split_panels(0, panels, 64);
+    std::vector<ExactSum> parts(bounds.size() - 1);
+    pool.parallel_for(parts.size(), [&](std::size_t i) {
+        kernels::accumulate_task(task, bounds[i], bounds[i + 1], parts[i]);
+    });
+    ExactSum pooled;
+    for (const auto& part : parts) {
+        pooled.add(part);
+    }
+    ExactSum whole;
+    kernels::accumulate_task(task, 0, panels, whole);
+    EXPECT_TRUE(whole == pooled);
+
+    std::atomic<int> completed{0};
+    EXPECT_THROW(pool.parallel_for(16, [&](std::size_t i) {
+        if (i == 5) {
+            throw std::runtime_error("ошибка задания");
+        }
+        completed.fetch_add(1);
+    }), std::runtime_error);
+    EXPECT_EQ(15, completed.load());
+    pool.parallel_for(0, [](std::size_t) {});
+
+    // Вызывающие потоки только ждут: одновременно считают не больше потоков, чем в пуле
+    const std::thread::id caller = std::this_thread::get_id();
+    std::atomic<int> running{0};
+    std::atomic<int> peak{0};
+    std::atomic<bool> ran_on_caller{false};
+    auto job = [&](std::size_t) {
+        const int now = running.fetch_add(1) + 1;
+        int seen = peak.load();
+        while (now > seen && !peak.compare_exchange_weak(seen, now)) {
+        }
+        if (std::this_thread::get_id() == caller) {
+            ran_on_caller = true;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+        running.fetch_sub(1);
+    };
+    std::thread other([&]() { pool.parallel_for(64, job); });
+    pool.parallel_for(64, job);
+    other.join();
+    EXPECT_FALSE(ran_on_caller.load());
+    EXPECT_LE(peak.load(), static_cast<int>(pool.size()));
+}
+
+// Тест размещения потоков: по потоку на физическое ядро, соседние потоки на одном узле NUMA
+TEST_F(IntegrationTest, CpuPlacement) {
+    // Два узла по два ядра с SMT; процессоры уже упорядочены, как их возвращает detect_cpu_topology()
+    std::vector<LogicalCpu> topology = {
+        {0, 0, 0, 0}, {4, 0, 0, 0}, {1, 1, 0, 0}, {5, 1, 0, 0},
+        {2, 0, 1, 1}, {6, 0, 1, 1}, {3, 1, 1, 1}, {7, 1, 1, 1},
+    };
+    EXPECT_EQ(std::vector<int>({0, 1, 2, 3}), plan_placement(topology, PinningMode::Cores));
+    EXPECT_EQ(std::vector<int>({0, 4, 1, 5, 2, 6, 3, 7}), plan_placement(topology, PinningMode::Threads));
+    EXPECT_TRUE(plan_placement(topology, PinningMode::None).empty());
+    EXPECT_EQ(2u, count_numa_nodes(topology));
+
+    PinningMode mode = PinningMode::None;
+    EXPECT_TRUE(parse_pinning_mode("cores", mode));
+    EXPECT_EQ(PinningMode::Cores, mode);
+    EXPECT_FALSE(parse_pinning_mode("numa", mode));
+
+    // Закрепленный пул считает так же, как свободный
+    const std::vector<int> cpus = plan_placement(detect_cpu_topology(), PinningMode::Cores);
+    ThreadPool pool(2, cpus);
+    EXPECT_LE(pool.pinned(), pool.size());
+    std::vector<int> calls(64, 0);
+    pool.parallel_for(calls.size(), [&](std::size_t i) { calls[i] += 1; });
+    EXPECT_EQ(std::vector<int>(64, 1), calls);
+}
+
+// Тест емкости в контейнере: квоты cgroup v2 и v1 по группе процесса и ее предкам
+TEST_F(IntegrationTest, ContainerCpuCapacity) {
+#if !defined(__linux__)
+    GTEST_SKIP() << "cgroup и sched_getaffinity есть только в Linux";
+#endif
+    namespace fs = std::filesystem;
+    const fs::path root = fs::temp_directory_path() / "integration_cgroup_test";
+    fs::remove_all(root);
+    auto write = [&root](const std::string& path, const std::string& text) {
+        fs::create_directories((root / path).parent_path());
+        std::ofstream(root / path) << text;
+    };
+    const CpuCapacity host = detect_cpu_capacity();
+    ASSERT_GT(host.affinity_cpus, 0u);
+
+    // cgroup v2: группа пода ограничена 1.5 ядра, родитель - 4 ядрами
+    write("proc/self/mountinfo", "25 1 0:22 / /sys/fs/cgroup rw,nosuid - cgroup2 cgroup2 rw\n");
+    write("proc/self/cgroup", "0::/kubepods/pod1\n");
+    write("sys/fs/cgroup/kubepods/cpu.max", "400000 100000\n");
+    write("sys/fs/cgroup/kubepods/pod1/cpu.max", "150000 100000\n");
+    CpuCapacity capacity = detect_cpu_capacity(0.0, root.string());
+    EXPECT_DOUBLE_EQ(1.5, capacity.quota);
+    EXPECT_DOUBLE_EQ(std::min(1.5, static_cast<double>(capacity.affinity_cpus)), capacity.effective);
+
+    // Без ограничения емкость определяется маской процессоров, явное значение важнее всего
+    write("sys/fs/cgroup/kubepods/cpu.max", "max 100000\n");
+    write("sys/fs/cgroup/kubepods/pod1/cpu.max", "max 100000\n");
+    capacity = detect_cpu_capacity(0.0, root.string());
+    EXPECT_DOUBLE_EQ(0.0, capacity.quota);
+    EXPECT_EQ("affinity", capacity.source);
+    EXPECT_DOUBLE_EQ(2.5, detect_cpu_capacity(2.5, root.string()).effective);
+
+    // cgroup v1: иерархия cpu смонтирована с корнем группы контейнера
+    fs::remove_all(root);
+    write("proc/self/mountinfo", "33 32 0:29 /docker/abc /sys/fs/cgroup/cpu rw - cgroup cgroup rw,cpu,cpuacct\n");
+    write("proc/self/cgroup", "4:memory:/docker/abc\n2:cpu,cpuacct:/docker/abc\n");
+    write("sys/fs/cgroup/cpu/cpu.cfs_quota_us", "50000\n");
+    write("sys/fs/cgroup/cpu/cpu.cfs_period_us", "100000\n");
+    capacity = detect_cpu_capacity(0.0, root.string());
+    EXPECT_DOUBLE_EQ(0.5, capacity.quota);
+    EXPECT_DOUBLE_EQ(0.5, capacity.effective);
+    EXPECT_EQ("cgroup", capacity.source);
+    fs::remove_all(root);
+}
+
+// Тест меры объема работы: узлы панели, умноженные на панели части сетки
+TEST_F(IntegrationTest, TaskEvaluationCount) {
+    IntegrationTask task;
+    task.lower_bound = 2.0;
+    task.upper_bound = 12.0;
+    task.step = 0.01;
+    task.task_id = 0;
+    EXPECT_EQ(1000u, kernels::task_evaluations(task));
+    task.method = IntegrationMethod::Simpson;
+    EXPECT_EQ(2000u, kernels::task_evaluations(task));
+    task.method = IntegrationMethod::GaussLegendre;
+    task.order = 5;
+    task.first_panel = 100;
+    task.last_panel = 300;
+    EXPECT_EQ(1000u, kernels::task_evaluations(task));
+    task.method = IntegrationMethod::TanhSinh;
+    task.order = 2;
+    EXPECT_EQ(200u * quadrature::make_tanh_sinh(2).offsets.size(), kernels::task_evaluations(task));
+    task.method = IntegrationMethod::AdaptiveGaussKronrod;
+    EXPECT_EQ(0u, kernels::task_evaluations(task));
+}
+
+// Тест отмены: сообщение отмены переживает сериализацию, отмененные части пула пропускаются
+TEST_F(IntegrationTest, TaskCancellation) {
+    CancelRequest original;
+    original.job_id = 9;
+    original.whole_job = true;
+    std::vector<char> buffer;
+    wire::Writer writer(buffer);
+    wire::encode(writer, original);
+    CancelRequest restored;
+    wire::Reader reader(buffer.data(), buffer.size());
+    wire::decode(reader, restored);
+    EXPECT_EQ(9u, restored.job_id);
+    EXPECT_TRUE(restored.whole_job);
+
+    ThreadPool pool(2);
+    CancellationToken token;
+    std::atomic<int> executed{0};
+    pool.parallel_for(1000, [&](std::size_t) {
+        if (executed.fetch_add(1) == 10) {
+            token.cancel();
+        }
+    }, &token);
+    EXPECT_TRUE(token.cancelled());
+    EXPECT_LT(executed.load(), 1000);
+}
+
+// Тест сообщений клиента: отчеты о ходе задач переживают сериализацию, heartbeat не несет данных
+TEST_F(IntegrationTest, ProgressReportRoundTrip) {
+    std::vector<ProgressReport> original;
+    ProgressReport report;
+    report.task_id = 4;
+    report.job_id = 2;
+    report.fraction = 0.25;
+    report.partial_sum = 1.5;
+    report.elapsed_seconds = 0.75;
+    report.evals_per_sec = 3.0e8;
+    original.push_back(report);
+
+    std::vector<char> reports_buffer;
+    wire::Writer reports_writer(reports_buffer);
+    wire::encode(reports_writer, original);
+    std::vector<ProgressReport> restored;
+    wire::Reader reader(reports_buffer.data(), reports_buffer.size());
+    wire::decode(reader, restored);
+    ASSERT_EQ(1u, restored.size());
+    EXPECT_EQ(4u, restored[0].task_id);
+    EXPECT_EQ(2u, restored[0].job_id);
+    EXPECT_DOUBLE_EQ(0.25, restored[0].fraction);
+    EXPECT_DOUBLE_EQ(1.5, restored[0].partial_sum);
+    EXPECT_DOUBLE_EQ(0.75, restored[0].elapsed_seconds);
+    EXPECT_DOUBLE_EQ(3.0e8, restored[0].evals_per_sec);
+
+    // Heartbeat - конверт без данных
+    std::vector<char> buffer;
+    wire::Writer writer(buffer);
+    wire::encode_message(writer, wire::make_envelope(wire::MessageType::Heartbeat), wire::Empty{});
+    EXPECT_EQ(wire::EnvelopeBlock::kMinSize, buffer.size());
+}
+
+// Тест планировщика: места выдаются по весам источников, при равенстве - раньше зарегистрированному
+TEST_F(IntegrationTest, FairShareScheduling) {
+    FairShareScheduler scheduler(1);
+    const std::size_t heavy = scheduler.add_share(3.0);
+    const std::size_t light = scheduler.add_share(1.0);
+    const std::size_t gate = scheduler.add_share(1.0);
+
+    // Единственное место занято, пока все задачи обоих источников не встанут в очередь
+    scheduler.acquire(gate);
+    std::mutex order_mutex;
+    std::vector<std::size_t> order;
+    std::vector<std::thread> threads;
+    for (std::size_t share : {heavy, heavy, heavy, heavy, light, light, light, light}) {
+        threads.emplace_back([&, share]() {
+            scheduler.acquire(share);
+            {
+                std::lock_guard<std::mutex> lock(order_mutex);
+                order.push_back(share);
+            }
+            scheduler.release(share, 1.0);
+        });
+    }
+    while (scheduler.waiting() < threads.size()) {
+        std::this_thread::yield();
+    }
+    scheduler.release(gate, 0.0);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    // Виртуальное время: heavy 0, 1/3, 2/3, 1, ...; light 0, 1, 2, ...
+    const std::vector<std::size_t> expected = {heavy, light, heavy, heavy, heavy, light, light, light};
+    EXPECT_EQ(expected, order);
+    EXPECT_DOUBLE_EQ(4.0, scheduler.usage(heavy));
+    EXPECT_DOUBLE_EQ(4.0, scheduler.usage(light));
+    EXPECT_DOUBLE_EQ(0.0, scheduler.usage(gate));
+}
+
+// Тест кэша результатов: ключ без номера задачи, вытеснение давно не использованных, файл переживает кэш
+TEST_F(IntegrationTest, ResultCacheLru) {
+    IntegrationTask task;
+    task.lower_bound = 2.0;
+    task.upper_bound = 50.0;
+    task.step = 1e-3;
+    task.task_id = 1;
+    task.method = IntegrationMethod::Simpson;
+    task.last_panel = kernels::grid_panels(task.lower_bound, task.upper_bound, task.step);
+    IntegrationResult computed{0.0, task.task_id, 1e-12, ExactSum()};
+    kernels::accumulate_task(task, 0, task.last_panel, computed.sum);
+    computed.result = computed.sum.round();
+
+    IntegrationTask other = task;
+    other.step = 2e-3;
+    IntegrationTask third = task;
+    third.method = IntegrationMethod::Midpoint;
+
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "integration_result_cache_test.bin";
+    std::filesystem::remove(path);
+    {
+        ResultCache cache(2);
+        ASSERT_TRUE(cache.open_file(path.string()));
+        // Файл занят первым кэшем: второй остается в памяти
+        ResultCache concurrent(2);
+        EXPECT_FALSE(concurrent.open_file(path.string()));
+        EXPECT_FALSE(concurrent.stats().persistent);
+        IntegrationResult found;
+        EXPECT_FALSE(cache.lookup(task, found));
+        cache.store(task, computed);
+        cache.store(other, IntegrationResult{1.0, other.task_id, 0.0, ExactSum(1.0)});
+
+        // Повторная задача с другим номером находит результат и становится последней использованной
+        IntegrationTask repeated = task;
+        repeated.task_id = 42;
+        repeated.job_id = 7;
+        ASSERT_TRUE(cache.lookup(repeated, found));
+        EXPECT_EQ(42u, found.task_id);
+        EXPECT_TRUE(found.sum == computed.sum);
+
+        cache.store(third, IntegrationResult{2.0, third.task_id, 0.0, ExactSum(2.0)});
+        EXPECT_FALSE(cache.lookup(other, found));
+        ResultCacheStats stats = cache.stats();
+        EXPECT_EQ(1u, stats.hits);
+        EXPECT_EQ(2u, stats.misses);
+        EXPECT_EQ(2u, stats.entries);
+        EXPECT_TRUE(stats.persistent);
+    }
+
+    {
+        ResultCache restored(2);
+        ASSERT_TRUE(restored.open_file(path.string()));
+        EXPECT_EQ(2u, restored.stats().entries);
+        IntegrationResult found;
+        ASSERT_TRUE(restored.lookup(task, found));
+        EXPECT_TRUE(found.sum == computed.sum);
+        EXPECT_EQ(computed.result, found.result);
+        EXPECT_EQ(computed.error_estimate, found.error_estimate);
+        EXPECT_TRUE(restored.lookup(third, found));
+        EXPECT_FALSE(restored.lookup(other, found));
+    }
+
+    // Файл другой емкости несовместим и начинается пустым
+    ResultCache resized(3);
+    ASSERT_TRUE(resized.open_file(path.string()));
+    EXPECT_EQ(0u, resized.stats().entries);
+    std::filesystem::remove(path);
+}
+
+// Тест двоичного формата: значения передаются побитно, более длинный блок новой версии читается, усеченный - нет
+TEST_F(IntegrationTest, WireFormatRoundTrip) {
+    IntegrationTask task;
+    task.lower_bound = 0.1;
+    task.upper_bound = std::ldexp(1.0, -1070); // денормализованное число
+    task.step = -0.0;
+    task.task_id = 123456789012345ull;
+    task.job_id = 17;
+    task.method = IntegrationMethod::GaussLegendre;
+    task.order = 7;
+    task.abs_tol = 1e-300;
+    task.rel_tol = 1e-12;
+    task.principal_value = true;
+    task.integrand = IntegrandId::PowerOverLog;
+    task.params = {2.5};
+    task.first_panel = 1ull << 40;
+    task.last_panel = (1ull << 40) + 3;
+
+    ExactSum sum;
+    sum.add(1e300);
+    sum.add(0.1);
+    sum.add(-std::ldexp(1.0, -1074));
+    IntegrationResult result{sum.round(), 5, 1e-15, sum};
+
+    std::vector<char> buffer;
+    wire::Writer writer(buffer);
+    wire::encode(writer, task);
+    wire::encode(writer, result);
+
+    wire::Reader reader(buffer.data(), buffer.size());
+    IntegrationTask restored;
+    IntegrationResult restored_result;
+    wire::decode(reader, restored);
+    wire::decode(reader, restored_result);
+    EXPECT_EQ(0u, reader.remaining());
+
+    EXPECT_EQ(0, std::memcmp(&task.lower_bound, &restored.lower_bound, sizeof(double)));
+    EXPECT_EQ(0, std::memcmp(&task.upper_bound, &restored.upper_bound, sizeof(double)));
+    EXPECT_TRUE(std::signbit(restored.step));
+    EXPECT_EQ(task.task_id, restored.task_id);
+    EXPECT_EQ(task.job_id, restored.job_id);
+    EXPECT_EQ(task.method, restored.method);
+    EXPECT_EQ(task.order, restored.order);
+    EXPECT_EQ(task.abs_tol, restored.abs_tol);
+    EXPECT_EQ(task.rel_tol, restored.rel_tol);
+    EXPECT_TRUE(restored.principal_value);
+    EXPECT_EQ(task.integrand, restored.integrand);
+    EXPECT_EQ(task.params, restored.params);
+    EXPECT_EQ(task.first_panel, restored.first_panel);
+    EXPECT_EQ(task.last_panel, restored.last_panel);
+
+    EXPECT_EQ(5u, restored_result.task_id);
+    EXPECT_EQ(result.result, restored_result.result);
+    EXPECT_EQ(result.error_estimate, restored_result.error_estimate);
+    EXPECT_TRUE(restored_result.sum == sum);
+
+    // Блок следующей версии с дополнительным полем: лишние байты пропускаются
+    wire::CancelBlock cancel{};
+    cancel.size = sizeof(cancel) + 8;
+    cancel.version = wire::CancelBlock::kVersion + 1;
+    cancel.task_id = 9;
+    cancel.whole_job = 1;
+    std::vector<char> extended(reinterpret_cast<const char*>(&cancel),
+                               reinterpret_cast<const char*>(&cancel) + sizeof(cancel));
+    extended.resize(extended.size() + 8, '\x7f');
+    const uint64_t next_value = 77;
+    const char* next = reinterpret_cast<const char*>(&next_value);
+    extended.insert(extended.end(), next, next + sizeof(next_value));
+    wire::Reader extended_reader(extended.data(), extended.size());
+    CancelRequest restored_cancel;
+    std::size_t restored_value = 0;
+    wire::decode(extended_reader, restored_cancel);
+    wire::decode(extended_reader, restored_value);
+    EXPECT_EQ(9u, restored_cancel.task_id);
+    EXPECT_TRUE(restored_cancel.whole_job);
+    EXPECT_EQ(77u, restored_value);
+
+    // Усеченное сообщение отвергается
+    wire::Reader truncated(buffer.data(), wire::TaskBlock::kMinSize - 1);
+    EXPECT_THROW(wire::decode(truncated, restored), std::runtime_error);
+}
+
+// Тест точной суммы в сообщении: ненормализованные ячейки и конечный special отвергаются
+TEST_F(IntegrationTest, MalformedExactSumRejected) {
+    auto frame = [](int32_t chunk, int64_t value, double special) {
+        wire::ResultBlock block{};
+        block.size = sizeof(block);
+        block.version = wire::ResultBlock::kVersion;
+        block.task_id = 3;
+        block.special = special;
+        block.lowest_chunk = chunk;
+        block.chunk_count = 1;
+        std::vector<char> buffer(sizeof(block) + sizeof(value));
+        std::memcpy(buffer.data(), &block, sizeof(block));
+        std::memcpy(buffer.data() + sizeof(block), &value, sizeof(value));
+        return buffer;
+    };
+    auto decodes = [](const std::vector<char>& buffer) {
+        wire::Reader reader(buffer.data(), buffer.size());
+        IntegrationResult result;
+        wire::decode(reader, result);
+        return result;
+    };
+
+    // Ячейка c имеет вес 2^(32c - 1074)
+    EXPECT_TRUE(decodes(frame(10, 0xFFFFFFFFll, 0.0)).sum == ExactSum(std::ldexp(4294967295.0, 32 * 10 - 1074)));
+    EXPECT_TRUE(std::isinf(decodes(frame(0, 0, std::numeric_limits<double>::infinity())).sum.round()));
+    EXPECT_THROW(decodes(frame(10, -1, 0.0)), std::runtime_error);
+    EXPECT_THROW(decodes(frame(10, 1ll << 32, 0.0)), std::runtime_error);
+    EXPECT_THROW(decodes(frame(ExactSum::kChunks - 1, std::numeric_limits<int64_t>::max(), 0.0)), std::runtime_error);
+    EXPECT_THROW(decodes(frame(0, 0, 1.0)), std::runtime_error);
+
+    ExactSum::Raw raw = ExactSum(2.5).raw();
+    EXPECT_TRUE(ExactSum::valid(raw));
+    raw.chunks[5] = -1;
+    EXPECT_FALSE(ExactSum::valid(raw));
+    EXPECT_THROW(ExactSum::from_raw(raw), std::invalid_argument);
+}
+
+// Тест описания клиента: строка shared_memory читается только из блока версии 2 и новее
+TEST_F(IntegrationTest, ClientHelloVersions) {
+    ClientHello hello{8, "avx2"};
+    hello.heartbeat_ms = 250;
+    hello.shared_memory = "/integrator-1-0";
+    std::vector<char> buffer;
+    wire::Writer writer(buffer);
+    wire::encode(writer, hello);
+
+    ClientHello restored{};
+    wire::Reader reader(buffer.data(), buffer.size());
+    wire::decode(reader, restored);
+    EXPECT_EQ(8u, restored.num_cores);
+    EXPECT_EQ("avx2", restored.isa);
+    EXPECT_EQ(250u, restored.heartbeat_ms);
+    EXPECT_EQ(hello.shared_memory, restored.shared_memory);
+
+    // Байты после строк блока версии 1 не принимаются за имя сегмента
+    const uint32_t old_version = 1;
+    std::memcpy(buffer.data() + sizeof(uint32_t), &old_version, sizeof(old_version));
+    wire::Reader old_reader(buffer.data(), buffer.size());
+    wire::decode(old_reader, restored);
+    EXPECT_EQ("avx2", restored.isa);
+    EXPECT_TRUE(restored.shared_memory.empty());
+}
+
+// Тест кадров: несколько сообщений одной записью читаются по одному, сокет без алгоритма Нейгла
+TEST_F(IntegrationTest, CoalescedFrames) {
+    boost::asio::io_context io_context;
+    auto [sender, receiver] = connect_loopback(io_context);
+
+    boost::asio::ip::tcp::no_delay no_delay;
+    sender.get_option(no_delay);
+    EXPECT_TRUE(no_delay.value());
+
+    // Три задачи и приветствие уходят одной записью в сокет
+    MessageChannel sender_channel(sender);
+    MessageChannel receiver_channel(receiver);
+    IntegrationTask task;
+    task.lower_bound = 2.0;
+    task.upper_bound = 3.0;
+    task.step = 0.5;
+    for (size_t id = 1; id <= 3; ++id) {
+        task.task_id = id;
+        sender_channel.queue(wire::make_envelope(wire::MessageType::Task), task);
+    }
+    sender_channel.queue(wire::make_envelope(wire::MessageType::Welcome), static_cast<size_t>(42));
+    sender_channel.flush();
+
+    for (size_t id = 1; id <= 3; ++id) {
+        IntegrationTask received;
+        receiver_channel.receive(wire::MessageType::Task, received);
+        EXPECT_EQ(id, received.task_id);
+        EXPECT_EQ(3.0, received.upper_bound);
+    }
+    size_t value = 0;
+    receiver_channel.receive(wire::MessageType::Welcome, value);
+    EXPECT_EQ(42u, value);
+}
+
+// Тест кадров: сообщение неожиданного типа отвергается, следующие кадры читаются
+TEST_F(IntegrationTest, UnexpectedFrameType) {
+    boost::asio::io_context io_context;
+    auto [sender, receiver] = connect_loopback(io_context);
+    MessageChannel sender_channel(sender);
+    MessageChannel receiver_channel(receiver);
+
+    size_t value = 0;
+    sender_channel.send(wire::make_envelope(wire::MessageType::Welcome), static_cast<size_t>(42));
+    EXPECT_THROW(receiver_channel.receive(wire::MessageType::Task, value), std::runtime_error);
+    sender_channel.send(wire::make_envelope(wire::MessageType::Welcome), static_cast<size_t>(43));
+    receiver_channel.receive(wire::MessageType::Welcome, value);
+    EXPECT_EQ(43u, value);
+}
+
+// Тест пачек: задачи и результаты в одном сообщении в двоичном формате
+TEST_F(IntegrationTest, BatchMessagesRoundTrip) {
+    std::vector<IntegrationTask> tasks;
+    std::vector<IntegrationResult> results;
+    for (size_t id = 0; id < 100; ++id) {
+        IntegrationTask task;
+        task.lower_bound = 2.0 + id;
+        task.upper_bound = 3.0 + id;
+        task.step = 1e-3;
+        task.task_id = id;
+        task.first_panel = id * 1024;
+        task.last_panel = (id + 1) * 1024;
+        tasks.push_back(task);
+        results.push_back(IntegrationResult{0.5 * id, id, 0.0, ExactSum(0.5 * id)});
+    }
+
+    std::vector<char> buffer;
+    wire::Writer writer(buffer);
+    wire::encode(writer, tasks);
+    wire::encode(writer, results);
+    wire::Reader reader(buffer.data(), buffer.size());
+    std::vector<IntegrationTask> restored_tasks;
+    std::vector<IntegrationResult> restored_results;
+    wire::decode(reader, restored_tasks);
+    wire::decode(reader, restored_results);
+    ASSERT_EQ(100u, restored_tasks.size());
+    ASSERT_EQ(100u, restored_results.size());
+    for (size_t id = 0; id < 100; ++id) {
+        EXPECT_EQ(id, restored_tasks[id].task_id);
+        EXPECT_EQ(2.0 + id, restored_tasks[id].lower_bound);
+        EXPECT_EQ((id + 1) * 1024, restored_tasks[id].last_panel);
+        EXPECT_EQ(id, restored_results[id].task_id);
+        EXPECT_TRUE(restored_results[id].sum == ExactSum(0.5 * id));
+    }
+
+    // Число элементов больше, чем помещается в сообщение, отвергается до выделения памяти
+    const uint32_t forged_count = 1u << 30;
+    wire::Reader forged_reader(reinterpret_cast<const char*>(&forged_count), sizeof(forged_count));
+    EXPECT_THROW(wire::decode(forged_reader, restored_results), std::runtime_error);
+}
+
+// Тест конверта: сообщения разбираются по типу, фильтр отбрасывает их до разбора данных,
+// сообщения неизвестного типа пропускаются
+TEST_F(IntegrationTest, EnvelopeDispatch) {
+    CancelRequest cancel;
+    cancel.job_id = 3;
+    cancel.whole_job = true;
+    IntegrationResult result{1.5, 11, 0.0, ExactSum(1.5)};
+
+    std::vector<char> cancel_frame;
+    std::vector<char> result_frame;
+    std::vector<char> stale_frame;
+    std::vector<char> unknown_frame;
+    wire::Writer cancel_writer(cancel_frame);
+    wire::encode_message(cancel_writer, wire::make_envelope(wire::MessageType::Cancel, 3), cancel);
+    wire::Writer result_writer(result_frame);
+    wire::encode_message(result_writer, wire::make_envelope(wire::MessageType::Result, 7), result);
+    // Данные устаревшего результата испорчены: фильтр не должен их разбирать
+    wire::Writer stale_writer(stale_frame);
+    wire::encode(stale_writer, wire::make_envelope(wire::MessageType::Result, 6));
+    stale_frame.push_back('\x01');
+    wire::Envelope unknown;
+    unknown.type = static_cast<wire::MessageType>(200);
+    wire::Writer unknown_writer(unknown_frame);
+    wire::encode_message(unknown_writer, unknown, static_cast<size_t>(1));
+
+    wire::Dispatcher dispatcher;
+    std::vector<wire::Envelope> seen;
+    CancelRequest received_cancel;
+    IntegrationResult received_result{};
+    dispatcher.on<CancelRequest>(wire::MessageType::Cancel,
+        [&](const wire::Envelope& envelope, CancelRequest& payload) {
+            seen.push_back(envelope);
+            received_cancel = payload;
+        });
+    dispatcher.on<IntegrationResult>(wire::MessageType::Result,
+        [&](const wire::Envelope& envelope, IntegrationResult& payload) {
+            seen.push_back(envelope);
+            received_result = payload;
+        });
+    dispatcher.set_filter([](const wire::Envelope& envelope) {
+        return envelope.type != wire::MessageType::Result || envelope.correlation_id == 7;
+    });
+
+    wire::Envelope envelope;
+    EXPECT_TRUE(dispatcher.dispatch(cancel_frame.data(), cancel_frame.size(), envelope));
+    EXPECT_TRUE(dispatcher.dispatch(result_frame.data(), result_frame.size(), envelope));
+    EXPECT_FALSE(dispatcher.dispatch(stale_frame.data(), stale_frame.size(), envelope));
+    EXPECT_EQ(6u, envelope.correlation_id);
+    EXPECT_FALSE(dispatcher.dispatch(unknown_frame.data(), unknown_frame.size(), envelope));
+
+    ASSERT_EQ(2u, seen.size());
+    EXPECT_EQ(wire::MessageType::Cancel, seen[0].type);
+    EXPECT_EQ(0u, seen[0].flags);
+    EXPECT_EQ(3u, seen[0].correlation_id);
+    EXPECT_EQ(wire::kProtocolVersion, seen[0].protocol);
+    EXPECT_EQ(0u, seen[1].flags);
+    EXPECT_EQ(7u, seen[1].correlation_id);
+    EXPECT_TRUE(received_cancel.whole_job);
+    EXPECT_EQ(3u, received_cancel.job_id);
+    EXPECT_EQ(11u, received_result.task_id);
+    EXPECT_TRUE(received_result.sum == ExactSum(1.5));
+
+    // Конверт без версии протокола отвергается
+    wire::Envelope unversioned = wire::make_envelope(wire::MessageType::Cancel);
+    unversioned.protocol = 0;
+    std::vector<char> unversioned_frame;
+    wire::Writer unversioned_writer(unversioned_frame);
+    wire::encode_message(unversioned_writer, unversioned, cancel);
+    EXPECT_THROW(dispatcher.dispatch(unversioned_frame.data(), unversioned_frame.size(), envelope),
+                 std::runtime_error);
+}
+
+// Тест буферов соединения: после первого обмена пачки задач, результатов и отчетов
+// ходят без выделения памяти
+TEST_F(IntegrationTest, SteadyStateMessagingAllocations) {
+    boost::asio::io_context io_context;
+    auto [client_socket, server_socket] = connect_loopback(io_context);
+    MessageChannel server(server_socket);
+    MessageChannel client(client_socket);
+
+    std::vector<IntegrationTask> tasks(16);
+    std::vector<IntegrationResult> results;
+    std::vector<ProgressReport> reports(2);
+    for (size_t id = 0; id < tasks.size(); ++id) {
+        tasks[id].task_id = id;
+        tasks[id].lower_bound = 2.0 + id;
+        tasks[id].upper_bound = 3.0 + id;
+        tasks[id].step = 1e-3;
+        tasks[id].params = {0.5};
+        results.push_back(IntegrationResult{0.5 * id, id, 0.0, ExactSum(0.5 * id)});
+    }
+
+    size_t tasks_received = 0;
+    size_t results_received = 0;
+    size_t reports_received = 0;
+    wire::Dispatcher client_dispatcher;
+    client_dispatcher.on<std::vector<IntegrationTask>>(wire::MessageType::TaskBatch,
+        [&](const wire::Envelope&, std::vector<IntegrationTask>& batch) { tasks_received += batch.size(); });
+    wire::Dispatcher server_dispatcher;
+    server_dispatcher.on<std::vector<IntegrationResult>>(wire::MessageType::ResultBatch,
+        [&](const wire::Envelope&, std::vector<IntegrationResult>& batch) { results_received += batch.size(); });
+    server_dispatcher.on<std::vector<ProgressReport>>(wire::MessageType::Progress,
+        [&](const wire::Envelope&, std::vector<ProgressReport>& batch) { reports_received += batch.size(); });
+
+    wire::Envelope envelope;
+    auto exchange = [&]() {
+        server.send(wire::make_envelope(wire::MessageType::TaskBatch, 1),
+                    wire::Span<IntegrationTask>{tasks.data(), tasks.size()});
+        client.receive(client_dispatcher, envelope);
+        client.queue(wire::make_envelope(wire::MessageType::Progress), reports);
+        client.send(wire::make_envelope(wire::MessageType::ResultBatch, 1), results);
+        server.receive(server_dispatcher, envelope);
+        server.receive(server_dispatcher, envelope);
+    };
+
+    // Первый обмен наращивает буферы соединений и данные обработчиков
+    exchange();
+    const size_t allocations = g_allocations.load();
+    const size_t exchanges = 100;
+    for (size_t i = 0; i < exchanges; ++i) {
+        exchange();
+    }
+    EXPECT_EQ(allocations, g_allocations.load());
+    EXPECT_EQ((exchanges + 1) * tasks.size(), tasks_received);
+    EXPECT_EQ((exchanges + 1) * results.size(), results_received);
+    EXPECT_EQ((exchanges + 1) * reports.size(), reports_received);
+}
+
+#if defined(BOOST_ASIO_HAS_LOCAL_SOCKETS)
+// Тест транспорта AF_UNIX: те же кадры, что и по TCP, рукопожатие и пачка задач
+TEST_F(IntegrationTest, UnixSocketTransport) {
+    const std::string name =
+        "integration_test_" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()) + ".sock";
+    const std::string path = (std::filesystem::temp_directory_path() / name).string();
+    std::filesystem::remove(path);
+    boost::asio::io_context io_context;
+    boost::asio::local::stream_protocol::acceptor acceptor(io_context,
+                                                           boost::asio::local::stream_protocol::endpoint(path));
+    boost::asio::local::stream_protocol::socket local_socket(io_context);
+    local_socket.connect(boost::asio::local::stream_protocol::endpoint(path));
+    MessageSocket client_socket(std::move(local_socket));
+    MessageSocket server_socket(acceptor.accept());
+    configure_socket(client_socket);
+    configure_socket(server_socket);
+    EXPECT_EQ(AF_UNIX, server_socket.local_endpoint().protocol().family());
+
+    MessageChannel server(server_socket);
+    MessageChannel client(client_socket);
+    server.send(wire::make_envelope(wire::MessageType::Welcome), static_cast<size_t>(5));
+    size_t id = 0;
+    client.receive(wire::MessageType::Welcome, id);
+    EXPECT_EQ(5u, id);
+
+    std::vector<IntegrationTask> tasks(3);
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        tasks[i].task_id = i;
+        tasks[i].upper_bound = 3.0 + i;
+    }
+    server.send(wire::make_envelope(wire::MessageType::TaskBatch, 2), tasks);
+    std::vector<IntegrationTask> received;
+    client.receive(wire::MessageType::TaskBatch, received);
+    ASSERT_EQ(3u, received.size());
+    EXPECT_EQ(5.0, received[2].upper_bound);
+
+    acceptor.close();
+    std::filesystem::remove(path);
+}
+#endif
+
+#if defined(CLIENT_EXECUTABLE) && !defined(_WIN32)
+// Тест отказа задачи: клиент, у которого задача упала, сообщает серверу ее номер,
+// а не молчит, отправляя heartbeat
+TEST_F(IntegrationTest, ClientReportsFailedTask) {
+    boost::asio::io_context io_context;
+    boost::asio::ip::tcp::acceptor acceptor(io_context, {boost::asio::ip::address_v4::loopback(), 0});
+    const std::filesystem::path directory = std::filesystem::temp_directory_path() / "integration_failed_task_test";
+    std::filesystem::create_directories(directory);
+    const std::string command = "cd '" + directory.string() + "' && '" CLIENT_EXECUTABLE "' --server=127.0.0.1:" +
+                                std::to_string(acceptor.local_endpoint().port()) + " > /dev/null 2>&1";
+    std::thread client([&command]() { EXPECT_EQ(0, std::system(command.c_str())); });
+
+    MessageSocket socket(acceptor.accept());
+    MessageChannel channel(socket);
+    channel.send(wire::make_envelope(wire::MessageType::Welcome), static_cast<size_t>(1));
+    ClientHello hello{};
+    channel.receive(wire::MessageType::Hello, hello);
+
+    // Шаг меньше любого представимого числа панелей: выполнение задачи бросает исключение
+    IntegrationTask task;
+    task.lower_bound = 2.0;
+    task.upper_bound = 3.0;
+    task.step = std::numeric_limits<double>::denorm_min();
+    task.task_id = 7;
+    task.job_id = 5;
+    channel.send(wire::make_envelope(wire::MessageType::Task, task.job_id), task);
+
+    wire::Dispatcher dispatcher;
+    size_t failed_task = 0;
+    dispatcher.on<size_t>(wire::MessageType::TaskFailed,
+        [&failed_task](const wire::Envelope& envelope, size_t& task_id) {
+            EXPECT_EQ(5u, envelope.correlation_id);
+            failed_task = task_id;
+        });
+    dispatcher.on<std::vector<IntegrationResult>>(wire::MessageType::ResultBatch,
+        [](const wire::Envelope&, std::vector<IntegrationResult>&) { ADD_FAILURE() << "результат упавшей задачи"; });
+    wire::Envelope envelope;
+    while (failed_task == 0) {
+        // Отчеты о ходе и heartbeat пропускаются
+        channel.receive(dispatcher, envelope);
+    }
+    EXPECT_EQ(7u, failed_task);
+
+    channel.shutdown();
+    client.join();
+    std::filesystem::remove_all(directory);
+}
+#endif
+
+#if defined(__linux__)
+// Тест общей памяти: кадры больше кольца проходят по частям в обе стороны, имя сегмента
+// удаляется после подключения, закрытие одной стороной завершает чтение другой
+TEST_F(IntegrationTest, SharedMemoryTransport) {
+    std::unique_ptr<SharedMemoryTransport> client_transport = SharedMemoryTransport::create(4096);
+    std::unique_ptr<SharedMemoryTransport> server_transport = SharedMemoryTransport::open(client_transport->name());
+    EXPECT_EQ(4096u, server_transport->ring_size());
+    EXPECT_THROW(SharedMemoryTransport::open(client_transport->name()), std::runtime_error);
+    EXPECT_THROW(SharedMemoryTransport::create(1000), std::invalid_argument);
+    EXPECT_THROW(SharedMemoryTransport::open("/integration-test"), std::invalid_argument);
+    EXPECT_THROW(SharedMemoryTransport::open("/integrator-1-x"), std::invalid_argument);
+
+    // Сегмент с некорректным заголовком отвергается, и его имя не удаляется
+    const std::string forged = "/integrator-" + std::to_string(::getpid()) + "-999999";
+    const int forged_fd = ::shm_open(forged.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    ASSERT_GE(forged_fd, 0);
+    ASSERT_EQ(0, ::ftruncate(forged_fd, 3 * 4096 * 4));
+    ::close(forged_fd);
+    EXPECT_THROW(SharedMemoryTransport::open(forged), std::runtime_error);
+    EXPECT_EQ(0, ::shm_unlink(forged.c_str()));
+
+    boost::asio::io_context io_context;
+    boost::asio::local::stream_protocol::socket client_local(io_context);
+    boost::asio::local::stream_protocol::socket server_local(io_context);
+    boost::asio::local::connect_pair(client_local, server_local);
+    MessageSocket client_socket(std::move(client_local));
+    MessageSocket server_socket(std::move(server_local));
+    MessageChannel client(client_socket);
+    MessageChannel server(server_socket);
+    client.use_shared_memory(std::move(client_transport));
+    server.use_shared_memory(std::move(server_transport));
+    EXPECT_TRUE(client.uses_shared_memory());
+
+    std::vector<IntegrationTask> tasks(64);
+    std::vector<IntegrationResult> results;
+    for (size_t id = 0; id < tasks.size(); ++id) {
+        tasks[id].task_id = id;
+        tasks[id].upper_bound = 3.0 + id;
+        results.push_back(IntegrationResult{0.5 * id, id, 0.0, ExactSum(0.5 * id)});
+    }
+    const size_t batches = 20;
+    std::thread sender([&]() {
+        for (size_t i = 0; i < batches; ++i) {
+            server.send(wire::make_envelope(wire::MessageType::TaskBatch, i), tasks);
+        }
+    });
+    std::thread replier([&]() {
+        for (size_t i = 0; i < batches; ++i) {
+            client.send(wire::make_envelope(wire::MessageType::ResultBatch, i), results);
+        }
+    });
+    for (size_t i = 0; i < batches; ++i) {
+        std::vector<IntegrationTask> received_tasks;
+        const wire::Envelope envelope = client.receive(wire::MessageType::TaskBatch, received_tasks);
+        EXPECT_EQ(i, envelope.correlation_id);
+        ASSERT_EQ(tasks.size(), received_tasks.size());
+        EXPECT_EQ(66.0, received_tasks.back().upper_bound);
+        std::vector<IntegrationResult> received_results;
+        server.receive(wire::MessageType::ResultBatch, received_results);
+        ASSERT_EQ(results.size(), received_results.size());
+        EXPECT_TRUE(received_results.back().sum == ExactSum(31.5));
+    }
+    sender.join();
+    replier.join();
+
+    server.shutdown();
+    size_t value = 0;
+    EXPECT_THROW(client.receive(wire::MessageType::Welcome, value), std::runtime_error);
+}
+#endif
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();